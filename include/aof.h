@@ -5,21 +5,49 @@
 #include <vector>
 #include <thread>
 #include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <string_view>
+#include <functional>
 #include <unistd.h>
 #include <sys/wait.h>
 #include "storage.h"
 
+class CommandHandler;
+
+// Append-only file with group commit
+//
+// The event loops append write commands to their own in-memory buffer
+// (the bytes the client sent, or feed() to encode one) and hand it over
+// once per iteration, before that iteration's
+// replies are sent (flush): one write() per batch. A writer thread does
+// the fsyncs, each covering every batch written before it started:
+//   always:   flush() returns once its batch is on disk. Loops flushing at
+//             the same time share one fsync
+//   everysec: fsync once a second if anything was written
+//   no:       the OS decides
 class AOF {
+public:
+    enum class FsyncPolicy { Always, EverySec, No };
+
 private:
     std::string filename;
-    FILE* aofFile;
+    int fd;
     bool enabled;
-    std::string syncMode;  // "always", "everysec", "no"
+    FsyncPolicy policy;
+    bool loadTruncated = true;  // Replay cuts a torn last command off the file
+    std::string buffer;  // log()'s batch
     
-    // For everysec mode - background fsync thread
-    std::thread fsyncThread;
-    std::atomic<bool> running{false};
-    void fsyncWorker();  // Background thread function
+    // Group commit state, under mutex. Batches are numbered in write order
+    std::mutex mutex;
+    std::condition_variable writerWake;  // Writer: a batch to fsync (always), or stop
+    std::condition_variable synced;      // Flushers: syncedSeq advanced
+    uint64_t writtenSeq = 0;             // Batches written
+    uint64_t syncedSeq = 0;              // Batches covered by a finished fsync
+    bool syncing = false;                // fsync in progress (fd must stay open)
+    bool stopping = false;
+    std::thread writerThread;
+    void writerLoop();
     
     // For BGREWRITEAOF - fork-based rewrite
     pid_t rewriteChildPid;
@@ -30,9 +58,34 @@ public:
         const std::string& sync = "everysec");
     ~AOF();
     
+    // "always", "everysec" or "no"; false if unknown. Before the event loops start
+    bool setSyncMode(const std::string& sync);
+    
     // Main operations
+    // Encode a command into buf, an event loop's AOF buffer
+    static void feed(std::string& buf, const std::vector<std::string_view>& command);
+    // Write buf to the file and clear it; in always mode, wait for the fsync
+    void flush(std::string& buf);
+    // feed + flush through the AOF's own buffer (single-threaded callers;
+    // commands without CMD_WRITE are skipped)
     void log(const std::vector<std::string>& command);
-    void replay(Storage& storage);
+    // Rebuild the keyspace: the file is mmapped, parsed in place and its
+    // commands run through the command table, as a client whose replies
+    // are discarded. TTLs are logged as deadlines (SET PXAT, PEXPIREAT), so
+    // keys whose deadline has passed are not loaded. A torn last command
+    // (crash mid-write) is reported and cut off the file, unless
+    // setLoadTruncated(false). Returns false if the file can't be loaded:
+    // corrupt, or a torn tail that may not be cut. from: skip the file's
+    // first bytes (already loaded from a snapshot, see position())
+    bool replay(Storage& storage, uint64_t from = 0);
+    // Sharded keyspace: each command runs on handlerFor(its key) (DEL per key)
+    bool replay(const std::function<CommandHandler&(std::string_view key)>& handlerFor, uint64_t from = 0);
+    void setLoadTruncated(bool allow) { loadTruncated = allow; }
+    
+    // The open file's inode and size: a snapshot taken now contains the
+    // first size bytes of this file (flush the loop's batch first). False
+    // if the AOF isn't open
+    bool position(uint64_t& inode, uint64_t& size);
     
     // Rewrite (compaction)
     bool bgRewriteAOF(Storage& storage);
@@ -43,4 +96,4 @@ public:
     void sync();  // Manual fsync
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -3,9 +3,11 @@
 
 #include "resp_value.h"
 #include "resp_encoder.h"
+#include "output_buffer.h"
 #include "storage.h"
 #include <string>
-#include <unordered_map>
+#include <string_view>
+#include <vector>
 #include <cstdint>
 using namespace std;
 
@@ -18,42 +20,89 @@ enum CommandFlags : uint32_t {
 
 class CommandHandler;
 
-// Member function pointer type
-typedef string (CommandHandler::*CommandHandlerFunc)(const RespValue&);
+// A command's arguments (name first) as views, valid while it runs. A span
+// over the caller's array: C++17 has no std::span
+class CommandArgs {
+public:
+    CommandArgs(const string_view* args, size_t count) : args(args), count(count) {}
+    size_t size() const { return count; }
+    string_view operator[](size_t i) const { return args[i]; }
+    const string_view* begin() const { return args; }
+    const string_view* end() const { return args + count; }
+
+private:
+    const string_view* args;
+    size_t count;
+};
+
+// Member function pointer type (handlers append their reply to out)
+typedef void (CommandHandler::*CommandHandlerFunc)(CommandArgs args, OutputBuffer& out);
 
 // Command metadata
 struct CommandInfo {
+    string_view name;            // Upper case
     CommandHandlerFunc handler;  // Function pointer to handler
     int arity;                   // -N = at least N args, N = exactly N args
     uint32_t flags;              // Command flags
 };
 
+// Case-insensitive match of an argument against an upper-case name
+inline bool equalsIgnoreCase(string_view arg, string_view upper) {
+    if (arg.size() != upper.size()) return false;
+    for (size_t i = 0; i < arg.size(); i++) {
+        char c = arg[i];
+        if (c >= 'a' && c <= 'z') c -= 'a' - 'A';
+        if (c != upper[i]) return false;
+    }
+    return true;
+}
+
 class CommandHandler {
 private:
     Storage& storage;
-    RESPEncoder encoder;
-    unordered_map<string, CommandInfo> commands;  // Command table
-    
-    // Initialize command table
-    void initCommandTable();
+    vector<string_view> argv;  // Views into a RespValue command (reused)
+    OutputBuffer scratch;      // Replies returned as strings are built here
+    uint64_t dirty = 0;        // Changes made to the keyspace (Redis server.dirty)
+    string rewritten;          // The last command as it should be propagated, if not as received
     
     // Helper methods
-    static void toUpperCase(string& str);
-    static bool parseInteger(const string& str, int64_t& out);
+    static bool parseInteger(string_view str, int64_t& out);
+    void expireNow(string_view key, OutputBuffer& out);
+    void propagateDel(string_view key);  // rewritten = DEL key
     
 public:
     CommandHandler(Storage& store);
-    string handleCommand(RespValue cmd);
+    
+    // Command table entry for a name in any case; nullptr if unknown.
+    // The table is built at compile time (see command_handler.cpp)
+    static const CommandInfo* lookupCommand(string_view name);
+    
+    // Keyspace changes made by commands so far: a command that leaves it
+    // unchanged (failed, or nothing to do) needs no AOF entry
+    uint64_t dirtyCount() const { return dirty; }
+    
+    // The last command encoded as it must be logged, when the received form
+    // would replay differently: relative TTLs (SET EX/PX, EXPIRE) become
+    // absolute deadlines (SET PXAT, PEXPIREAT), and a deadline already
+    // passed becomes DEL. Empty = log it as received
+    string_view rewrittenCommand() const { return rewritten; }
+    
+    // Run a command, appending its reply to out (the client's output buffer)
+    void handleCommand(CommandArgs args, OutputBuffer& out);
+    void handleCommand(const RespValue& cmd, OutputBuffer& out);
+    // Same, returning the reply (replies that go to another shard, tests)
+    string handleCommand(const RespValue& cmd);
     
     // Command handlers (all take same signature for function pointer)
-    string handlePing(const RespValue& cmd);
-    string handleSet(const RespValue& cmd);
-    string handleGet(const RespValue& cmd);
-    string handleTTL(const RespValue& cmd);
-    string handleDel(const RespValue& cmd);
-    string handleExpire(const RespValue& cmd);
-    string handleIncr(const RespValue& cmd);
-    string handleInfo(const RespValue& cmd);
+    void handlePing(CommandArgs args, OutputBuffer& out);
+    void handleSet(CommandArgs args, OutputBuffer& out);
+    void handleGet(CommandArgs args, OutputBuffer& out);
+    void handleTTL(CommandArgs args, OutputBuffer& out);
+    void handleDel(CommandArgs args, OutputBuffer& out);
+    void handleExpire(CommandArgs args, OutputBuffer& out);
+    void handlePexpireat(CommandArgs args, OutputBuffer& out);
+    void handleIncr(CommandArgs args, OutputBuffer& out);
+    void handleInfo(CommandArgs args, OutputBuffer& out);
 };
 
 #endif
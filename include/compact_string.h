@@ -0,0 +1,89 @@
+#ifndef COMPACT_STRING_H
+#define COMPACT_STRING_H
+
+#include <string>
+#include <string_view>
+#include <ostream>
+#include <cstring>
+#include <cstdint>
+using namespace std;
+
+// 16-byte immutable string for hash table keys (std::string is 32 bytes)
+//
+// Up to 15 bytes are stored inline: bytes 0..14 hold the data and byte 15
+// the length. Longer strings live on the heap: bytes 0..7 hold the pointer,
+// bytes 8..11 the length and byte 15 is HEAP_TAG.
+class CompactString {
+    static const size_t INLINE_MAX = 15;
+    static const uint8_t HEAP_TAG = 0xFF;
+
+    alignas(8) char buf[16];
+
+    uint8_t tag() const { return (uint8_t)buf[15]; }
+    char* heapPtr() const { char* p; memcpy(&p, buf, sizeof(p)); return p; }
+    uint32_t heapLen() const { uint32_t n; memcpy(&n, buf + 8, sizeof(n)); return n; }
+
+    void assign(string_view s) {
+        if (s.size() <= INLINE_MAX) {
+            memcpy(buf, s.data(), s.size());
+            buf[15] = (char)s.size();
+            return;
+        }
+        char* p = new char[s.size()];
+        memcpy(p, s.data(), s.size());
+        uint32_t n = (uint32_t)s.size();
+        memcpy(buf, &p, sizeof(p));
+        memcpy(buf + 8, &n, sizeof(n));
+        buf[15] = (char)HEAP_TAG;
+    }
+
+    void release() {
+        if (!isInline()) delete[] heapPtr();
+        buf[15] = 0;
+    }
+
+public:
+    CompactString() { buf[15] = 0; }
+    CompactString(string_view s) { assign(s); }
+    CompactString(const string& s) { assign(s); }
+    CompactString(const char* s) { assign(s); }
+    CompactString(const CompactString& o) { assign(o); }
+    CompactString(CompactString&& o) noexcept {
+        memcpy(buf, o.buf, sizeof(buf));
+        o.buf[15] = 0;  // Source no longer owns the heap buffer
+    }
+    ~CompactString() { release(); }
+
+    CompactString& operator=(const CompactString& o) {
+        if (this != &o) { CompactString tmp(o); *this = std::move(tmp); }
+        return *this;
+    }
+    CompactString& operator=(CompactString&& o) noexcept {
+        if (this != &o) {
+            release();
+            memcpy(buf, o.buf, sizeof(buf));
+            o.buf[15] = 0;
+        }
+        return *this;
+    }
+
+    bool isInline() const { return tag() != HEAP_TAG; }
+    size_t size() const { return isInline() ? tag() : heapLen(); }
+    const char* data() const { return isInline() ? buf : heapPtr(); }
+
+    operator string_view() const { return string_view(data(), size()); }
+    operator string() const { return string(data(), size()); }
+    string str() const { return string(data(), size()); }
+
+    bool operator==(string_view s) const { return string_view(*this) == s; }
+    bool operator!=(string_view s) const { return !(*this == s); }
+    bool operator==(const string& s) const { return string_view(*this) == s; }
+    bool operator==(const char* s) const { return string_view(*this) == s; }
+    bool operator<(const CompactString& o) const { return string_view(*this) < string_view(o); }
+};
+
+inline ostream& operator<<(ostream& os, const CompactString& s) {
+    return os << string_view(s);
+}
+
+#endif
@@ -0,0 +1,135 @@
+#ifndef CONNECTION_H
+#define CONNECTION_H
+
+#include "resp_parser.h"
+#include "output_buffer.h"
+#include "command_handler.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+using namespace std;
+
+// Read sizes and limits (Redis: PROTO_IOBUF_LEN, client-query-buffer-limit)
+const size_t READ_CHUNK = 16 * 1024;
+const size_t QUERY_BUFFER_LIMIT = 1024ULL * 1024 * 1024;
+
+enum class ReadResult {
+    Drained,  // Socket empty (EAGAIN); everything received is in the parser
+    Closed,   // Peer closed its side (FIN): run what it sent, reply, then close
+    Failed,   // The read failed (e.g. reset): close now
+    TooBig    // Unprocessed input exceeds the query buffer limit
+};
+
+// Reply to a command that runs on another shard (--shards). Replies leave
+// in command order, so later replies queue behind it until it arrives
+struct PendingReply {
+    string reply;
+    int waiting = 0;           // Shard replies still expected
+    bool sumIntegers = false;  // Split multi-key command (DEL): reply with the sum
+    int64_t sum = 0;
+};
+
+// A parsed command, waiting to run. Its arguments stay where they were
+// received, in the query buffer: they are offsets into it, not copies
+struct ParsedCommand {
+    uint32_t firstArg;   // Its arguments: Connection::argSpans[firstArg, firstArg + argc)
+    uint32_t argc;
+    size_t frameOffset;  // Write commands: the RESP frame as received, for the AOF
+    size_t frameLen;     // 0: not a write command, or sent inline
+};
+
+// Per-connection state. The event loop registers the Connection pointer as
+// epoll_event.data.ptr, so dispatching an event is one dereference
+struct Connection {
+    int fd = -1;
+    uint64_t id = 0;         // Unique per event loop (fds get reused)
+    RespParser parser;       // Query buffer + parse state
+    OutputBuffer reply;
+    bool wantWrite = false;  // Registered for EPOLLOUT (replies pending)
+    bool queuedWrite = false; // In this iteration's write batch
+    bool queuedRead = false;  // In this iteration's readable batch (io_uring)
+    bool recvArmed = false;   // io_uring: multishot recv in flight
+    bool sendInFlight = false; // io_uring: sendmsg in flight
+    bool closeAfterReply = false; // Peer closed its side: close once replies are out
+
+    // Sharded mode: replies from the first still-outstanding cross-shard
+    // command on; pendingReplies[i] is reply slot firstPendingSlot + i
+    vector<PendingReply> pendingReplies;
+    uint64_t firstPendingSlot = 0;
+
+    // Stats
+    int64_t createdMs = 0;
+    int64_t lastInteractionMs = 0;
+    uint64_t bytesRead = 0;
+    uint64_t commandsProcessed = 0;
+
+    // Results of the read/write phases, which may run on an I/O thread;
+    // the main thread acts on them
+    ReadResult readResult = ReadResult::Drained;
+    ParseStatus parseStatus = ParseStatus::Incomplete;
+    vector<ParsedCommand> commands;          // Parsed, waiting to run
+    vector<pair<size_t, size_t>> argSpans;   // (offset, length) in the query buffer
+    OutputBuffer::FlushResult flushResult = OutputBuffer::FlushResult::Done;
+
+    // Command i's arguments as views of the query buffer, built in argv
+    // (the caller's, reused). Valid until the next read into the buffer,
+    // so every parsed command runs before it
+    CommandArgs args(size_t i, vector<string_view>& argv) const;
+    // Command i's RESP bytes as received if it is a write command, else empty
+    string_view frame(size_t i) const {
+        return parser.bytesAt(commands[i].frameOffset, commands[i].frameLen);
+    }
+
+    void clearCommands() {
+        commands.clear();
+        argSpans.clear();
+        // Give back the memory of a huge pipeline once it has run
+        if (argSpans.capacity() > 64 * 1024) {
+            vector<ParsedCommand>().swap(commands);
+            vector<pair<size_t, size_t>>().swap(argSpans);
+        }
+    }
+};
+
+// Open connections, indexed by fd (the kernel hands out the lowest free
+// fd, so the table stays dense and never needs a lookup structure)
+class ConnectionTable {
+public:
+    Connection* add(int fd);
+    void remove(int fd);
+    Connection* get(int fd) const {
+        return fd >= 0 && (size_t)fd < slots.size() ? slots[fd].get() : nullptr;
+    }
+    size_t size() const { return count; }
+
+    template <typename F>
+    void forEach(F f) const {
+        for (const auto& conn : slots) {
+            if (conn) f(*conn);
+        }
+    }
+
+private:
+    vector<unique_ptr<Connection>> slots;
+    size_t count = 0;
+};
+
+// Read everything available on a non-blocking socket straight into the
+// parser's input buffer. Sockets are registered edge-triggered, so a
+// read that stops before EAGAIN would leave pipelined commands unread
+// until the client happens to send more
+ReadResult readQuery(int fd, RespParser& parser, size_t limit = QUERY_BUFFER_LIMIT);
+
+// Read phase for one connection: readQuery() and parse every complete
+// command into conn.commands (argument offsets, no copies), including
+// those that arrived along with the peer's FIN.
+// Touches nothing but conn, so it is safe on an I/O thread
+void readAndParse(Connection& conn, size_t limit = QUERY_BUFFER_LIMIT);
+
+// Parse every complete command already in the query buffer into
+// conn.commands (the io_uring backend receives into the buffer itself)
+void parseCommands(Connection& conn);
+
+#endif
@@ -0,0 +1,439 @@
+#ifndef DICT_H
+#define DICT_H
+
+#include <string>
+#include <string_view>
+#include <utility>
+#include <iterator>
+#include <functional>
+#include <chrono>
+#include <new>
+#include <cstdint>
+#include <cstddef>
+#include "compact_string.h"
+using namespace std;
+
+// Fast non-cryptographic PRNG (xorshift64*) for sampling keys
+// Much cheaper than rand() and has no global state
+struct FastRandom {
+    uint64_t state;
+
+    explicit FastRandom(uint64_t seed = 0x9E3779B97F4A7C15ULL) : state(seed ? seed : 1) {}
+
+    uint64_t next() {
+        state ^= state >> 12;
+        state ^= state << 25;
+        state ^= state >> 27;
+        return state * 0x2545F4914F6CDD1DULL;
+    }
+
+    // Uniform value in [0, range) without modulo (Lemire's multiply-shift)
+    uint64_t nextBelow(uint64_t range) {
+        return (uint64_t)(((unsigned __int128)next() * range) >> 64);
+    }
+};
+
+// Open-addressing hash table with incremental rehashing (Redis dict-inspired)
+//
+// - Linear probing over a flat slot array. Each slot caches the full 64-bit
+//   hash in a separate array, so a probe compares 8-byte hashes sequentially
+//   and only touches the key string on a hash match.
+// - Deletion uses backward-shift (no tombstones), so probe chains stay short.
+// - Growing/shrinking allocates a second table and migrates a few slots on
+//   every operation (plus rehashMilliseconds() from the server cron), so a
+//   resize never stalls the event loop for O(n).
+//
+// The API mirrors the subset of std::map that Storage uses (find/end/erase/
+// operator[]/iteration with ->first/->second). Keys are CompactStrings, so a
+// slot holding a short key costs 16 bytes plus the value.
+template <typename V>
+class Dict {
+public:
+    typedef pair<CompactString, V> Entry;
+
+private:
+    static const size_t INITIAL_CAPACITY = 16;
+    static const int REHASH_EMPTY_VISITS = 10;  // Max empty slots per migrated entry
+
+    struct Table {
+        uint64_t* hashes = nullptr;  // 0 = empty slot
+        Entry* entries = nullptr;    // Constructed only where hashes[i] != 0
+        size_t capacity = 0;         // Power of two
+        size_t mask = 0;
+        size_t used = 0;
+    };
+
+    Table tables[2];        // tables[1] only used while rehashing
+    long rehashIdx = -1;    // Slots of tables[0] migrated so far (-1 = not rehashing)
+    size_t rehashStart = 0; // Empty slot where migration began (see rehash())
+
+    static uint64_t hashKey(string_view key) {
+        uint64_t h = std::hash<string_view>{}(key);
+        return h == 0 ? 1 : h;  // 0 marks empty slots
+    }
+
+    static void allocTable(Table& t, size_t capacity) {
+        t.hashes = new uint64_t[capacity]();
+        t.entries = static_cast<Entry*>(::operator new(capacity * sizeof(Entry)));
+        t.capacity = capacity;
+        t.mask = capacity - 1;
+        t.used = 0;
+    }
+
+    static void freeTable(Table& t) {
+        for (size_t i = 0; i < t.capacity; i++) {
+            if (t.hashes[i] != 0) t.entries[i].~Entry();
+        }
+        delete[] t.hashes;
+        ::operator delete(t.entries);
+        t = Table();
+    }
+
+    // Find slot index holding key, or -1
+    static long lookupSlot(const Table& t, uint64_t h, string_view key) {
+        if (t.used == 0) return -1;
+        size_t i = h & t.mask;
+        while (t.hashes[i] != 0) {
+            if (t.hashes[i] == h && t.entries[i].first == key) return (long)i;
+            i = (i + 1) & t.mask;
+        }
+        return -1;
+    }
+
+    // Place an entry known to be absent into the first free slot of its probe chain
+    static size_t placeEntry(Table& t, uint64_t h, Entry&& entry) {
+        size_t i = h & t.mask;
+        while (t.hashes[i] != 0) i = (i + 1) & t.mask;
+        new (&t.entries[i]) Entry(std::move(entry));
+        t.hashes[i] = h;
+        t.used++;
+        return i;
+    }
+
+    // Remove slot i and backward-shift following entries into the hole
+    static void removeSlot(Table& t, size_t i) {
+        t.entries[i].~Entry();
+        t.hashes[i] = 0;
+        t.used--;
+
+        size_t hole = i;
+        size_t j = (i + 1) & t.mask;
+        while (t.hashes[j] != 0) {
+            size_t home = t.hashes[j] & t.mask;
+            // Entry at j may move into the hole if the hole lies in [home, j)
+            if (((j - hole) & t.mask) <= ((j - home) & t.mask)) {
+                new (&t.entries[hole]) Entry(std::move(t.entries[j]));
+                t.entries[j].~Entry();
+                t.hashes[hole] = t.hashes[j];
+                t.hashes[j] = 0;
+                hole = j;
+            }
+            j = (j + 1) & t.mask;
+        }
+    }
+
+    // Visit the entries whose home slot is b. Linear probing with backward-
+    // shift deletes keeps each one between its home and the next empty slot
+    template <typename F>
+    static void scanSlot(const Table& t, size_t b, F& fn) {
+        for (size_t i = b; t.hashes[i] != 0; i = (i + 1) & t.mask) {
+            if ((t.hashes[i] & t.mask) == b) fn(t.entries[i]);
+        }
+    }
+
+    static uint64_t reverseBits(uint64_t v) {
+        v = ((v >> 1) & 0x5555555555555555ULL) | ((v & 0x5555555555555555ULL) << 1);
+        v = ((v >> 2) & 0x3333333333333333ULL) | ((v & 0x3333333333333333ULL) << 2);
+        v = ((v >> 4) & 0x0F0F0F0F0F0F0F0FULL) | ((v & 0x0F0F0F0F0F0F0F0FULL) << 4);
+        return __builtin_bswap64(v);
+    }
+
+    // Next cursor: increment the bits above mask, reversed (Redis dictScan)
+    static uint64_t nextCursor(uint64_t cursor, size_t mask) {
+        cursor |= ~(uint64_t)mask;
+        return reverseBits(reverseBits(cursor) + 1);
+    }
+
+    static size_t nextPowerOfTwo(size_t n) {
+        size_t cap = INITIAL_CAPACITY;
+        while (cap < n) cap <<= 1;
+        return cap;
+    }
+
+    void startRehash(size_t newCapacity) {
+        allocTable(tables[1], newCapacity);
+        rehashIdx = 0;
+
+        // Begin at an empty slot so clusters are always migrated whole
+        // (tables[0] is at most 75% full, so one exists)
+        rehashStart = 0;
+        while (tables[0].hashes[rehashStart] != 0) rehashStart++;
+    }
+
+    void finishRehashIfDone() {
+        if (rehashIdx >= (long)tables[0].capacity || tables[0].used == 0) {
+            freeTable(tables[0]);
+            tables[0] = tables[1];
+            tables[1] = Table();
+            rehashIdx = -1;
+        }
+    }
+
+    // Grow before an insert (or finish a rehash whose target is nearly full)
+    void expandIfNeeded() {
+        if (isRehashing()) {
+            // Inserts go to tables[1]; never let it exceed 90% load
+            if ((tables[1].used + 1) * 10 <= tables[1].capacity * 9) return;
+            while (isRehashing()) rehash(1000);
+        }
+        if (tables[0].capacity == 0) {
+            allocTable(tables[0], INITIAL_CAPACITY);
+        } else if ((tables[0].used + 1) * 4 > tables[0].capacity * 3) {
+            startRehash(tables[0].capacity * 2);  // Load factor > 0.75
+        }
+    }
+
+    // Shrink after a delete when the table is mostly empty
+    void shrinkIfNeeded() {
+        if (isRehashing() || tables[0].capacity <= INITIAL_CAPACITY) return;
+        if (tables[0].used * 8 < tables[0].capacity) {
+            startRehash(nextPowerOfTwo(tables[0].used * 2));
+        }
+    }
+
+    template <bool Const>
+    class Iter {
+        friend class Dict;
+        typedef typename conditional<Const, const Dict*, Dict*>::type DictPtr;
+        DictPtr dict;
+        int table;
+        size_t idx;
+
+        void skipEmpty() {
+            while (table < 2) {
+                const Table& t = dict->tables[table];
+                while (idx < t.capacity && t.hashes[idx] == 0) idx++;
+                if (idx < t.capacity) return;
+                table++;
+                idx = 0;
+            }
+        }
+
+    public:
+        typedef forward_iterator_tag iterator_category;
+        typedef typename conditional<Const, const Entry, Entry>::type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef value_type* pointer;
+        typedef value_type& reference;
+
+        Iter(DictPtr d = nullptr, int tbl = 2, size_t i = 0) : dict(d), table(tbl), idx(i) {
+            if (dict) skipEmpty();
+        }
+        operator Iter<true>() const { return Iter<true>(dict, table, idx); }
+
+        reference operator*() const { return dict->tables[table].entries[idx]; }
+        pointer operator->() const { return &dict->tables[table].entries[idx]; }
+        Iter& operator++() { idx++; skipEmpty(); return *this; }
+        Iter operator++(int) { Iter tmp = *this; ++*this; return tmp; }
+        uint64_t hash() const { return dict->tables[table].hashes[idx]; }  // Stored key hash
+        bool operator==(const Iter& o) const { return table == o.table && idx == o.idx; }
+        bool operator!=(const Iter& o) const { return !(*this == o); }
+    };
+
+public:
+    typedef Iter<false> iterator;
+    typedef Iter<true> const_iterator;
+
+private:
+    iterator findHashed(uint64_t h, string_view key) {
+        for (int t = 0; t <= (isRehashing() ? 1 : 0); t++) {
+            long slot = lookupSlot(tables[t], h, key);
+            if (slot != -1) return iterator(this, t, (size_t)slot);
+        }
+        return end();
+    }
+
+public:
+
+    Dict() = default;
+    ~Dict() { clear(); }
+    Dict(const Dict&) = delete;
+    Dict& operator=(const Dict&) = delete;
+
+    size_t size() const { return tables[0].used + tables[1].used; }
+    bool empty() const { return size() == 0; }
+    bool isRehashing() const { return rehashIdx != -1; }
+    size_t capacity() const { return tables[0].capacity + tables[1].capacity; }
+
+    // Bytes allocated for slot arrays (excludes heap memory owned by entries)
+    size_t memoryUsage() const { return capacity() * (sizeof(Entry) + sizeof(uint64_t)); }
+
+    iterator begin() { return iterator(this, 0, 0); }
+    iterator end() { return iterator(); }
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(); }
+
+    // Lookup (performs one incremental rehash step when rehashing)
+    iterator find(string_view key) {
+        if (isRehashing()) rehash(1);
+        return findHashed(hashKey(key), key);
+    }
+
+    // Lookup with the key's hash already known (e.g. it.hash() from another
+    // Dict holding the same key), saving a rehash of the key
+    iterator find(string_view key, uint64_t h) {
+        if (isRehashing()) rehash(1);
+        return findHashed(h, key);
+    }
+
+    // Find key or insert a default-constructed value (second = true if inserted)
+    pair<iterator, bool> try_emplace(string_view key) {
+        if (isRehashing()) rehash(1);
+        uint64_t h = hashKey(key);
+        iterator it = findHashed(h, key);
+        if (it != end()) return {it, false};
+
+        expandIfNeeded();
+        int t = isRehashing() ? 1 : 0;
+        size_t slot = placeEntry(tables[t], h, Entry(CompactString(key), V()));
+        return {iterator(this, t, slot), true};
+    }
+
+    // Get existing value or insert a default-constructed one
+    V& operator[](string_view key) {
+        return try_emplace(key).first->second;
+    }
+
+    // Uniformly random entry in O(1) expected time (end() if empty)
+    // Rejection-samples slots across both tables; shrinking keeps the load
+    // factor >= 1/8, so this takes at most ~8 probes on average.
+    iterator randomEntry(FastRandom& rng) {
+        if (empty()) return end();
+        size_t total = tables[0].capacity + tables[1].capacity;
+        for (int attempt = 0; attempt < 1000; attempt++) {
+            size_t r = rng.nextBelow(total);
+            int t = r < tables[0].capacity ? 0 : 1;
+            size_t slot = t == 0 ? r : r - tables[0].capacity;
+            if (tables[t].hashes[slot] != 0) return iterator(this, t, slot);
+        }
+        return begin();  // Pathologically sparse table: fall back to first entry
+    }
+
+    // Resumable walk (Redis dictScan): call with cursor 0, then with each
+    // returned cursor until it comes back 0. Every entry present for the
+    // whole walk is visited at least once - an entry may be visited twice -
+    // even if the table is resized, rehashed or entries move in between
+    // calls. Slots are visited by home (hash & mask), in reverse-bit order
+    // so a grown or shrunk table resumes at the matching slots. fn must not
+    // modify the Dict
+    template <typename F>
+    uint64_t scan(uint64_t cursor, F fn) const {
+        if (empty()) return 0;
+        if (!isRehashing()) {
+            scanSlot(tables[0], cursor & tables[0].mask, fn);
+            return nextCursor(cursor, tables[0].mask);
+        }
+        // Mid-rehash: the smaller table's slot, then every slot of the
+        // larger one that maps onto it
+        const Table* small = &tables[0];
+        const Table* large = &tables[1];
+        if (small->capacity > large->capacity) swap(small, large);
+        scanSlot(*small, cursor & small->mask, fn);
+        do {
+            scanSlot(*large, cursor & large->mask, fn);
+            cursor = nextCursor(cursor, large->mask);
+        } while (cursor & (small->mask ^ large->mask));
+        return cursor;
+    }
+
+    // Erase by key (returns true if removed)
+    bool erase(string_view key) {
+        iterator it = find(key);
+        if (it == end()) return false;
+        erase(it);
+        return true;
+    }
+
+    // Erase by iterator; returns iterator to the next unvisited entry.
+    // Never rehashes, so it is safe to use while iterating.
+    iterator erase(iterator it) {
+        removeSlot(tables[it.table], it.idx);
+        if (!isRehashing()) shrinkIfNeeded();
+        if (isRehashing() && it.table == 0 && tables[0].used == 0) {
+            // Old table drained: promote without invalidating the caller's walk
+            // more than necessary (continue from the start of the new table)
+            finishRehashIfDone();
+            return iterator(this, 0, 0);
+        }
+        return iterator(this, it.table, it.idx);
+    }
+
+    // Size the table for n entries up front (Redis dictExpand on an RDB
+    // RESIZEDB hint), so inserting them never rehashes. Matters when keys
+    // arrive in another table's slot order (a snapshot): a smaller table
+    // growing under them gets each sweep of the source piled onto the same
+    // stretch of slots, and linear probing through that goes quadratic
+    void reserve(size_t n) {
+        size_t capacity = nextPowerOfTwo((n + 1) * 4 / 3 + 1);
+        while (isRehashing()) rehash(1000);
+        if (capacity <= tables[0].capacity) return;
+        if (empty()) {
+            clear();
+            allocTable(tables[0], capacity);
+            return;
+        }
+        startRehash(capacity);
+        while (isRehashing()) rehash(1000);
+    }
+
+    void clear() {
+        if (tables[0].capacity) freeTable(tables[0]);
+        if (tables[1].capacity) freeTable(tables[1]);
+        rehashIdx = -1;
+    }
+
+    // Migrate at least n entries (whole clusters) from tables[0] to tables[1]
+    // Returns true if more rehashing remains
+    //
+    // Walking from an empty slot and moving entire clusters means every entry
+    // left in tables[0] still has an intact probe chain, so lookups and
+    // backward-shift deletes there stay correct mid-rehash without tombstones.
+    bool rehash(int n) {
+        if (!isRehashing()) return false;
+        int emptyVisits = n * REHASH_EMPTY_VISITS;
+        Table& from = tables[0];
+        Table& to = tables[1];
+
+        while (n > 0 && rehashIdx < (long)from.capacity && from.used > 0) {
+            size_t i = (rehashStart + rehashIdx) & from.mask;
+            if (from.hashes[i] == 0) {
+                rehashIdx++;
+                if (--emptyVisits == 0) break;
+                continue;
+            }
+            while (from.hashes[i] != 0) {
+                placeEntry(to, from.hashes[i], std::move(from.entries[i]));
+                from.entries[i].~Entry();
+                from.hashes[i] = 0;
+                from.used--;
+                rehashIdx++;
+                n--;
+                i = (i + 1) & from.mask;
+            }
+        }
+
+        finishRehashIfDone();
+        return isRehashing();
+    }
+
+    // Rehash for roughly ms milliseconds (called from the server cron)
+    void rehashMilliseconds(int ms) {
+        auto start = chrono::steady_clock::now();
+        auto budget = chrono::milliseconds(ms);
+        while (rehash(100)) {
+            if (chrono::steady_clock::now() - start >= budget) break;
+        }
+    }
+};
+
+#endif
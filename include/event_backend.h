@@ -0,0 +1,126 @@
+#ifndef EVENT_BACKEND_H
+#define EVENT_BACKEND_H
+
+#include "connection.h"
+#include "io_threads.h"
+#include "uring.h"
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+// What one event-loop iteration has to act on
+struct LoopEvents {
+    vector<int> accepted;          // New client sockets, non-blocking
+    vector<Connection*> readable;  // Read and parsed: check readResult, parseStatus, commands
+    vector<Connection*> writable;  // Socket takes more replies again
+    bool inboxReady = false;       // Shard inbox signalled
+
+    void clear() {
+        accepted.clear();
+        readable.clear();
+        writable.clear();
+        inboxReady = false;
+    }
+};
+
+// Network side of the event loop. The loop runs the commands of the
+// readable connections and hands the ones with replies to flush(); a
+// backend only moves bytes, so both share all of the command dispatch
+class EventBackend {
+public:
+    virtual ~EventBackend() = default;
+    virtual const char* name() const = 0;
+
+    // Listening socket, and the shard inbox eventfd (-1 if none)
+    virtual void watch(int listenFd, int inboxFd) = 0;
+    virtual void addClient(Connection* conn) = 0;
+    virtual void removeClient(Connection* conn) = 0;  // Before its fd is closed
+
+    // Wait up to timeoutMs for events. False on a fatal error
+    virtual bool poll(LoopEvents& events, int timeoutMs) = 0;
+
+    // Write replies; sets each connection's flushResult
+    virtual void flush(const vector<Connection*>& conns) = 0;
+};
+
+// epoll, edge-triggered: readiness events, then recv()/sendmsg() per
+// connection, spread over the I/O threads
+class EpollBackend : public EventBackend {
+public:
+    EpollBackend(IOThreads& ioThreads);
+    ~EpollBackend() override;
+
+    const char* name() const override { return "epoll"; }
+    void watch(int listenFd, int inboxFd) override;
+    void addClient(Connection* conn) override;
+    void removeClient(Connection* conn) override;
+    bool poll(LoopEvents& events, int timeoutMs) override;
+    void flush(const vector<Connection*>& conns) override;
+
+private:
+    static const int MAX_EVENTS = 1024;
+    IOThreads& ioThreads;
+    int epollFd;
+    int listenFd = -1;
+    char inboxTag;  // Address marks the inbox in epoll_event.data.ptr (the listener: null)
+    epoll_event events[MAX_EVENTS];
+};
+
+// io_uring: the kernel does the socket I/O asynchronously and reports
+// completions. One multishot accept and one multishot recv per client
+// stay armed, recv picks buffers from a provided-buffer ring, and each
+// client has at most one sendmsg in flight (so replies stay in order
+// without linked SQEs). All of an iteration's SQEs go in one syscall
+class UringBackend : public EventBackend {
+public:
+    explicit UringBackend(ConnectionTable& connections);
+
+    // False (errno set) if the kernel can't run this backend (needs
+    // multishot recv and provided-buffer rings, Linux 6.0+)
+    bool init();
+
+    const char* name() const override { return "io_uring"; }
+    void watch(int listenFd, int inboxFd) override;
+    void addClient(Connection* conn) override;
+    void removeClient(Connection* conn) override;
+    bool poll(LoopEvents& events, int timeoutMs) override;
+    void flush(const vector<Connection*>& conns) override;
+
+private:
+    enum Op : uint8_t { ACCEPT = 1, RECV, SEND, INBOX, SEND_RETRY };
+    static const uint16_t BUFFER_GROUP = 0;
+    static const unsigned BUFFER_COUNT = 2048;  // 8MB of receive buffers per loop
+    static const unsigned BUFFER_SIZE = 4096;
+
+    // sendmsg arguments, read by the kernel at submission (FEAT_SUBMIT_STABLE)
+    struct SendArgs {
+        msghdr msg;
+        iovec iov[OutputBuffer::MAX_IOV];
+    };
+
+    ConnectionTable& connections;
+    IoUring ring;
+    int listenFd = -1;
+    int inboxFd = -1;
+    deque<SendArgs> sendArgs;  // By fd; a deque, so growing keeps queued SQEs' pointers valid
+    unordered_map<uint64_t, OutputBuffer> orphanedSends;  // Closed clients' replies still being sent
+
+    // user_data: op, fd and the connection id's low bits (a stale CQE for a
+    // closed client whose fd was reused doesn't match)
+    static uint64_t tag(Op op, const Connection* conn) {
+        return (uint64_t)op << 56 | (uint64_t)(conn->fd & 0xFFFFFF) << 32 | (uint32_t)conn->id;
+    }
+    Connection* lookup(uint64_t tag) const;
+
+    void armAccept();
+    void armInbox();
+    void armRecv(Connection* conn);
+    void submitSend(Connection* conn);
+    void retrySendLater(Connection* conn);  // submitSend again after SEND_RETRY
+    void handle(const io_uring_cqe& cqe, LoopEvents& events);
+};
+
+#endif
@@ -0,0 +1,53 @@
+#ifndef IO_THREADS_H
+#define IO_THREADS_H
+
+#include "connection.h"
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+using namespace std;
+
+// I/O threads (Redis 6 io-threads)
+//
+// Each event-loop iteration the main thread hands the connections that
+// became readable to run(Op::Read): they are split round-robin between the
+// worker threads and the main thread itself, each reads and parses its
+// share (readAndParse), and run() returns once all are done. The main
+// thread then runs the parsed commands - commands never leave the main
+// thread, so Storage stays single-threaded and lock-free - and hands the
+// connections with replies to run(Op::Write) to flush them in parallel.
+//
+// With count == 1 (the default) or a small batch, everything runs inline
+// on the main thread, as without I/O threads.
+class IOThreads {
+public:
+    enum class Op { Read, Write };
+
+    explicit IOThreads(int count = 1);  // count includes the main thread
+    ~IOThreads();
+
+    void run(const vector<Connection*>& conns, Op op);
+    int count() const { return (int)workers.size() + 1; }
+
+private:
+    struct Worker {
+        thread th;
+        mutex m;
+        condition_variable cv;
+        vector<Connection*> jobs;
+        Op op = Op::Read;
+        bool hasWork = false;
+        bool stop = false;
+    };
+
+    vector<unique_ptr<Worker>> workers;
+    atomic<int> remaining{0};  // Workers still busy with the current batch
+
+    static void process(Connection* conn, Op op);
+    void workerLoop(Worker& worker);
+};
+
+#endif
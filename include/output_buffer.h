@@ -0,0 +1,80 @@
+#ifndef OUTPUT_BUFFER_H
+#define OUTPUT_BUFFER_H
+
+#include <string>
+#include <string_view>
+#include <deque>
+#include <memory>
+#include <cstdint>
+#include <sys/uio.h>
+using namespace std;
+
+// Output buffer limits (Redis client-output-buffer-limit): a client is
+// disconnected when its pending replies exceed hardBytes, or stay above
+// softBytes for softSeconds. 0 disables a limit
+struct OutputLimits {
+    size_t hardBytes = 256 * 1024 * 1024;
+    size_t softBytes = 64 * 1024 * 1024;
+    int64_t softSeconds = 60;
+};
+
+// Per-connection reply buffer
+//
+// Replies are appended into a list of chunks (16KB, or the size of a larger
+// reply) and flushed with one sendmsg() per batch of up to 64 chunks
+// (writev semantics, plus MSG_NOSIGNAL). Partial writes and EAGAIN keep
+// the unsent tail; the caller waits for EPOLLOUT while pending() > 0.
+// One emptied chunk is kept for reuse, so a request/reply client doesn't
+// allocate per reply.
+class OutputBuffer {
+public:
+    static const size_t CHUNK_SIZE = 16 * 1024;
+    static const int MAX_IOV = 64;
+
+    enum class FlushResult {
+        Done,     // Everything was written
+        Pending,  // Socket buffer full (EAGAIN), wait for EPOLLOUT
+        Error     // Connection broken
+    };
+
+    void append(const char* data, size_t n);
+    void append(string_view s) { append(s.data(), s.size()); }
+
+    // Write as much as the socket takes
+    FlushResult flush(int fd);
+
+    // For callers that issue the write themselves (io_uring): iovecs for
+    // up to MAX_IOV chunks of pending data, then consume() what was sent.
+    // Appending meanwhile doesn't move data already handed out
+    int prepareSend(iovec* iov) const;
+    void consume(size_t n);
+
+    // Remove and return everything pending, as one string (a reply that
+    // goes to another thread instead of a socket)
+    string take();
+
+    size_t pending() const { return bytes; }
+    bool empty() const { return bytes == 0; }
+    size_t memoryUsage() const;  // Bytes allocated for chunks
+
+    // True if the client should be disconnected (tracks how long the soft
+    // limit has been exceeded, so call it whenever replies were appended)
+    bool overLimit(const OutputLimits& limits, int64_t nowMs);
+
+private:
+    struct Chunk {
+        unique_ptr<char[]> data;
+        size_t capacity = 0;
+        size_t used = 0;
+    };
+
+    deque<Chunk> chunks;
+    size_t sentInFront = 0;      // Bytes of chunks.front() already written
+    size_t bytes = 0;            // Pending bytes
+    Chunk spare;                 // Emptied chunk kept for reuse
+    int64_t softLimitSince = -1; // When the soft limit was first exceeded (-1 = below)
+
+    void releaseFront();
+};
+
+#endif
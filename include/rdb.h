@@ -0,0 +1,91 @@
+#ifndef RDB_H
+#define RDB_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <sys/types.h>
+#include "storage.h"
+
+// Binary snapshot of the keyspace (Redis RDB-inspired; not Redis's format)
+//
+//   "RCRDB001"                                  magic + version
+//   0xFA <string name> <string value>           AUX field (repeated)
+//   0xFB <length keys> <length expiring keys>   RESIZEDB: table sizes for the load
+//   per key:
+//     [0xFC <int64 expiresAt>]                  absolute deadline, Unix ms
+//     <type> <string key> <value>               type 0: <string>, 1: <zigzag varint>
+//   0xFF                                        EOF
+//   <uint64 CRC-64 of everything before it>
+//
+// Lengths are LEB128 varints, strings a length and the bytes, fixed-width
+// integers little-endian. Integer-encoded values (OBJ_ENCODING_INT) stay
+// integers: "12345" takes 3 bytes and loads without being parsed again.
+// Deadlines are absolute, so a TTL keeps counting from when it was set and
+// keys whose deadline passed before the load are skipped.
+//
+// AUX fields: ctime (Unix ms), aof-inode and aof-offset: the AOF the
+// snapshot was taken against and how many of its bytes it already holds.
+// Startup loads the snapshot, then replays only the AOF after that offset.
+struct SnapshotInfo {
+    uint64_t aofInode = 0;   // 0 = taken without an AOF
+    uint64_t aofOffset = 0;
+    int64_t createdMs = 0;
+};
+
+// A save point (config "save <seconds> <changes>"): BGSAVE once at least
+// changes writes happened and seconds passed since the last save
+struct SavePoint {
+    int64_t seconds;
+    uint64_t changes;
+};
+
+class RDB {
+public:
+    enum class LoadStatus { Ok, NoFile, Corrupt };
+
+private:
+    std::string filename;
+    std::vector<SavePoint> savePoints;
+
+    // BGSAVE child, in the style of AOF::bgRewriteAOF
+    pid_t saveChildPid = -1;
+    uint64_t dirtyAtFork = 0;      // Changes the running child's snapshot covers
+    uint64_t dirtyAtLastSave = 0;  // Change counter as of the last good save
+    int64_t lastSaveMs;            // Last good save (startup counts as one)
+    int64_t lastAttemptMs = 0;     // Last BGSAVE fork
+    bool lastSaveOk = true;
+
+public:
+    RDB(const std::string& filepath = "dump.rdb");
+    ~RDB();
+
+    // SAVE: write every shard's keys to temp-<pid>.rdb, fsync, rename over
+    // the snapshot (also what the BGSAVE child runs). dirty: the server's
+    // change counter now, the baseline for save points
+    bool save(const std::vector<Storage*>& shards, const SnapshotInfo& info, uint64_t dirty = 0);
+    // BGSAVE: the same in a forked child, off the copy-on-write image of
+    // the keyspace. False if one is already running or fork failed
+    bool bgSave(const std::vector<Storage*>& shards, const SnapshotInfo& info, uint64_t dirty = 0);
+    // Reap a finished child (non-blocking); true while it runs
+    bool isSaveInProgress();
+    // Stop a running child and remove its temp file (shutdown saves in the foreground)
+    void killBackgroundSave();
+
+    // Header only: which AOF the snapshot belongs to
+    LoadStatus readInfo(SnapshotInfo& info);
+    // Checksum the whole file, then insert each key into its shard
+    // (shardForKey). Corrupt: bad magic, checksum or structure; nothing is
+    // inserted if the checksum doesn't match
+    LoadStatus load(const std::vector<Storage*>& shards);
+
+    void setSavePoints(std::vector<SavePoint> points) { savePoints = std::move(points); }
+    bool hasSavePoints() const { return !savePoints.empty(); }
+    // Server cron: should a BGSAVE start now? (after a failed one: not for 5s)
+    bool savePointReached(uint64_t dirty) const;
+    uint64_t changesSinceSave(uint64_t dirty) const { return dirty - dirtyAtLastSave; }
+    int64_t lastSaveTime() const { return lastSaveMs; }
+    bool lastSaveSucceeded() const { return lastSaveOk; }
+};
+
+#endif
@@ -2,18 +2,121 @@
 #define RESP_ENCODER_H
 
 #include <string>
+#include <string_view>
 #include <vector>
+#include <charconv>
 #include <cstdint>
 using namespace std;
 
+// Pre-encoded replies shared by every client (Redis shared.ok, shared.czero,
+// shared.integers...): copied into the output buffer as they are, never
+// formatted or allocated per reply
+namespace SharedReplies {
+    constexpr string_view OK = "+OK\r\n";
+    constexpr string_view PONG = "+PONG\r\n";
+    constexpr string_view NULL_BULK = "$-1\r\n";
+    constexpr string_view ZERO = ":0\r\n";
+    constexpr string_view ONE = ":1\r\n";
+    constexpr string_view ERR_SYNTAX = "-ERR syntax error\r\n";
+    constexpr string_view ERR_NOT_INTEGER = "-ERR value is not an integer or out of range\r\n";
+    constexpr string_view ERR_WRONGTYPE = "-WRONGTYPE Operation against a key holding the wrong kind of value\r\n";
+    constexpr string_view ERR_INVALID_COMMAND = "-ERR invalid command\r\n";
+
+    // ":n\r\n" for 0 <= n < SMALL_INTEGERS (Redis OBJ_SHARED_INTEGERS)
+    const int64_t SMALL_INTEGERS = 10000;
+    string_view integer(int64_t n);
+}
+
+// RESP reply encoding
+//
+// The add* functions append a reply straight to out - the connection's
+// OutputBuffer, or a string - formatting numbers on the stack, so a reply
+// costs no allocation beyond out's own growth. The encode* functions
+// return a new string, for replies that leave the event loop (another
+// shard, the AOF) and for tests.
 class RESPEncoder {
 public:
+    template <typename Out>
+    static void addSimpleString(Out& out, string_view s) {
+        out.append("+", 1);
+        out.append(s.data(), s.size());
+        out.append("\r\n", 2);
+    }
+
+    template <typename Out>
+    static void addError(Out& out, string_view s) {
+        out.append("-", 1);
+        out.append(s.data(), s.size());
+        out.append("\r\n", 2);
+    }
+
+    template <typename Out>
+    static void addBulkString(Out& out, string_view s) {
+        addLength(out, '$', s.size());
+        out.append(s.data(), s.size());
+        out.append("\r\n", 2);
+    }
+
+    // Integer as a bulk string (GET of an INT-encoded value)
+    template <typename Out>
+    static void addBulkInteger(Out& out, int64_t n) {
+        char digits[24];
+        char* end = to_chars(digits, digits + sizeof(digits), n).ptr;
+        char buf[40];
+        buf[0] = '$';
+        char* p = to_chars(buf + 1, buf + 4, end - digits).ptr;
+        *p++ = '\r';
+        *p++ = '\n';
+        for (char* d = digits; d != end; d++) *p++ = *d;
+        *p++ = '\r';
+        *p++ = '\n';
+        out.append(buf, p - buf);
+    }
+
+    template <typename Out>
+    static void addNull(Out& out) {
+        out.append(SharedReplies::NULL_BULK.data(), SharedReplies::NULL_BULK.size());
+    }
+
+    template <typename Out>
+    static void addInteger(Out& out, int64_t n) {
+        if (n >= 0 && n < SharedReplies::SMALL_INTEGERS) {
+            string_view shared = SharedReplies::integer(n);
+            out.append(shared.data(), shared.size());
+            return;
+        }
+        addLength(out, ':', n);
+    }
+
+    template <typename Out>
+    static void addArrayHeader(Out& out, size_t n) {
+        addLength(out, '*', n);
+    }
+
+    // Pre-encoded reply (SharedReplies)
+    template <typename Out>
+    static void addShared(Out& out, string_view reply) {
+        out.append(reply.data(), reply.size());
+    }
+
     static string encodeSimpleString(const string& s);
     static string encodeError(const string& s);
     static string encodeBulkString(const string& s);
     static string encodeNull();
     static string encodeInteger(int64_t n);
     static string encodeArray(const vector<string>& arr);
+
+private:
+    // "<prefix><n>\r\n"
+    template <typename Out, typename Int>
+    static void addLength(Out& out, char prefix, Int n) {
+        char buf[24];
+        buf[0] = prefix;
+        char* p = to_chars(buf + 1, buf + sizeof(buf) - 2, n).ptr;
+        *p++ = '\r';
+        *p++ = '\n';
+        out.append(buf, p - buf);
+    }
 };
 
 #endif
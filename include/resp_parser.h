@@ -1,31 +1,104 @@
-
 #ifndef RESP_PARSER_H
 #define RESP_PARSER_H
 
 #include "resp_value.h"
 #include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
 using namespace std;
 
+enum class ParseStatus {
+    Ok,          // A full command was parsed
+    Incomplete,  // Need more data (partial frame kept for the next feed)
+    Error        // Protocol error: the stream can't be resynchronized
+};
+
+// RESP request parser
+//
+// Streaming API (one parser per connection): feed() appends received bytes
+// to the parser's input buffer, next() parses the next command into views
+// (pointer + length) of that buffer - no per-argument copies. A frame split
+// across reads returns Incomplete and resumes where it stopped (parsed
+// lengths and argument offsets are kept, like Redis's multibulklen/bulklen),
+// so feeding a command byte-by-byte costs the same as feeding it at once.
+//
+// Argument views stay valid until the next call to feed(), prepareFeed()
+// or next().
+//
+// Requests are multibulk arrays of bulk strings ("*2\r\n$3\r\nGET\r\n...")
+// or inline commands ("PING\r\n"), as in Redis.
 class RespParser {
-private:
-    // Helper functions
-    int findCRLF(const string& data, int start);
-    string readLine(const string& data, int& pos);
-    string readBytes(const string& data, int& pos, int n);
-    int64_t parseInt(const string& str);
-    
-    // Type-specific parsers
-    RespValue parseSimpleString(const string& data, int& pos);
-    RespValue parseError(const string& data, int& pos);
-    RespValue parseInteger(const string& data, int& pos);
-    RespValue parseBulkString(const string& data, int& pos);
-    RespValue parseArray(const string& data, int& pos);
-    
 public:
-    // Public API
-    RespValue decode(const string& data);
-    // Internal decoder (public for AOF replay and pipelining)
-    RespValue decodeInternal(const string& data, int& pos);
+    // Limits (Redis: proto-max-bulk-len 512MB, 1M multibulk args, 64KB inline)
+    static const int64_t MAX_BULK_LEN = 512LL * 1024 * 1024;
+    static const int64_t MAX_MULTIBULK_LEN = 1024 * 1024;
+    static const size_t MAX_INLINE_LEN = 64 * 1024;
+
+    void feed(const char* data, size_t n);
+    void feed(string_view data) { feed(data.data(), data.size()); }
+
+    // Zero-copy feed for recv(): prepareFeed() returns space for up to n
+    // bytes at the end of the input buffer, commitFeed() keeps the first
+    // filled of them
+    char* prepareFeed(size_t n);
+    void commitFeed(size_t filled);
+
+    // Parse a buffer the caller owns (e.g. an mmapped file) in place instead
+    // of feeding a copy: argument views point into it, so it must outlive
+    // them. Replaces any buffered input; don't feed() an attached parser
+    void attach(string_view data);
+
+    ParseStatus next(vector<string_view>& args);
+
+    // The RESP bytes of the command the last Ok next() returned, exactly as
+    // received ("*3\r\n$3\r\nSET..."; empty for an inline command). Valid
+    // as long as the argument views
+    string_view lastFrame() const { return string_view(input().data() + lastFrameStart, lastFrameLen); }
+
+    // Where a view from next() or lastFrame() starts in the input buffer,
+    // and the bytes at such an offset. Offsets stay valid across next()
+    // calls (the views' vector is reused); the bytes stay put until the
+    // next feed() or prepareFeed() compacts the buffer
+    size_t offsetOf(string_view view) const { return view.data() - input().data(); }
+    string_view bytesAt(size_t offset, size_t len) const { return string_view(input().data() + offset, len); }
+
+    const string& error() const { return errorMsg; }  // Set when next() returns Error
+    size_t bufferedBytes() const { return input().size() - frameStart; }  // Not yet parsed
+    // attach()ed input: offset just past the last complete command returned
+    size_t parsedBytes() const { return frameStart; }
+
+    // Non-throwing integer parse of a whole field ("-12" ok, "12a"/"" not)
+    static bool parseInt(const char* p, const char* end, int64_t& out);
+
+    static const char* findNewline(const char* p, const char* end);  // First '\n' or nullptr
+    static const char* findCRLF(const char* p, const char* end);     // First "\r\n" or nullptr
+
+    // Decode one RESP value of any type (replies, tests). Malformed or
+    // incomplete input yields a default RespValue; consumed (optional)
+    // receives the bytes used, 0 if none
+    RespValue decode(string_view data, size_t* consumed = nullptr);
+
+private:
+    string buf;               // Input buffer; bytes before frameStart are consumed
+    string_view attached;     // attach()ed input, used instead of buf when set
+    size_t frameStart = 0;    // Start of the frame being parsed
+    size_t pos = 0;           // Parse position within buf
+    int64_t multibulkLen = 0; // Arguments still expected (0 = between frames)
+    int64_t bulkLen = -1;     // Length of the pending bulk (-1 = header not read)
+    vector<pair<size_t, size_t>> argOffsets;  // (offset from frameStart, length)
+    size_t lastFrameStart = 0;  // lastFrame(), within buf
+    size_t lastFrameLen = 0;
+    string errorMsg;
+    size_t reserved = 0;      // Bytes handed out by prepareFeed()
+
+    string_view input() const { return attached.data() ? attached : string_view(buf); }
+    static const char* parseDigitsCRLF(const char* p, const char* end, int64_t& out);
+    const char* parseHeader(const char* p, const char* end, int64_t& out, ParseStatus& status,
+                            const char* tooBig, const char* invalid);
+    ParseStatus fail(const char* msg);
+    ParseStatus parseInline(vector<string_view>& args);
+    bool decodeValue(string_view data, size_t& at, RespValue& out, int depth);
 };
 
 #endif
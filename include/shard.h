@@ -0,0 +1,53 @@
+#ifndef SHARD_H
+#define SHARD_H
+
+#include "resp_value.h"
+#include <string>
+#include <string_view>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+using namespace std;
+
+// Shard owning a key when the keyspace is split n ways. Uses the top bits
+// of the key hash: Dict indexes its table with the low bits, so a shard's
+// keys still spread over the whole table
+int shardForKey(string_view key, int shards);
+
+// Message between shard event loops. A shard that receives a command for
+// a key owned elsewhere sends a Request to the owner, which runs it and
+// sends the Reply back to the connection's shard
+struct ShardMessage {
+    enum class Kind { Request, Reply };
+    Kind kind = Kind::Request;
+    int origin = 0;       // Shard owning the connection
+    int fd = -1;          // Connection, checked against connId on return
+    uint64_t connId = 0;  // (the fd may have been closed and reused meanwhile)
+    uint64_t slot = 0;    // Reply slot within the connection
+    RespValue cmd;        // Request: command to run
+    string reply;         // Reply: encoded reply
+};
+
+// Multi-producer inbox of one shard. Senders post a batch per event-loop
+// iteration (one lock per batch, not per message); the owner's epoll
+// watches eventFd(), which is signalled when a batch lands in an empty
+// inbox
+class ShardInbox {
+public:
+    ShardInbox();
+    ~ShardInbox();
+    ShardInbox(const ShardInbox&) = delete;
+    ShardInbox& operator=(const ShardInbox&) = delete;
+
+    int eventFd() const { return efd; }
+
+    void post(vector<ShardMessage>& batch);  // Moves the batch in (batch is left empty)
+    void take(vector<ShardMessage>& out);    // Everything queued so far (out is replaced)
+
+private:
+    mutex m;
+    vector<ShardMessage> queue;
+    int efd;
+};
+
+#endif
@@ -3,114 +3,286 @@
 
 #include <string>
 #include <map>
+#include <vector>
+#include "dict.h"
+#include "timing_wheel.h"
 #include <optional>
+#include <string_view>
+#include <cstring>
 #include <cstdint>
 using namespace std;
 
 // Object type and encoding constants (Redis-style)
 const uint8_t OBJ_TYPE_STRING = 0 << 4;  // 0000 0000
-const uint8_t OBJ_ENCODING_RAW = 0;      // 0000 0000 - normal string
-const uint8_t OBJ_ENCODING_INT = 1;      // 0000 0001 - integer string
-const uint8_t OBJ_ENCODING_EMBSTR = 8;   // 0000 1000 - small string (<44 bytes)
+const uint8_t OBJ_ENCODING_RAW = 0;      // 0000 0000 - string on the heap
+const uint8_t OBJ_ENCODING_INT = 1;      // 0000 0001 - stored as int64_t
+const uint8_t OBJ_ENCODING_EMBSTR = 8;   // 0000 1000 - small string stored inline (<= 11 bytes)
 
 // Forward declare Storage for getCurrentTimeMs
 class Storage;
 
 // Configuration for eviction policy
 struct Config {
-    size_t maxKeys = 1000;              // Maximum number of keys (0 = unlimited)
-    string evictionPolicy = "allkeys-lru";  // Eviction algorithm
-    int samplingSize = 5;               // Number of keys to sample for LRU
+    size_t maxKeys = 0;                 // Maximum number of keys (0 = unlimited)
+    size_t maxMemory = 0;               // Dataset memory limit in bytes (0 = unlimited, --maxmemory)
+    string evictionPolicy = "allkeys-lru";  // {allkeys,volatile}-{lru,lfu,random}, volatile-ttl
+    int samplingSize = 5;               // Number of keys to sample per eviction
+    int lfuLogFactor = 10;              // Higher = counter grows more slowly
+    int lfuDecayTime = 1;               // Minutes per counter decrement (0 = never decay)
+    int64_t activeExpireBudgetUs = 25000;    // Slow expire cycle time limit (per 100ms cron tick)
+    int64_t activeExpireFastBudgetUs = 1000; // Fast expire cycle time limit (before epoll_wait)
 };
 
-// Storage value with expiration support (DiceDB-inspired)
+// LFU counter constants (Redis-style Morris counter)
+const uint8_t LFU_INIT_VAL = 5;  // New keys start here so they aren't evicted instantly
+
+// 24-bit LRU clock in seconds (Redis LRU_CLOCK): wraps every ~194 days
+const uint32_t LRU_CLOCK_MAX = (1 << 24) - 1;
+const int64_t LRU_CLOCK_RESOLUTION_MS = 1000;
+
+// Eviction pool (Redis evictionPoolEntry-inspired)
+// Best candidates seen so far, carried across evictions so every sampling
+// round refines the pool instead of starting from scratch
+const size_t EVPOOL_SIZE = 16;
+
+struct EvictionPoolEntry {
+    int64_t score;  // Higher = better victim (LRU: older, LFU: less frequent, TTL: expires sooner)
+    string key;
+};
+
+// Active expiration cycle type (Redis ACTIVE_EXPIRE_CYCLE_SLOW/FAST)
+// SLOW runs from the server cron: 25ms every 100ms caps it at 25% of the CPU.
+// FAST runs before each epoll_wait, only while the last cycle ran out of
+// time, so a mass expiry drains between events instead of waiting for cron.
+enum class ExpireCycle { SLOW, FAST };
+
+// Victim selection algorithm, derived from Config::evictionPolicy
+enum class EvictionAlgo { LRU, LFU, TTL, RANDOM };
+
+// Storage value, 16 bytes (Redis robj-inspired)
+// The encoding decides how the 11-byte payload is read:
+//   OBJ_ENCODING_INT    - int64_t, no string at all
+//   OBJ_ENCODING_EMBSTR - up to 11 bytes inline, right next to the key
+//   OBJ_ENCODING_RAW    - pointer to a heap block: uint32_t length + bytes
+// Expiry times live only in Storage::expires; the HAS_EXPIRE flag says
+// whether a lookup there is needed at all.
 struct StoredValue {
-    string value;
-    int64_t expiresAt;      // Unix timestamp in milliseconds, -1 = no expiry
-    int64_t lastAccessTime; // Unix timestamp in milliseconds (for LRU)
-    uint8_t typeEncoding;   // Type (high 4 bits) + Encoding (low 4 bits)
+    static const size_t EMBSTR_MAX = 11;
+    static const uint8_t EMBSTR_LEN_MASK = 0x0F;
+    static const uint8_t HAS_EXPIRE = 0x80;
+
+    alignas(8) char payload[EMBSTR_MAX];
+    uint8_t flags;              // EMBSTR length (low 4 bits) + HAS_EXPIRE
+    uint32_t typeEncoding : 8;  // Type (high 4 bits) + Encoding (low 4 bits)
+    uint32_t lru : 24;          // LRU clock, or LFU: minutes (16 bits) << 8 | counter (8 bits)
     
-    // Constructor
-    StoredValue(const string& v = "", int64_t exp = -1, int64_t access = 0, 
-                uint8_t te = OBJ_TYPE_STRING | OBJ_ENCODING_RAW)
-        : value(v), expiresAt(exp), lastAccessTime(access), typeEncoding(te) {}
+    StoredValue() : flags(0), typeEncoding(OBJ_TYPE_STRING | OBJ_ENCODING_EMBSTR), lru(0) {}
+    explicit StoredValue(string_view v) : StoredValue() { setString(v); }
+    StoredValue(StoredValue&& o) noexcept : StoredValue() { *this = std::move(o); }
+    StoredValue& operator=(StoredValue&& o) noexcept;
+    StoredValue(const StoredValue&) = delete;
+    StoredValue& operator=(const StoredValue&) = delete;
+    ~StoredValue() { releaseRaw(); }
     
-    bool isExpired() const;
+    uint8_t encoding() const { return typeEncoding & 0x0F; }
+    bool hasExpire() const { return flags & HAS_EXPIRE; }
+    void setHasExpire(bool on) { flags = on ? (flags | HAS_EXPIRE) : (flags & ~HAS_EXPIRE); }
+    
+    // Store a string, picking the most compact encoding for it
+    void setString(string_view v);
+    void setInt(int64_t v);
+    
+    int64_t intValue() const { int64_t v; memcpy(&v, payload, sizeof(v)); return v; }  // INT only
+    string_view strValue() const;  // EMBSTR/RAW only
+    string toString() const;       // Any encoding
+    
+    // Heap bytes requested for a RAW value (0 for INT/EMBSTR)
+    size_t rawAllocSize() const;
+    
+    // INT for canonical integers ("123", not "0123" or "+1"), else EMBSTR/RAW by length
+    static uint8_t deduceEncoding(string_view v);
+    
+private:
+    char* rawPtr() const { char* p; memcpy(&p, payload, sizeof(p)); return p; }
+    void releaseRaw();
+};
+
+// Snapshot of a key for the AOF rewrite (value rendered as a string)
+struct KeySnapshot {
+    string value;
+    int64_t expiresAt;  // Unix ms, -1 = no expiry
 };
 
 class Storage {
 private:
-    map<string, StoredValue> data;
+    Dict<StoredValue> data;  // Open-addressing hash table (see dict.h)
+    Dict<int64_t> expires;   // Keys with a TTL -> expiresAt (Redis db->expires)
+    TimingWheel expireWheel; // Deadlines bucketed by time, drives active expiration
+    // Compaction of a wheel full of stale entries, spread over slow cycles:
+    // the live deadlines are re-added to spareWheel (expires.scan() from
+    // wheelScanCursor), it is swapped in, then the old wheel is released
+    TimingWheel spareWheel;
+    uint64_t wheelScanCursor = 0;
+    bool wheelRebuilding = false;
     Config config;
+    FastRandom rng;          // Key sampling for eviction
+    vector<EvictionPoolEntry> evictionPool;  // Sorted by score ascending (best victim last)
+    EvictionAlgo evictionAlgo = EvictionAlgo::LRU;  // Derived from config.evictionPolicy
+    bool volatilePolicy = false; // Only keys with a TTL are eviction candidates
+    static int64_t mockTimeMs;   // Test clock override (0 = system clock)
+    static thread_local int64_t cachedTimeMs; // Event-loop clock, per loop thread (0 = read per call)
+    static int64_t systemTimeMs();
+    
+    // Memory accounting (maintained incrementally on every write/delete)
+    size_t heapBytes = 0;        // Heap owned by keys/values (slot arrays counted by Dicts)
+    size_t usedMemoryPeak = 0;
+    uint64_t evictedKeys = 0;
+    
+    // Active expiration state/stats (INFO expired_keys, expire_cycle_cpu_ms, expired_stale_perc)
+    bool expireTimelimitHit = false;  // Last cycle stopped on its budget with work left
+    int64_t lastFastCycleUs = 0;      // Start of last fast cycle (steady clock)
+    uint64_t expiredKeys = 0;         // Lazy + active
+    int64_t expireCycleTimeUs = 0;
+    double expiredStalePerc = 0;      // Running estimate of expired-but-not-reclaimed keys
+    static size_t keyHeapBytes(const CompactString& key);
+    static size_t valueHeapBytes(const StoredValue& sv);
+    void updatePeak();
+    Dict<StoredValue>::iterator deleteEntry(Dict<StoredValue>::iterator it);
+    void setExpireIndex(string_view key, int64_t expiresAt);     // -1 removes
+    void compactExpireWheel(size_t max);  // One step of the compaction
+    void expireEntry(Dict<StoredValue>::iterator it);           // Delete + count as expired
+    int64_t getExpire(const StoredValue& sv, string_view key);  // -1 if no TTL
+    bool isExpired(Dict<StoredValue>::iterator it);
     
     // Eviction helpers (private)
-    void evictIfNeeded();          // Check and evict if over maxKeys
-    string findVictimLRU();        // Sample and find LRU victim
+    void evictIfNeeded();          // Check and evict if over maxKeys/maxMemory
+    string findVictim();           // Take best victim from the eviction pool
+    void evictionPoolPopulate();   // Sample keys into the eviction pool
+    void evictionPoolInsert(string_view key, int64_t score);
+    int64_t evictionScore(string_view key, const StoredValue& sv);
+    
+    // Access tracking (24-bit LRU clock or LFU counter, per policy)
+    void touch(StoredValue& sv);
+    void writeValue(string_view key, StoredValue&& sv, int64_t expiresAt);
+    uint8_t lfuDecrAndReturn(const StoredValue& sv);
+    uint8_t lfuLogIncr(uint8_t counter);
+    static uint16_t lfuTimeInMinutes();
+    static uint32_t lruClock();
+    static int64_t estimateIdleTimeMs(const StoredValue& sv);
     
 public:
     // Helper: Get current time in milliseconds
-    static int64_t getCurrentTimeMs();
+    // Mock clock, else the cached event-loop clock, else system_clock per call
+    static int64_t getCurrentTimeMs() {
+        if (mockTimeMs) return mockTimeMs;
+        if (cachedTimeMs) return cachedTimeMs;
+        return systemTimeMs();
+    }
+    
+    // Coarse clock (Redis server.mstime): the server refreshes it once per
+    // event-loop iteration so commands don't each read the system clock.
+    // Advances by the monotonic clock from a wall-clock anchor taken at the
+    // first call, so wall-clock jumps (NTP, date -s) can't mass-expire keys.
+    static void updateCachedClock();
+    static void disableCachedClock() { cachedTimeMs = 0; }
+    
+    // Freeze the clock at ms for deterministic tests (0 = back to system clock)
+    static void setMockTimeMs(int64_t ms) { mockTimeMs = ms; }
     
     // Configuration
     void setMaxKeys(size_t maxKeys) { config.maxKeys = maxKeys; }
     size_t getMaxKeys() const { return config.maxKeys; }
+    void setMaxMemory(size_t bytes) { config.maxMemory = bytes; }
+    size_t getMaxMemory() const { return config.maxMemory; }
+    void setActiveExpireBudgetUs(int64_t us) { config.activeExpireBudgetUs = us; }
+    int64_t getActiveExpireBudgetUs() const { return config.activeExpireBudgetUs; }
+    bool setEvictionPolicy(const string& policy);  // false if unknown policy
+    const string& getEvictionPolicy() const { return config.evictionPolicy; }
     size_t size() const { return data.size(); }
+    size_t expiresCount() const { return expires.size(); }  // Keys with a TTL (INFO expires=)
+    
+    // Memory stats (INFO used_memory / used_memory_peak)
+    size_t usedMemory() const {
+        return heapBytes + data.memoryUsage() + expires.memoryUsage() + expireWheel.memoryUsage() +
+               spareWheel.memoryUsage();
+    }
+    size_t getUsedMemoryPeak() const { return usedMemoryPeak; }
+    uint64_t getEvictedKeys() const { return evictedKeys; }
+    uint64_t getExpiredKeys() const { return expiredKeys; }
+    size_t getExpireWheelSize() const { return expireWheel.size(); }  // Scheduled deadlines, stale included
+    bool isExpireWheelCompacting() const { return wheelRebuilding || spareWheel.size() > 0; }
+    int64_t getExpireCycleCpuMs() const { return expireCycleTimeUs / 1000; }
+    double getExpiredStalePerc() const { return expiredStalePerc; }  // 0..1
     
     // Set without expiration
-    void set(const string& key, const string& value);
+    void set(string_view key, string_view value);
     
     // Set with expiration (durationMs: -1 = no expiry, >0 = milliseconds from now)
-    void setWithExpiry(const string& key, const string& value, int64_t durationMs);
+    void setWithExpiry(string_view key, string_view value, int64_t durationMs);
+    
+    // Set with an absolute deadline (expiresAt: Unix ms, -1 = no expiry)
+    void setWithExpireAt(string_view key, string_view value, int64_t expiresAt);
     
     // Get value (returns nullopt if key doesn't exist or expired)
-    optional<string> get(const string& key);
+    optional<string> get(string_view key);
+    
+    // Same lookup without copying the value out (GET encodes the reply
+    // straight from it); nullptr if missing or expired. Valid until the next write
+    const StoredValue* getValue(string_view key);
     
     // Check if key exists and not expired
-    bool exists(const string& key);
+    bool exists(string_view key);
     
     // Get TTL in seconds (-2 = doesn't exist, -1 = no expiry, N = seconds remaining)
-    int64_t getTTL(const string& key);
+    int64_t getTTL(string_view key);
 
     // Delete key (returns true if deleted, false if didn't exist)
-    bool del(const string& key);
+    bool del(string_view key);
 
     // Set expiration on existing key (returns true if set, false if key doesn't exist)
-    bool expire(const string& key, int64_t durationSec);
+    bool expire(string_view key, int64_t durationSec);
+    
+    // Same with an absolute deadline in Unix ms (PEXPIREAT)
+    bool expireAt(string_view key, int64_t expiresAt);
+
+    // Active expiration - reclaim keys whose deadline passed, within the
+    // cycle's time budget; the timing wheel is the cursor, so a cycle that
+    // runs out of time resumes exactly where it stopped
+    void activeExpireCycle(ExpireCycle type);
+    void deleteExpiredKeys() { activeExpireCycle(ExpireCycle::SLOW); }  // Server cron
 
-    // Active expiration - background cleanup (sampling approach)
-    void deleteExpiredKeys();
+    // Spend ~1ms migrating keyspace slots if a resize is in progress (server cron)
+    void incrementallyRehash() { data.rehashMilliseconds(1); }
     
     // Get all data (for AOF rewrite)
-    std::map<std::string, StoredValue> getAll() const {
-        return data;  // Returns copy for fork child
-    }
+    std::map<std::string, KeySnapshot> getAll();
     
-    // Type/Encoding helpers for INCR
-    uint8_t deduceEncoding(const std::string& value) {
-        // Try to parse as integer
-        try {
-            std::stoll(value);
-            return OBJ_ENCODING_INT;
-        } catch (...) {}
-        
-        // Small strings use embedded encoding
-        if (value.length() <= 44) {
-            return OBJ_ENCODING_EMBSTR;
-        }
-        
-        return OBJ_ENCODING_RAW;
+    // Visit every key in place for a snapshot: fn(key, value, expiresAt),
+    // expiresAt -1 if it has no TTL. Keys expired but not reclaimed yet are
+    // visited too (the caller decides)
+    template <typename F>
+    void forEach(F fn) {
+        for (const auto& [key, value] : data) fn(string_view(key), value, getExpire(value, key));
     }
     
+    // Snapshot loading: size the tables for the keys to come, then insert
+    // each key with its value already encoded (expiresAt: Unix ms, -1 = none)
+    void reserve(size_t keys, size_t expiring) { data.reserve(keys); expires.reserve(expiring); }
+    void restore(string_view key, StoredValue&& value, int64_t expiresAt);
+    
     uint8_t getType(uint8_t te) { return (te >> 4) << 4; }
     uint8_t getEncoding(uint8_t te) { return te & 0b00001111; }
     
+    // Store an integer in a key obtained via getPtr (INCR), releasing any string buffer
+    void replaceValue(StoredValue* obj, int64_t value);
+    
     // Direct access for INCR (returns pointer for in-place modification)
-    StoredValue* getPtr(const std::string& key) {
+    StoredValue* getPtr(string_view key) {
         auto it = data.find(key);
-        if (it == data.end() || it->second.isExpired()) {
+        if (it == data.end() || isExpired(it)) {
             return nullptr;
         }
-        it->second.lastAccessTime = getCurrentTimeMs();
+        touch(it->second);
         return &it->second;
     }
 };
@@ -0,0 +1,72 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+using namespace std;
+
+// Hierarchical timing wheel for key deadlines (Varghese & Lauck, Linux timers)
+//
+// Level 0 has 256 one-millisecond slots; each higher level has 64 slots, each
+// spanning a full rotation of the level below (256ms, ~16s, ~17min, ~18h).
+// Five levels cover ~49 days; later deadlines are parked in the last slot
+// and re-placed when they come around. When a lower level wraps, the matching
+// slot of the level above is "cascaded" down, so each entry is moved at most
+// once per level and advancing costs O(expired keys), not O(keys with a TTL).
+//
+// The wheel never removes entries on DEL/PERSIST/overwrite - callers verify
+// each due entry against the authoritative expires index (lazy cancellation).
+// If stale entries pile up, the caller re-adds the live keys to a fresh
+// wheel, a batch at a time, swaps it in and release()s the old one.
+class TimingWheel {
+public:
+    struct Entry {
+        int64_t deadline;  // Unix ms
+        string key;
+    };
+
+    TimingWheel();
+
+    // Schedule key for deadline; nowMs anchors an empty wheel
+    void add(const string& key, int64_t deadlineMs, int64_t nowMs);
+
+    // Move up to max entries whose deadline <= nowMs into out (re-placing
+    // entries from a drained slot counts against max too). Returns true when caught up
+    // (nothing else is due at nowMs), so callers can stop early on a time
+    // budget and resume on the next tick.
+    bool collectExpired(int64_t nowMs, vector<Entry>& out, size_t max);
+
+    // Drop every entry (the caller re-adds the live ones)
+    void clear();
+    // Drop up to max entries (frees a replaced wheel without a long stall)
+    void release(size_t max);
+
+    size_t size() const { return count; }           // Scheduled entries (including stale)
+    size_t memoryUsage() const { return bytes; }    // Approximate bytes held by entries
+    int64_t currentTime() const { return current; } // Last fully processed tick
+
+private:
+    static const int LEVELS = 5;
+    static const int LEVEL0_BITS = 8;
+    static const int LEVEL_BITS = 6;
+    static const int64_t LEVEL0_SIZE = 1 << LEVEL0_BITS;
+    static const int64_t LEVEL_SIZE = 1 << LEVEL_BITS;
+    static const int64_t MAX_SPAN = 1LL << (LEVEL0_BITS + (LEVELS - 1) * LEVEL_BITS);
+
+    vector<vector<Entry>> wheel[LEVELS];
+    size_t levelCount[LEVELS] = {};
+    vector<Entry> due;        // Deadline reached, not yet handed out
+    vector<Entry> pending;    // Drained from a slot, not yet re-placed
+    int64_t current = 0;
+    size_t count = 0;
+    size_t bytes = 0;
+
+    static int shift(int level) { return level == 0 ? 0 : LEVEL0_BITS + (level - 1) * LEVEL_BITS; }
+    static size_t entryBytes(const string& key);
+    void place(Entry&& e);
+    void drainSlot(int level, size_t index);
+    void tick();
+};
+
+#endif
@@ -0,0 +1,83 @@
+#ifndef URING_H
+#define URING_H
+
+#include <linux/io_uring.h>
+#include <cstddef>
+#include <cstdint>
+using namespace std;
+
+// Minimal io_uring ring over the raw syscalls (no liburing)
+//
+// The submission and completion queues are shared memory mapped from the
+// kernel: SQEs are filled in place and published by bumping the SQ tail,
+// one io_uring_enter() submits them all and waits for completions, and
+// CQEs are consumed by bumping the CQ head. A provided-buffer ring lets
+// multishot recv pick its own buffers, so no buffer is tied up per idle
+// connection.
+class IoUring {
+public:
+    IoUring() = default;
+    ~IoUring();
+    IoUring(const IoUring&) = delete;
+    IoUring& operator=(const IoUring&) = delete;
+
+    // False (errno set) if the kernel lacks io_uring or a feature this
+    // needs (no-drop CQ, stable submissions, timed waits: Linux 5.11+)
+    bool init(unsigned entries, unsigned cqEntries);
+
+    // Next free SQE, zeroed. Submits queued SQEs first if the SQ is full
+    io_uring_sqe* getSqe();
+
+    // Submit queued SQEs; submitAndWait() also waits up to timeoutMs for a
+    // completion. Return -errno on failure (-ETIME: timed out, -EINTR)
+    int submit();
+    int submitAndWait(int timeoutMs);
+
+    // Hand every available CQE to f, then free their slots
+    template <typename F>
+    unsigned forEachCqe(F f) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        for (unsigned i = head; i != tail; i++) f(cqes[i & cqMask]);
+        __atomic_store_n(cqHead, tail, __ATOMIC_RELEASE);
+        return tail - head;
+    }
+
+    // Provided buffers (Linux 5.19+): entries (a power of 2) buffers of
+    // size bytes each, in group. A recycled buffer goes back to the kernel
+    // at the next publishBuffers()
+    bool setupBufferRing(uint16_t group, unsigned entries, unsigned size);
+    const char* buffer(uint16_t bid) const { return bufData + (size_t)bid * bufSize; }
+    void recycleBuffer(uint16_t bid);
+    void publishBuffers();
+
+private:
+    int ringFd = -1;
+    void* ringMem = nullptr;
+    size_t ringMemSize = 0;
+    io_uring_sqe* sqes = nullptr;
+    size_t sqesSize = 0;
+    unsigned sqEntries = 0;
+
+    unsigned* sqHead = nullptr;
+    unsigned* sqTail = nullptr;
+    unsigned sqMask = 0;
+    unsigned sqeTail = 0;  // Filled SQEs, published to *sqTail on submit
+
+    unsigned* cqHead = nullptr;
+    unsigned* cqTail = nullptr;
+    unsigned cqMask = 0;
+    io_uring_cqe* cqes = nullptr;
+
+    io_uring_buf* bufRing = nullptr;
+    size_t bufRingSize = 0;
+    char* bufData = nullptr;
+    size_t bufDataSize = 0;
+    unsigned bufSize = 0;
+    unsigned bufMask = 0;
+    uint16_t bufTail = 0;
+
+    int enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize);
+};
+
+#endif
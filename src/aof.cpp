@@ -1,197 +1,300 @@
 #include "../include/aof.h"
 #include "../include/resp_encoder.h"
+#include "../include/command_handler.h"
 #include "../include/resp_parser.h"
+#include "../include/output_buffer.h"
 #include <iostream>
-#include <unistd.h>  // For fsync
+#include <iomanip>
+#include <unistd.h>  // For fdatasync
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <cerrno>
 #include <thread>
 #include <chrono>
 
+static bool parseSyncMode(const std::string& sync, AOF::FsyncPolicy& policy) {
+    if (sync == "always") {
+        policy = AOF::FsyncPolicy::Always;
+    } else if (sync == "everysec") {
+        policy = AOF::FsyncPolicy::EverySec;
+    } else if (sync == "no") {
+        policy = AOF::FsyncPolicy::No;
+    } else {
+        return false;
+    }
+    return true;
+}
+
 AOF::AOF(const std::string& filepath, const std::string& sync) 
-    : filename(filepath), aofFile(nullptr), enabled(false), 
-      syncMode(sync), rewriteChildPid(-1), rewriteInProgress(false) {
+    : filename(filepath), fd(-1), enabled(false), 
+      policy(FsyncPolicy::EverySec), rewriteChildPid(-1), rewriteInProgress(false) {
+    parseSyncMode(sync, policy);
     
-    // Open file in append mode ("a")
-    // "a" = append, creates file if doesn't exist, writes at end
-    aofFile = fopen(filename.c_str(), "a");
+    // Append mode: creates the file if it doesn't exist, every write() goes
+    // to the end (so concurrent batches never overwrite each other)
+    fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
     
-    if (aofFile == nullptr) {
+    if (fd < 0) {
         std::cerr << "Warning: Could not open AOF file: " << filename << std::endl;
         enabled = false;
         return;
     }
     
     enabled = true;
+    writerThread = std::thread(&AOF::writerLoop, this);
     
-    // Start background fsync thread for everysec mode
-    if (syncMode == "everysec") {
-        running = true;
-        fsyncThread = std::thread(&AOF::fsyncWorker, this);
-    }
-    
-    std::cout << "AOF enabled: " << filename << " (mode: " << syncMode << ")" << std::endl;
+    std::cout << "AOF enabled: " << filename << " (mode: " << sync << ")" << std::endl;
 }
 
-// Destructor - close file
+// Destructor - stop the writer, sync and close the file
 AOF::~AOF() {
-    // Stop background thread if running
-    if (running) {
-        running = false;
-        if (fsyncThread.joinable()) {
-            fsyncThread.join();
+    if (enabled) {
+        flush(buffer);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
         }
+        writerWake.notify_one();
+        synced.notify_all();
+        writerThread.join();
     }
     
-    if (aofFile) {
+    if (fd >= 0) {
         // Make sure everything is written to disk before closing
-        fsync(fileno(aofFile));
-        fclose(aofFile);
-        aofFile = nullptr;
+        fdatasync(fd);
+        close(fd);
+        fd = -1;
     }
 }
 
-// Background fsync worker for everysec mode
-void AOF::fsyncWorker() {
-    while (running) {
-        std::this_thread::sleep_for(std::chrono::seconds(1));
-        if (aofFile) {
-            fsync(fileno(aofFile));
-        }
-    }
+bool AOF::setSyncMode(const std::string& sync) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!parseSyncMode(sync, policy)) return false;
+    writerWake.notify_one();
+    return true;
 }
 
-
-// Log commands to AOF file
-void AOF::log(const std::vector<std::string>& command) {
-    if (!enabled || command.empty()) {
-        return; // AOF not enabled or empty command
+// Writer thread: group-commit fsyncs. always: as soon as a batch has been
+// written (batches written meanwhile ride along); everysec: once a second
+void AOF::writerLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        if (policy == FsyncPolicy::Always) {
+            writerWake.wait(lock, [&] {
+                return stopping || writtenSeq > syncedSeq || policy != FsyncPolicy::Always;
+            });
+        } else {
+            writerWake.wait_for(lock, std::chrono::seconds(1), [&] {
+                return stopping || policy == FsyncPolicy::Always;
+            });
+        }
+        if (stopping) return;
+        if (writtenSeq == syncedSeq || policy == FsyncPolicy::No) continue;
+        
+        uint64_t covered = writtenSeq;
+        syncing = true;
+        lock.unlock();
+        fdatasync(fd);  // Loops keep writing meanwhile; those batches wait for the next one
+        lock.lock();
+        syncing = false;
+        syncedSeq = covered;
+        synced.notify_all();
     }
+}
 
-    // Skip read-only commands - no need to log
-    std::string cmd = command[0];
-    if (cmd == "GET" || cmd == "TTL" || cmd == "EXISTS" || cmd == "PING") {
+// Encode a command into an event loop's AOF buffer
+void AOF::feed(std::string& buf, const std::vector<std::string_view>& command) {
+    if (command.empty()) {
         return;
     }
 
     // Encode the command as per the RESP format
-    std::string respCmd = RESPEncoder::encodeArray(command);
+    RESPEncoder::addArrayHeader(buf, command.size());
+    for (std::string_view arg : command) RESPEncoder::addBulkString(buf, arg);
+}
 
-    // Write to the file
-    size_t written = fwrite(respCmd.c_str(), 1, respCmd.size(), aofFile);
+// Write a batch (one write() unless the kernel takes it in pieces)
+void AOF::flush(std::string& buf) {
+    if (!enabled || buf.empty()) {
+        buf.clear();
+        return;
+    }
 
-    if (written != respCmd.size()) {
-        std::cerr << "Warning: Incomplete write to AOF file" << std::endl;
+    uint64_t seq;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t done = 0;
+        while (done < buf.size()) {
+            ssize_t n = write(fd, buf.data() + done, buf.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                std::cerr << "Warning: Incomplete write to AOF file" << std::endl;
+                break;
+            }
+            done += n;
+        }
+        seq = ++writtenSeq;
     }
+    buf.clear();
 
-    // Sync based on mode
-    if (syncMode == "always") {
-        fflush(aofFile);
-        fsync(fileno(aofFile));  // Immediate sync (slow but 100% safe)
-    } else {
-        fflush(aofFile);  // Just flush to OS buffer (fast)
-        // everysec: background thread handles fsync
-        // no: OS decides when to fsync
+    // always: the replies wait until the batch is on disk
+    if (policy == FsyncPolicy::Always) {
+        std::unique_lock<std::mutex> lock(mutex);
+        writerWake.notify_one();
+        synced.wait(lock, [&] { return syncedSeq >= seq || stopping; });
     }
 }
 
-// Replay the AOF file to reconstruct the in-memory data store
-void AOF::replay(Storage& storage) {
-    // Try to open the file in read-only mode
-    FILE* f = fopen(filename.c_str(), "r");
-    if (f == nullptr) {
-        std::cout << "No AOF file found, starting with empty database" << std::endl;
+// Log commands to AOF file
+void AOF::log(const std::vector<std::string>& command) {
+    // Skip read-only commands - no need to log
+    const CommandInfo* info = command.empty() ? nullptr : CommandHandler::lookupCommand(command[0]);
+    if (!info || !(info->flags & CMD_WRITE)) {
         return;
     }
 
-    std::cout << "Replaying AOF file: " << filename << std::endl;
-    int commandCount = 0;
+    feed(buffer, std::vector<std::string_view>(command.begin(), command.end()));
+    flush(buffer);
+}
 
-    // Read entire file into string
-    fseek(f, 0, SEEK_END);
-    long fileSize = ftell(f);
-    fseek(f, 0, SEEK_SET);
-    
-    if (fileSize <= 0) {
-        fclose(f);
+// Replay the AOF file to reconstruct the in-memory data store
+bool AOF::replay(Storage& storage, uint64_t from) {
+    CommandHandler handler(storage);
+    return replay([&handler](std::string_view) -> CommandHandler& { return handler; }, from);
+}
+
+bool AOF::replay(const std::function<CommandHandler&(std::string_view key)>& handlerFor, uint64_t from) {
+    int in = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (in < 0) {
+        std::cout << "No AOF file found, starting with empty database" << std::endl;
+        return true;
+    }
+    struct stat st;
+    size_t fileSize = fstat(in, &st) == 0 ? st.st_size : 0;
+    if (fileSize == 0) {
+        close(in);
         std::cout << "Empty AOF file" << std::endl;
-        return;
+        return true;
+    }
+    if (from >= fileSize) {
+        close(in);
+        std::cout << "AOF: nothing written after the snapshot" << std::endl;
+        return true;
+    }
+    
+    // Parsed straight from the page cache: no read() copies, and memory
+    // use doesn't grow with the file. Sequential: read ahead far, and
+    // pages already parsed may be dropped
+    void* map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, in, 0);
+    close(in);
+    if (map == MAP_FAILED) {
+        std::cerr << "AOF: could not map " << filename << std::endl;
+        return false;
     }
+    madvise(map, fileSize, MADV_SEQUENTIAL);
     
-    std::string fileContent(fileSize, '\0');
-    fread(&fileContent[0], 1, fileSize, f);
-    fclose(f);
+    std::cout << "Replaying AOF file: " << filename;
+    if (from > 0) std::cout << " from offset " << from << " (the rest is in the snapshot)";
+    std::cout << std::endl;
+    auto start = std::chrono::steady_clock::now();
     
-    // Parse commands
+    // The fake client: arguments are views into the mapping, replies are
+    // thrown away every 64KB
     RespParser parser;
-    int pos = 0;
+    parser.attach(std::string_view(static_cast<const char*>(map) + from, fileSize - from));
+    std::vector<std::string_view> args;
+    OutputBuffer replies;
+    uint64_t commandCount = 0;
+    uint64_t unknownCount = 0;
+    std::string firstUnknown;
+    size_t released = 0;  // Bytes of the mapping given back
+    ParseStatus status;
     
-    while (pos < fileContent.size()) {
-        try {
-            RespValue result = parser.decodeInternal(fileContent, pos);
-            
-            if (result.type == RespType::Array && !result.arr_value.empty()) {
-                // Convert RESP array to string vector
-                std::vector<std::string> command;
-                for (const auto& val : result.arr_value) {
-                    if (val.type == RespType::BulkString) {
-                        command.push_back(val.str_value);
-                    }
-                }
-                
-                // Execute command to restore state
-                if (!command.empty()) {
-                    std::string cmd = command[0];
-                    
-                    // Execute directly on storage (bypass network layer)
-                    if (cmd == "SET") {
-                        if (command.size() == 3) {
-                            storage.set(command[1], command[2]);
-                        } else if (command.size() >= 5 && command[3] == "PX") {
-                            int64_t ttl = std::stoll(command[4]);
-                            storage.setWithExpiry(command[1], command[2], ttl);
-                        } else if (command.size() >= 5 && command[3] == "EX") {
-                            int64_t seconds = std::stoll(command[4]);
-                            storage.setWithExpiry(command[1], command[2], seconds * 1000);
-                        }
-                    } else if (cmd == "DEL") {
-                        for (size_t i = 1; i < command.size(); i++) {
-                            storage.del(command[i]);
-                        }
-                    } else if (cmd == "EXPIRE") {
-                        if (command.size() == 3) {
-                            int64_t seconds = std::stoll(command[2]);
-                            storage.expire(command[1], seconds);
-                        }
-                    } else if (cmd == "INCR") {
-                        // INCR during replay - just get current and increment
-                        auto val = storage.get(command[1]);
-                        if (val.has_value()) {
-                            try {
-                                int64_t num = std::stoll(val.value()) + 1;
-                                storage.set(command[1], std::to_string(num));
-                            } catch (...) {
-                                // Non-integer, skip
-                            }
-                        } else {
-                            storage.set(command[1], "1");
-                        }
-                    }
-                    
-                    commandCount++;
-                }
+    // The clock is read once per 4096 commands, not per write (as the event
+    // loop reads it once per iteration)
+    while ((status = parser.next(args)) == ParseStatus::Ok) {
+        if ((commandCount & 4095) == 0) Storage::updateCachedClock();
+        if (!CommandHandler::lookupCommand(args[0])) {
+            if (unknownCount++ == 0) firstUnknown = args[0];
+            continue;
+        }
+        if (args.size() > 2 && equalsIgnoreCase(args[0], "DEL")) {
+            // Keys may live on different shards
+            for (size_t i = 1; i < args.size(); i++) {
+                std::string_view del[] = {args[0], args[i]};
+                handlerFor(args[i]).handleCommand(CommandArgs(del, 2), replies);
             }
-        } catch (...) {
-            // Parsing error, skip to next
-            break;
+        } else {
+            handlerFor(args.size() > 1 ? args[1] : args[0])
+                .handleCommand(CommandArgs(args.data(), args.size()), replies);
+        }
+        if (replies.pending() > 64 * 1024) replies.consume(replies.pending());
+        commandCount++;
+        
+        // Unmap what's been run every 64MB: mapped pages count as the
+        // process's memory until then (the page cache keeps them)
+        size_t done = (from + parser.parsedBytes()) & ~(size_t)(64 * 1024 * 1024 - 1);
+        if (done > released) {
+            madvise(static_cast<char*>(map) + released, done - released, MADV_DONTNEED);
+            released = done;
+        }
+    }
+    Storage::disableCachedClock();
+    size_t validBytes = from + parser.parsedBytes();
+    size_t tornBytes = parser.bufferedBytes();
+    std::string error = parser.error();
+    munmap(map, fileSize);
+    
+    if (unknownCount > 0) {
+        std::cerr << "AOF: skipped " << unknownCount << " unknown commands (first: '"
+                  << firstUnknown << "')" << std::endl;
+    }
+    if (status == ParseStatus::Error) {
+        std::cerr << "AOF: " << error << " at offset " << validBytes << ", after "
+                  << commandCount << " commands: the file is corrupt" << std::endl;
+        return false;
+    }
+    if (tornBytes > 0) {
+        // Only the last write was cut short (a crash mid-write): what
+        // precedes it is whole. Appending after it would corrupt the next
+        // command, so it's either cut off or the file isn't loaded
+        std::cerr << "AOF: truncated command at end of file (" << tornBytes
+                  << " bytes at offset " << validBytes << ")" << std::endl;
+        if (!loadTruncated) {
+            std::cerr << "AOF: not loading it; restart with --aof-load-truncated yes "
+                      << "to cut the partial command off" << std::endl;
+            return false;
         }
+        if (fd < 0 || ftruncate(fd, validBytes) != 0) {
+            std::cerr << "AOF: could not truncate " << filename << std::endl;
+            return false;
+        }
+        std::cerr << "AOF: truncated " << filename << " to " << validBytes << " bytes" << std::endl;
     }
     
-    std::cout << "AOF loaded: " << commandCount << " commands replayed" << std::endl;
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "AOF loaded: " << commandCount << " commands in " << std::fixed
+              << std::setprecision(3) << seconds << "s (" << std::setprecision(0)
+              << commandCount / std::max(seconds, 1e-9) << " commands/s, "
+              << std::setprecision(1) << (fileSize - from) / std::max(seconds, 1e-9) / (1 << 20) << " MB/s)"
+              << std::defaultfloat << std::endl;
+    return true;
+}
+
+bool AOF::position(uint64_t& inode, uint64_t& size) {
+    std::lock_guard<std::mutex> lock(mutex);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) return false;
+    inode = st.st_ino;
+    size = st.st_size;
+    return true;
 }
 
 // Manual fsync
 void AOF::sync() {
-    if (aofFile) {
-        fsync(fileno(aofFile));
+    if (fd >= 0) {
+        fdatasync(fd);
     }
 }
 
@@ -205,12 +308,14 @@ bool AOF::bgRewriteAOF(Storage& storage) {
     
     if (pid == 0) {
         // === CHILD PROCESS ===
+        // Leaves with _exit: exit() would run the parent's static
+        // destructors here, ~AOF waiting on a writer thread the child lacks
         
         // Write to temp file
         FILE* tempFile = fopen("temp-rewrite.aof", "w");
         if (!tempFile) {
             std::cerr << "Failed to create temp AOF file" << std::endl;
-            exit(1);
+            _exit(1);
         }
         
         // Dump current state (iterate storage)
@@ -220,13 +325,12 @@ bool AOF::bgRewriteAOF(Storage& storage) {
             // Build SET command
             std::vector<std::string> cmd = {"SET", key, value.value};
             
-            // Add expiration if exists
+            // Absolute deadline, so replay doesn't restart the TTL. Keys
+            // that expired but weren't reclaimed yet are left out
             if (value.expiresAt != -1) {
-                int64_t ttl = value.expiresAt - Storage::getCurrentTimeMs();
-                if (ttl > 0) {
-                    cmd.push_back("PX");
-                    cmd.push_back(std::to_string(ttl));
-                }
+                if (value.expiresAt <= Storage::getCurrentTimeMs()) continue;
+                cmd.push_back("PXAT");
+                cmd.push_back(std::to_string(value.expiresAt));
             }
             
             std::string respCmd = RESPEncoder::encodeArray(cmd);
@@ -240,10 +344,10 @@ bool AOF::bgRewriteAOF(Storage& storage) {
         // Atomic rename
         if (rename("temp-rewrite.aof", "appendonly.aof") != 0) {
             std::cerr << "Failed to rename AOF file" << std::endl;
-            exit(1);
+            _exit(1);
         }
         
-        exit(0);  // Child exits
+        _exit(0);  // Child exits
     } 
     else if (pid > 0) {
         // === PARENT PROCESS ===
@@ -275,10 +379,12 @@ bool AOF::isRewriteInProgress() {
         if (WIFEXITED(status) && WEXITSTATUS(status) == 0) {
             std::cout << "Background AOF rewrite completed successfully" << std::endl;
             
-            // Reopen AOF file to point to new file
-            if (aofFile) {
-                fclose(aofFile);
-                aofFile = fopen(filename.c_str(), "a");
+            // Reopen AOF file to point to new file (not under the writer's fsync)
+            std::unique_lock<std::mutex> lock(mutex);
+            synced.wait(lock, [&] { return !syncing; });
+            if (fd >= 0) {
+                close(fd);
+                fd = open(filename.c_str(), O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644);
             }
         } else {
             std::cerr << "Background AOF rewrite failed" << std::endl;
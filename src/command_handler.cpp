@@ -1,227 +1,364 @@
 #include "../include/command_handler.h"
-#include <algorithm>
-#include <cctype>
+#include <charconv>
 #include <sstream>
+#include <iomanip>
 
-// Constructor - initialize command table
-CommandHandler::CommandHandler(Storage& store) : storage(store) {
-    initCommandTable();
-}
+// Command table (Redis-inspired)
+static constexpr CommandInfo COMMAND_TABLE[] = {
+    {"PING",   &CommandHandler::handlePing,   -1, CMD_FAST | CMD_READONLY},
+    {"SET",    &CommandHandler::handleSet,    -3, CMD_WRITE},
+    {"GET",    &CommandHandler::handleGet,     2, CMD_READONLY | CMD_FAST},
+    {"TTL",    &CommandHandler::handleTTL,     2, CMD_READONLY | CMD_FAST},
+    {"DEL",    &CommandHandler::handleDel,    -2, CMD_WRITE},
+    {"EXPIRE", &CommandHandler::handleExpire,  3, CMD_WRITE},
+    {"PEXPIREAT", &CommandHandler::handlePexpireat, 3, CMD_WRITE},
+    {"INCR",   &CommandHandler::handleIncr,    2, CMD_WRITE | CMD_FAST},
+    {"INFO",   &CommandHandler::handleInfo,   -1, CMD_READONLY | CMD_FAST},
+};
+static constexpr size_t COMMAND_COUNT = sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]);
+
+// Name lookup: an open-addressing index into COMMAND_TABLE, filled at
+// compile time. The hash reads only the length and the first and last
+// bytes (case folded), so looking up a name costs no allocation or
+// upper-casing, and one case-insensitive compare per probe
+static constexpr size_t LOOKUP_SLOTS = 32;  // Power of 2, well above COMMAND_COUNT
+static_assert(COMMAND_COUNT < LOOKUP_SLOTS / 2, "grow LOOKUP_SLOTS");
 
-// Initialize command table (Redis-inspired)
-void CommandHandler::initCommandTable() {
-    commands["PING"] = {&CommandHandler::handlePing, -1, CMD_FAST | CMD_READONLY};
-    commands["SET"]  = {&CommandHandler::handleSet,  -3, CMD_WRITE};
-    commands["GET"]  = {&CommandHandler::handleGet,   2, CMD_READONLY | CMD_FAST};
-    commands["TTL"]  = {&CommandHandler::handleTTL,   2, CMD_READONLY | CMD_FAST};
-    commands["DEL"]  = {&CommandHandler::handleDel,  -2, CMD_WRITE};
-    commands["EXPIRE"] = {&CommandHandler::handleExpire, 3, CMD_WRITE};
-    commands["INCR"] = {&CommandHandler::handleIncr,  2, CMD_WRITE | CMD_FAST};
-    commands["INFO"] = {&CommandHandler::handleInfo, -1, CMD_READONLY | CMD_FAST};
+static constexpr size_t commandHash(string_view name) {
+    return (name.size() * 7 + (name.front() | 0x20) * 3 + (name.back() | 0x20)) & (LOOKUP_SLOTS - 1);
 }
 
-// Helper: Convert string to uppercase
-void CommandHandler::toUpperCase(string& str) {
-    for (char& c : str) c = toupper(c);
+struct CommandLookup {
+    int8_t slots[LOOKUP_SLOTS];  // COMMAND_TABLE index, -1 = empty
+};
+
+static constexpr CommandLookup buildCommandLookup() {
+    CommandLookup lookup = {};
+    for (size_t h = 0; h < LOOKUP_SLOTS; h++) lookup.slots[h] = -1;
+    for (size_t i = 0; i < COMMAND_COUNT; i++) {
+        size_t h = commandHash(COMMAND_TABLE[i].name);
+        while (lookup.slots[h] != -1) h = (h + 1) & (LOOKUP_SLOTS - 1);
+        lookup.slots[h] = (int8_t)i;
+    }
+    return lookup;
 }
+static constexpr CommandLookup COMMAND_LOOKUP = buildCommandLookup();
 
-// Helper: Parse integer with validation
-bool CommandHandler::parseInteger(const string& str, int64_t& out) {
-    try {
-        size_t pos;
-        out = stoll(str, &pos);
-        return pos == str.length();  // Ensure entire string was parsed
-    } catch (...) {
-        return false;
+const CommandInfo* CommandHandler::lookupCommand(string_view name) {
+    if (name.empty()) return nullptr;
+    for (size_t h = commandHash(name);; h = (h + 1) & (LOOKUP_SLOTS - 1)) {
+        int i = COMMAND_LOOKUP.slots[h];
+        if (i < 0) return nullptr;
+        if (equalsIgnoreCase(name, COMMAND_TABLE[i].name)) return &COMMAND_TABLE[i];
     }
 }
 
+CommandHandler::CommandHandler(Storage& store) : storage(store) {}
+
+// Helper: Parse integer with validation (whole string; like Redis string2ll,
+// no leading spaces or '+')
+bool CommandHandler::parseInteger(string_view str, int64_t& out) {
+    auto [end, ec] = from_chars(str.data(), str.data() + str.size(), out);
+    return ec == errc() && end == str.data() + str.size() && !str.empty();
+}
+
 // Main command dispatcher with table lookup
-string CommandHandler::handleCommand(RespValue cmd) {
-    if (cmd.type != RespType::Array || cmd.arr_value.empty()) {
-        return encoder.encodeError("ERR invalid command");
+void CommandHandler::handleCommand(CommandArgs args, OutputBuffer& out) {
+    rewritten.clear();
+    if (args.size() == 0) {
+        RESPEncoder::addShared(out, SharedReplies::ERR_INVALID_COMMAND);
+        return;
     }
     
-    // Get command name (uppercase)
-    string cmdName = cmd.arr_value[0].str_value;
-    toUpperCase(cmdName);
-    
-    // Lookup command in table
-    auto it = commands.find(cmdName);
-    if (it == commands.end()) {
-        return encoder.encodeError("ERR unknown command '" + cmdName + "'");
+    // Lookup command in table (case-insensitive)
+    const CommandInfo* cmdInfo = lookupCommand(args[0]);
+    if (!cmdInfo) {
+        out.append("-ERR unknown command '");
+        out.append(args[0]);
+        out.append("'\r\n");
+        return;
     }
     
-    const CommandInfo& cmdInfo = it->second;
-    int argc = cmd.arr_value.size();
-    
     // Validate arity (Redis style: negative = at least, positive = exactly)
-    if (cmdInfo.arity > 0 && argc != cmdInfo.arity) {
-        return encoder.encodeError("ERR wrong number of arguments for '" + cmdName + "' command");
-    }
-    if (cmdInfo.arity < 0 && argc < -cmdInfo.arity) {
-        return encoder.encodeError("ERR wrong number of arguments for '" + cmdName + "' command");
+    int argc = args.size();
+    if ((cmdInfo->arity > 0 && argc != cmdInfo->arity) || (cmdInfo->arity < 0 && argc < -cmdInfo->arity)) {
+        out.append("-ERR wrong number of arguments for '");
+        out.append(cmdInfo->name);
+        out.append("' command\r\n");
+        return;
     }
     
     // Call handler using member function pointer
-    return (this->*(cmdInfo.handler))(cmd);
+    (this->*(cmdInfo->handler))(args, out);
+}
+
+void CommandHandler::handleCommand(const RespValue& cmd, OutputBuffer& out) {
+    if (cmd.type != RespType::Array || cmd.arr_value.empty()) {
+        RESPEncoder::addShared(out, SharedReplies::ERR_INVALID_COMMAND);
+        return;
+    }
+    argv.clear();
+    for (const RespValue& arg : cmd.arr_value) argv.push_back(arg.str_value);
+    handleCommand(CommandArgs(argv.data(), argv.size()), out);
+}
+
+string CommandHandler::handleCommand(const RespValue& cmd) {
+    handleCommand(cmd, scratch);
+    return scratch.take();
 }
 
 // PING command handler
-string CommandHandler::handlePing(const RespValue& cmd) {
-    return encoder.encodeSimpleString("PONG");
+void CommandHandler::handlePing(CommandArgs args, OutputBuffer& out) {
+    RESPEncoder::addShared(out, SharedReplies::PONG);
 }
 
-// SET command handler with EX/PX support (DiceDB-inspired)
-string CommandHandler::handleSet(const RespValue& cmd) {
-    string key = cmd.arr_value[1].str_value;
-    string val = cmd.arr_value[2].str_value;
-    int64_t expiryMs = -1;  // -1 = no expiration
+// SET command handler with EX/PX/PXAT support (DiceDB-inspired)
+void CommandHandler::handleSet(CommandArgs args, OutputBuffer& out) {
+    string_view key = args[1];
+    string_view val = args[2];
+    int64_t expiresAt = -1;  // Unix ms, -1 = no expiration
+    bool relative = false;   // EX/PX: propagated as PXAT
     
     // Parse options starting at index 3
-    for (size_t i = 3; i < cmd.arr_value.size(); i++) {
-        string opt = cmd.arr_value[i].str_value;
-        toUpperCase(opt);
+    for (size_t i = 3; i < args.size(); i++) {
+        string_view opt = args[i];
         
-        if (opt == "EX") {
-            // EX seconds - expiry in seconds
-            if (i + 1 >= cmd.arr_value.size()) {
-                return encoder.encodeError("ERR syntax error");
-            }
-            i++;
-            int64_t seconds;
-            if (!parseInteger(cmd.arr_value[i].str_value, seconds) || seconds <= 0) {
-                return encoder.encodeError("ERR value is not an integer or out of range");
-            }
-            expiryMs = seconds * 1000;  // Convert to milliseconds
-            
-        } else if (opt == "PX") {
-            // PX milliseconds - expiry in milliseconds
-            if (i + 1 >= cmd.arr_value.size()) {
-                return encoder.encodeError("ERR syntax error");
-            }
-            i++;
-            int64_t milliseconds;
-            if (!parseInteger(cmd.arr_value[i].str_value, milliseconds) || milliseconds <= 0) {
-                return encoder.encodeError("ERR value is not an integer or out of range");
+        // EX seconds, PX milliseconds, PXAT unix-time-milliseconds
+        int64_t unitMs = 1;
+        if (equalsIgnoreCase(opt, "EX")) {
+            relative = true;
+            unitMs = 1000;
+        } else if (equalsIgnoreCase(opt, "PX")) {
+            relative = true;
+        } else if (equalsIgnoreCase(opt, "PXAT")) {
+            relative = false;
+        } else {
+            RESPEncoder::addShared(out, SharedReplies::ERR_SYNTAX);
+            return;
+        }
+        if (i + 1 >= args.size()) {
+            RESPEncoder::addShared(out, SharedReplies::ERR_SYNTAX);
+            return;
+        }
+        i++;
+        int64_t amount;
+        if (!parseInteger(args[i], amount) || amount <= 0) {
+            RESPEncoder::addShared(out, SharedReplies::ERR_NOT_INTEGER);
+            return;
+        }
+        if (relative) {
+            // A deadline past INT64_MAX would wrap into the past (Redis refuses it too)
+            int64_t now = Storage::getCurrentTimeMs();
+            if (amount > (INT64_MAX - now) / unitMs) {
+                RESPEncoder::addError(out, "ERR invalid expire time in 'set' command");
+                return;
             }
-            expiryMs = milliseconds;
-            
+            expiresAt = now + amount * unitMs;
         } else {
-            return encoder.encodeError("ERR syntax error");
+            expiresAt = amount;
+        }
+    }
+    
+    // A deadline already passed (PXAT in the past, or a replayed entry)
+    // leaves no key rather than one that expires later
+    if (expiresAt != -1 && expiresAt <= Storage::getCurrentTimeMs()) {
+        if (storage.del(key)) {
+            dirty++;
+            propagateDel(key);
         }
+        RESPEncoder::addShared(out, SharedReplies::OK);
+        return;
     }
     
     // Store with expiration
-    storage.setWithExpiry(key, val, expiryMs);
-    return encoder.encodeSimpleString("OK");
+    storage.setWithExpireAt(key, val, expiresAt);
+    dirty++;
+    if (relative) {
+        RESPEncoder::addArrayHeader(rewritten, 5);
+        RESPEncoder::addBulkString(rewritten, "SET");
+        RESPEncoder::addBulkString(rewritten, key);
+        RESPEncoder::addBulkString(rewritten, val);
+        RESPEncoder::addBulkString(rewritten, "PXAT");
+        RESPEncoder::addBulkInteger(rewritten, expiresAt);
+    }
+    RESPEncoder::addShared(out, SharedReplies::OK);
 }
 
 // GET command handler with expiration check
-string CommandHandler::handleGet(const RespValue& cmd) {
-    string key = cmd.arr_value[1].str_value;
-    
-    // Get value (returns nullopt if expired or doesn't exist)
-    optional<string> value = storage.get(key);
+void CommandHandler::handleGet(CommandArgs args, OutputBuffer& out) {
+    // Get value (nullptr if expired or doesn't exist), encoded straight
+    // from storage without copying it into a string first
+    const StoredValue* value = storage.getValue(args[1]);
     
-    if (value.has_value()) {
-        return encoder.encodeBulkString(value.value());
+    if (!value) {
+        RESPEncoder::addNull(out);
+    } else if (value->encoding() == OBJ_ENCODING_INT) {
+        RESPEncoder::addBulkInteger(out, value->intValue());
+    } else {
+        RESPEncoder::addBulkString(out, value->strValue());
     }
-    return encoder.encodeNull();
 }
 
 // TTL command handler (DiceDB-inspired)
-string CommandHandler::handleTTL(const RespValue& cmd) {
-    string key = cmd.arr_value[1].str_value;
+void CommandHandler::handleTTL(CommandArgs args, OutputBuffer& out) {
+    string_view key = args[1];
     
     int64_t ttl = storage.getTTL(key);
-    return encoder.encodeInteger(ttl);
+    RESPEncoder::addInteger(out, ttl);
 }
 
 // DEL command handler 
-string CommandHandler::handleDel(const RespValue& cmd) {
+void CommandHandler::handleDel(CommandArgs args, OutputBuffer& out) {
     int countDeleted = 0;
     
     // Loop through all keys starting from index 1
-    for (size_t i = 1; i < cmd.arr_value.size(); i++) {
-        string key = cmd.arr_value[i].str_value;
-        if (storage.del(key)) {
+    for (size_t i = 1; i < args.size(); i++) {
+        if (storage.del(args[i])) {
             countDeleted++;
         }
     }
     
-    return encoder.encodeInteger(countDeleted);
+    dirty += countDeleted;
+    RESPEncoder::addInteger(out, countDeleted);
 }
 
 // EXPIRE command handler 
-string CommandHandler::handleExpire(const RespValue& cmd) {
-    string key = cmd.arr_value[1].str_value;
+void CommandHandler::handleExpire(CommandArgs args, OutputBuffer& out) {
+    string_view key = args[1];
     
     // Parse seconds
     int64_t seconds;
-    if (!parseInteger(cmd.arr_value[2].str_value, seconds)) {
-        return encoder.encodeError("ERR value is not an integer or out of range");
+    if (!parseInteger(args[2], seconds)) {
+        RESPEncoder::addShared(out, SharedReplies::ERR_NOT_INTEGER);
+        return;
+    }
+    
+    if (seconds <= 0) {
+        expireNow(key, out);
+        return;
+    }
+    
+    int64_t now = Storage::getCurrentTimeMs();
+    if (seconds > (INT64_MAX - now) / 1000) {
+        RESPEncoder::addError(out, "ERR invalid expire time in 'expire' command");
+        return;
+    }
+    
+    // Try to set expiration (propagated as PEXPIREAT)
+    int64_t expiresAt = now + seconds * 1000;
+    bool success = storage.expireAt(key, expiresAt);
+    dirty += success;
+    if (success) {
+        RESPEncoder::addArrayHeader(rewritten, 3);
+        RESPEncoder::addBulkString(rewritten, "PEXPIREAT");
+        RESPEncoder::addBulkString(rewritten, key);
+        RESPEncoder::addBulkInteger(rewritten, expiresAt);
+    }
+    
+    RESPEncoder::addShared(out, success ? SharedReplies::ONE : SharedReplies::ZERO);
+}
+
+// PEXPIREAT key unix-time-milliseconds (how EXPIRE is propagated)
+void CommandHandler::handlePexpireat(CommandArgs args, OutputBuffer& out) {
+    int64_t expiresAt;
+    if (!parseInteger(args[2], expiresAt)) {
+        RESPEncoder::addShared(out, SharedReplies::ERR_NOT_INTEGER);
+        return;
     }
     
-    // Try to set expiration
-    bool success = storage.expire(key, seconds);
+    if (expiresAt <= Storage::getCurrentTimeMs()) {
+        expireNow(args[1], out);
+        return;
+    }
+    bool success = storage.expireAt(args[1], expiresAt);
+    dirty += success;
     
-    return encoder.encodeInteger(success ? 1 : 0);
+    RESPEncoder::addShared(out, success ? SharedReplies::ONE : SharedReplies::ZERO);
+}
+
+// EXPIRE/PEXPIREAT with a deadline already passed: the key is deleted now
+// (and propagated as DEL), as in Redis
+void CommandHandler::expireNow(string_view key, OutputBuffer& out) {
+    bool deleted = storage.del(key);
+    if (deleted) {
+        dirty++;
+        propagateDel(key);
+    }
+    RESPEncoder::addShared(out, deleted ? SharedReplies::ONE : SharedReplies::ZERO);
+}
+
+void CommandHandler::propagateDel(string_view key) {
+    RESPEncoder::addArrayHeader(rewritten, 2);
+    RESPEncoder::addBulkString(rewritten, "DEL");
+    RESPEncoder::addBulkString(rewritten, key);
 }
 
 // INCR key - Atomically increment integer value
-string CommandHandler::handleIncr(const RespValue& cmd) {
-    string key = cmd.arr_value[1].str_value;
+void CommandHandler::handleIncr(CommandArgs args, OutputBuffer& out) {
+    string_view key = args[1];
     StoredValue* obj = storage.getPtr(key);
     
     // Key doesn't exist - create with value 1
     if (obj == nullptr) {
         storage.set(key, "1");
-        return encoder.encodeInteger(1);
+        dirty++;
+        RESPEncoder::addShared(out, SharedReplies::ONE);
+        return;
     }
     
     // Check if it's a string type
     if (storage.getType(obj->typeEncoding) != OBJ_TYPE_STRING) {
-        return encoder.encodeError("WRONGTYPE Operation against a key holding the wrong kind of value");
+        RESPEncoder::addShared(out, SharedReplies::ERR_WRONGTYPE);
+        return;
     }
     
-    // Try to parse as integer
+    // Integers are stored as int64_t; anything else must parse as one
     int64_t val;
-    if (!parseInteger(obj->value, val)) {
-        return encoder.encodeError("ERR value is not an integer or out of range");
+    if (storage.getEncoding(obj->typeEncoding) == OBJ_ENCODING_INT) {
+        val = obj->intValue();
+    } else if (!parseInteger(obj->strValue(), val)) {
+        RESPEncoder::addShared(out, SharedReplies::ERR_NOT_INTEGER);
+        return;
     }
     
     // Increment and update
     val++;
-    obj->value = std::to_string(val);
-    obj->typeEncoding = OBJ_TYPE_STRING | OBJ_ENCODING_INT;
+    storage.replaceValue(obj, val);
+    dirty++;
     
-    return encoder.encodeInteger(val);
+    RESPEncoder::addInteger(out, val);
 }
 
 // INFO [section] - Server statistics (calculated on-demand)
-string CommandHandler::handleInfo(const RespValue& cmd) {
+void CommandHandler::handleInfo(CommandArgs args, OutputBuffer& out) {
     std::stringstream info;
     
-    // Count keys with expiry (lazy calculation)
-    size_t keysWithExpiry = 0;
-    for (const auto& pair : storage.getAll()) {
-        if (pair.second.expiresAt != -1) {
-            keysWithExpiry++;
-        }
-    }
-    
     // Keyspace section
     info << "# Keyspace\r\n";
     info << "db0:keys=" << storage.size() 
-         << ",expires=" << keysWithExpiry 
+         << ",expires=" << storage.expiresCount() 
          << ",avg_ttl=0\r\n";
     
+    // Memory section
+    info << "\r\n# Memory\r\n";
+    info << "used_memory:" << storage.usedMemory() << "\r\n";
+    info << "used_memory_peak:" << storage.getUsedMemoryPeak() << "\r\n";
+    info << "maxmemory:" << storage.getMaxMemory() << "\r\n";
+    info << "maxmemory_policy:" << storage.getEvictionPolicy() << "\r\n";
+    
+    // Stats section
+    info << "\r\n# Stats\r\n";
+    info << "expired_keys:" << storage.getExpiredKeys() << "\r\n";
+    info << "expired_stale_perc:" << std::fixed << std::setprecision(2)
+         << storage.getExpiredStalePerc() * 100 << "\r\n";
+    info << "expire_cycle_cpu_ms:" << storage.getExpireCycleCpuMs() << "\r\n";
+    info << "evicted_keys:" << storage.getEvictedKeys() << "\r\n";
+    
     // Server section
     info << "\r\n# Server\r\n";
     info << "redis_version:7.0.0-cpp-clone\r\n";
     info << "os:Linux\r\n";
     info << "arch_bits:64\r\n";
     
-    return encoder.encodeBulkString(info.str());
+    RESPEncoder::addBulkString(out, info.str());
 }
@@ -0,0 +1,72 @@
+#include "../include/connection.h"
+#include "../include/command_handler.h"
+#include <sys/socket.h>
+#include <cerrno>
+#include <algorithm>
+
+ReadResult readQuery(int fd, RespParser& parser, size_t limit) {
+    while (true) {
+        char* dest = parser.prepareFeed(READ_CHUNK);
+        ssize_t n = recv(fd, dest, READ_CHUNK, 0);
+        parser.commitFeed(n > 0 ? n : 0);
+        if (n > 0) {
+            if (parser.bufferedBytes() > limit) return ReadResult::TooBig;
+            continue;
+        }
+        if (n == 0) return ReadResult::Closed;
+        if (errno == EINTR) continue;
+        return errno == EAGAIN || errno == EWOULDBLOCK ? ReadResult::Drained : ReadResult::Failed;
+    }
+}
+
+void readAndParse(Connection& conn, size_t limit) {
+    size_t before = conn.parser.bufferedBytes();
+    conn.readResult = readQuery(conn.fd, conn.parser, limit);
+    conn.bytesRead += conn.parser.bufferedBytes() - before;
+    // A client may send its last commands and shut down its write side in
+    // one go (FIN right behind the data): those still get run and answered
+    if (conn.readResult == ReadResult::Drained || conn.readResult == ReadResult::Closed) parseCommands(conn);
+}
+
+void parseCommands(Connection& conn) {
+    // Complete commands buffered so far (pipelining); a partial frame
+    // waits in the parser for more data. Only offsets are kept: the
+    // arguments are run from the query buffer itself
+    static thread_local vector<string_view> args;
+    while ((conn.parseStatus = conn.parser.next(args)) == ParseStatus::Ok) {
+        ParsedCommand cmd;
+        cmd.firstArg = conn.argSpans.size();
+        cmd.argc = args.size();
+        for (string_view arg : args) conn.argSpans.emplace_back(conn.parser.offsetOf(arg), arg.size());
+
+        // Write commands' bytes go to the AOF as received
+        const CommandInfo* info = CommandHandler::lookupCommand(args[0]);
+        string_view frame = info && (info->flags & CMD_WRITE) ? conn.parser.lastFrame() : string_view();
+        cmd.frameOffset = frame.empty() ? 0 : conn.parser.offsetOf(frame);
+        cmd.frameLen = frame.size();
+        conn.commands.push_back(cmd);
+    }
+}
+
+CommandArgs Connection::args(size_t i, vector<string_view>& argv) const {
+    const ParsedCommand& cmd = commands[i];
+    argv.clear();
+    for (uint32_t a = cmd.firstArg; a < cmd.firstArg + cmd.argc; a++) {
+        argv.push_back(parser.bytesAt(argSpans[a].first, argSpans[a].second));
+    }
+    return CommandArgs(argv.data(), argv.size());
+}
+
+Connection* ConnectionTable::add(int fd) {
+    if ((size_t)fd >= slots.size()) slots.resize(max((size_t)fd + 1, slots.size() * 2));
+    if (!slots[fd]) count++;
+    slots[fd].reset(new Connection());
+    slots[fd]->fd = fd;
+    return slots[fd].get();
+}
+
+void ConnectionTable::remove(int fd) {
+    if (!get(fd)) return;
+    slots[fd].reset();
+    count--;
+}
@@ -0,0 +1,45 @@
+#include "../include/crc64.h"
+#include <cstring>
+
+static const uint64_t CRC64_POLY = 0x95ac9329ac4bc9b5ULL;  // 0xad93d23594c935a9 bit-reversed
+
+// tables[0] is the classic byte-at-a-time table; tables[k][b] is b's CRC
+// followed by k zero bytes
+struct Crc64Tables {
+    uint64_t t[8][256];
+};
+
+static constexpr Crc64Tables buildTables() {
+    Crc64Tables tables{};
+    for (int b = 0; b < 256; b++) {
+        uint64_t crc = b;
+        for (int bit = 0; bit < 8; bit++) crc = (crc & 1) ? (crc >> 1) ^ CRC64_POLY : crc >> 1;
+        tables.t[0][b] = crc;
+    }
+    for (int k = 1; k < 8; k++) {
+        for (int b = 0; b < 256; b++) {
+            uint64_t prev = tables.t[k - 1][b];
+            tables.t[k][b] = tables.t[0][prev & 0xff] ^ (prev >> 8);
+        }
+    }
+    return tables;
+}
+
+static constexpr Crc64Tables TABLES = buildTables();
+
+uint64_t crc64(uint64_t crc, const void* data, size_t len) {
+    const unsigned char* p = static_cast<const unsigned char*>(data);
+    const auto& t = TABLES.t;
+    while (len >= 8) {
+        uint64_t word;
+        memcpy(&word, p, 8);  // Little-endian: the first byte is the low byte
+        crc ^= word;
+        crc = t[7][crc & 0xff] ^ t[6][(crc >> 8) & 0xff] ^ t[5][(crc >> 16) & 0xff] ^
+              t[4][(crc >> 24) & 0xff] ^ t[3][(crc >> 32) & 0xff] ^ t[2][(crc >> 40) & 0xff] ^
+              t[1][(crc >> 48) & 0xff] ^ t[0][crc >> 56];
+        p += 8;
+        len -= 8;
+    }
+    while (len--) crc = t[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
@@ -0,0 +1,325 @@
+#include "../include/event_backend.h"
+#include <sys/epoll.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+
+// ============================================================================
+// epoll
+// ============================================================================
+
+EpollBackend::EpollBackend(IOThreads& ioThreads) : ioThreads(ioThreads), epollFd(epoll_create1(0)) {}
+
+EpollBackend::~EpollBackend() {
+    close(epollFd);
+}
+
+void EpollBackend::watch(int fd, int inboxFd) {
+    listenFd = fd;
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLET;  // Edge-triggered: accept until EAGAIN
+    ev.data.ptr = nullptr;          // Connections carry their Connection*
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &ev);
+    if (inboxFd >= 0) {
+        ev.events = EPOLLIN;
+        ev.data.ptr = &inboxTag;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, inboxFd, &ev);
+    }
+}
+
+void EpollBackend::addClient(Connection* conn) {
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.ptr = conn;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, conn->fd, &ev);
+}
+
+void EpollBackend::removeClient(Connection* conn) {
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, conn->fd, nullptr);
+}
+
+bool EpollBackend::poll(LoopEvents& out, int timeoutMs) {
+    int n = epoll_wait(epollFd, events, MAX_EVENTS, timeoutMs);
+    if (n < 0) return errno == EINTR;  // Interrupted by a signal: let the loop check shutdown
+
+    for (int i = 0; i < n; i++) {
+        if (events[i].data.ptr == &inboxTag) {
+            out.inboxReady = true;
+            continue;
+        }
+        Connection* conn = static_cast<Connection*>(events[i].data.ptr);
+        if (!conn) {
+            int fd;
+            while ((fd = accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0) out.accepted.push_back(fd);
+            continue;
+        }
+        if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            out.readable.push_back(conn);  // Replies, if any, get flushed after running
+        } else if (events[i].events & EPOLLOUT) {
+            out.writable.push_back(conn);  // Socket drained enough to take more
+        }
+    }
+
+    // Read phase: drain and parse every readable client (edge-triggered),
+    // spread over the I/O threads
+    ioThreads.run(out.readable, IOThreads::Op::Read);
+    return true;
+}
+
+void EpollBackend::flush(const vector<Connection*>& conns) {
+    ioThreads.run(conns, IOThreads::Op::Write);
+
+    // Watch for EPOLLOUT only while replies are left over (a slow reader),
+    // so idle clients cost no wakeups
+    for (Connection* conn : conns) {
+        if (conn->flushResult == OutputBuffer::FlushResult::Error) continue;
+        bool wantWrite = conn->flushResult == OutputBuffer::FlushResult::Pending;
+        if (wantWrite != conn->wantWrite) {
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLET | (wantWrite ? EPOLLOUT : 0);
+            ev.data.ptr = conn;
+            epoll_ctl(epollFd, EPOLL_CTL_MOD, conn->fd, &ev);
+            conn->wantWrite = wantWrite;
+        }
+    }
+}
+
+// ============================================================================
+// io_uring
+// ============================================================================
+
+UringBackend::UringBackend(ConnectionTable& connections) : connections(connections) {}
+
+bool UringBackend::init() {
+    if (!ring.init(4096, 16384) || !ring.setupBufferRing(BUFFER_GROUP, BUFFER_COUNT, BUFFER_SIZE)) {
+        return false;
+    }
+
+    // Multishot recv (Linux 6.0) can only be detected by trying it
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0, fds) != 0) return false;
+    io_uring_sqe* sqe = ring.getSqe();
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fds[0];
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = 0;  // No op: ignored when the shutdown below completes it
+    (void)!write(fds[1], "x", 1);
+    int ret = ring.submitAndWait(1000);
+    bool supported = false;
+    ring.forEachCqe([&](const io_uring_cqe& cqe) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) ring.recycleBuffer(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+        supported = cqe.res == 1 && (cqe.flags & IORING_CQE_F_MORE);
+        if (cqe.res < 0) ret = cqe.res;
+    });
+    ring.publishBuffers();
+    shutdown(fds[0], SHUT_RDWR);
+    close(fds[0]);
+    close(fds[1]);
+    if (!supported) errno = ret < 0 && ret != -ETIME ? -ret : EINVAL;
+    return supported;
+}
+
+Connection* UringBackend::lookup(uint64_t tag) const {
+    Connection* conn = connections.get((tag >> 32) & 0xFFFFFF);
+    return conn && (uint32_t)conn->id == (uint32_t)tag ? conn : nullptr;
+}
+
+void UringBackend::armAccept() {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = listenFd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK;
+    sqe->user_data = (uint64_t)ACCEPT << 56;
+}
+
+void UringBackend::armInbox() {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->fd = inboxFd;
+    sqe->len = IORING_POLL_ADD_MULTI;
+    sqe->poll32_events = POLLIN;
+    sqe->user_data = (uint64_t)INBOX << 56;
+}
+
+void UringBackend::armRecv(Connection* conn) {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = conn->fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = BUFFER_GROUP;
+    sqe->user_data = tag(RECV, conn);
+    conn->recvArmed = true;
+}
+
+void UringBackend::submitSend(Connection* conn) {
+    io_uring_sqe* sqe = ring.getSqe();
+    if (!sqe) return;
+    while (sendArgs.size() <= (size_t)conn->fd) sendArgs.emplace_back();
+    SendArgs& args = sendArgs[conn->fd];
+    args.msg = {};
+    args.msg.msg_iov = args.iov;
+    args.msg.msg_iovlen = conn->reply.prepareSend(args.iov);
+    sqe->opcode = IORING_OP_SENDMSG;
+    sqe->fd = conn->fd;
+    sqe->addr = reinterpret_cast<uint64_t>(&args.msg);
+    sqe->msg_flags = MSG_NOSIGNAL;
+    sqe->user_data = tag(SEND, conn);
+    conn->sendInFlight = true;
+}
+
+void UringBackend::retrySendLater(Connection* conn) {
+    static const __kernel_timespec delay = {0, 1000000};  // 1ms; read at submission
+    io_uring_sqe* sqe = ring.getSqe();
+    if (!sqe) return;
+    sqe->opcode = IORING_OP_TIMEOUT;
+    sqe->fd = -1;
+    sqe->addr = reinterpret_cast<uint64_t>(&delay);
+    sqe->len = 1;
+    sqe->user_data = tag(SEND_RETRY, conn);
+    conn->sendInFlight = true;  // Replies stay queued behind it
+}
+
+void UringBackend::watch(int fd, int efd) {
+    listenFd = fd;
+    inboxFd = efd;
+    armAccept();
+    if (inboxFd >= 0) armInbox();
+}
+
+void UringBackend::addClient(Connection* conn) {
+    armRecv(conn);
+}
+
+void UringBackend::removeClient(Connection* conn) {
+    // Queued SQEs name the fd, which is about to be closed and reused
+    ring.submit();
+
+    // In-flight requests hold the socket open past close(); shutdown ends
+    // them. Their completions no longer match a connection and are dropped
+    shutdown(conn->fd, SHUT_RDWR);
+    if (conn->sendInFlight) orphanedSends.emplace(tag(SEND, conn), std::move(conn->reply));
+}
+
+bool UringBackend::poll(LoopEvents& events, int timeoutMs) {
+    int ret = ring.submitAndWait(timeoutMs);
+    if (ret < 0 && ret != -ETIME && ret != -EINTR && ret != -EBUSY) return false;
+
+    ring.forEachCqe([&](const io_uring_cqe& cqe) { handle(cqe, events); });
+    ring.publishBuffers();
+
+    // Received data is already in the query buffers (commands that came
+    // right before a FIN included)
+    for (Connection* conn : events.readable) {
+        conn->queuedRead = false;
+        if (conn->readResult == ReadResult::Drained || conn->readResult == ReadResult::Closed) parseCommands(*conn);
+    }
+    return true;
+}
+
+void UringBackend::handle(const io_uring_cqe& cqe, LoopEvents& events) {
+    const bool more = cqe.flags & IORING_CQE_F_MORE;  // Multishot request still armed
+    switch (cqe.user_data >> 56) {
+    case ACCEPT:
+        if (cqe.res >= 0) events.accepted.push_back(cqe.res);
+        if (!more) armAccept();
+        return;
+
+    case INBOX:
+        events.inboxReady = true;
+        if (!more) armInbox();
+        return;
+
+    case RECV: {
+        Connection* conn = lookup(cqe.user_data);
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            uint16_t bid = cqe.flags >> IORING_CQE_BUFFER_SHIFT;
+            if (conn && cqe.res > 0) {
+                memcpy(conn->parser.prepareFeed(cqe.res), ring.buffer(bid), cqe.res);
+                conn->parser.commitFeed(cqe.res);
+                conn->bytesRead += cqe.res;
+            }
+            ring.recycleBuffer(bid);
+        }
+        if (!conn) return;
+        if (!conn->queuedRead) {
+            conn->queuedRead = true;
+            conn->readResult = ReadResult::Drained;
+            events.readable.push_back(conn);
+        }
+        if (!more) conn->recvArmed = false;
+        if (conn->readResult != ReadResult::Drained) return;
+
+        if (cqe.res == 0) {
+            conn->readResult = ReadResult::Closed;
+        } else if (cqe.res < 0 && cqe.res != -ENOBUFS) {
+            conn->readResult = ReadResult::Failed;
+        } else if (conn->parser.bufferedBytes() > QUERY_BUFFER_LIMIT) {
+            conn->readResult = ReadResult::TooBig;
+        } else if (!conn->recvArmed) {
+            armRecv(conn);  // Stopped (e.g. ENOBUFS: the buffer ring ran dry)
+        }
+        return;
+    }
+
+    case SEND: {
+        Connection* conn = lookup(cqe.user_data);
+        if (!conn) {
+            orphanedSends.erase(cqe.user_data);
+            return;
+        }
+        conn->sendInFlight = false;
+        if (cqe.res == -EAGAIN) {
+            // Socket full and the peer has shut down its side: io_uring
+            // polls report POLLRDHUP whatever was asked for, so its poll
+            // for POLLOUT fires at once and the send gives up. There is no
+            // waiting for POLLOUT alone, so try again in a millisecond
+            retrySendLater(conn);
+            return;
+        }
+        if (cqe.res < 0) {
+            // Broken connection: close it like a failed read
+            if (!conn->queuedRead) {
+                conn->queuedRead = true;
+                events.readable.push_back(conn);
+            }
+            conn->readResult = ReadResult::Failed;
+            return;
+        }
+        conn->reply.consume(cqe.res);
+        if (!conn->reply.empty()) {
+            submitSend(conn);  // Short write: send the rest
+        } else if (conn->closeAfterReply) {
+            events.writable.push_back(conn);  // All sent: the loop can close it now
+        }
+        return;
+    }
+
+    case SEND_RETRY: {
+        Connection* conn = lookup(cqe.user_data);
+        if (!conn) {
+            orphanedSends.erase((cqe.user_data & ~(0xFFULL << 56)) | (uint64_t)SEND << 56);
+            return;
+        }
+        conn->sendInFlight = false;
+        submitSend(conn);
+        return;
+    }
+    }
+}
+
+void UringBackend::flush(const vector<Connection*>& conns) {
+    for (Connection* conn : conns) {
+        if (!conn->sendInFlight && !conn->reply.empty()) submitSend(conn);
+        conn->flushResult = conn->sendInFlight ? OutputBuffer::FlushResult::Pending
+                                               : OutputBuffer::FlushResult::Done;
+    }
+    ring.submit();
+}
@@ -0,0 +1,66 @@
+#include "../include/io_threads.h"
+
+IOThreads::IOThreads(int count) {
+    for (int i = 1; i < count; i++) {
+        workers.emplace_back(new Worker());
+        Worker& worker = *workers.back();
+        worker.th = thread([this, &worker] { workerLoop(worker); });
+    }
+}
+
+IOThreads::~IOThreads() {
+    for (auto& worker : workers) {
+        {
+            lock_guard<mutex> lock(worker->m);
+            worker->stop = true;
+        }
+        worker->cv.notify_one();
+        worker->th.join();
+    }
+}
+
+void IOThreads::process(Connection* conn, Op op) {
+    if (op == Op::Read) {
+        readAndParse(*conn);
+    } else {
+        conn->flushResult = conn->reply.flush(conn->fd);
+    }
+}
+
+void IOThreads::workerLoop(Worker& worker) {
+    unique_lock<mutex> lock(worker.m);
+    while (true) {
+        worker.cv.wait(lock, [&] { return worker.hasWork || worker.stop; });
+        if (worker.stop) return;
+        for (Connection* conn : worker.jobs) process(conn, worker.op);
+        worker.jobs.clear();
+        worker.hasWork = false;
+        remaining.fetch_sub(1, memory_order_release);
+    }
+}
+
+void IOThreads::run(const vector<Connection*>& conns, Op op) {
+    // Waking threads costs more than a few reads saves (Redis also keeps
+    // I/O on the main thread below 2 clients per thread)
+    int threads = count();
+    if (threads == 1 || conns.size() < 2 * (size_t)threads) {
+        for (Connection* conn : conns) process(conn, op);
+        return;
+    }
+
+    remaining.store(threads - 1, memory_order_relaxed);
+    for (int t = 1; t < threads; t++) {
+        Worker& worker = *workers[t - 1];
+        {
+            lock_guard<mutex> lock(worker.m);
+            for (size_t i = t; i < conns.size(); i += threads) worker.jobs.push_back(conns[i]);
+            worker.op = op;
+            worker.hasWork = true;
+        }
+        worker.cv.notify_one();
+    }
+
+    // The main thread takes slot 0, then waits for the workers
+    for (size_t i = 0; i < conns.size(); i += threads) process(conns[i], op);
+    while (remaining.load(memory_order_acquire) > 0) this_thread::yield();
+}
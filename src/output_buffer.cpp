@@ -0,0 +1,119 @@
+#include "../include/output_buffer.h"
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <cerrno>
+#include <cstring>
+#include <algorithm>
+
+void OutputBuffer::append(const char* data, size_t n) {
+    bytes += n;
+
+    // Fill the free space of the last chunk first
+    if (!chunks.empty()) {
+        Chunk& tail = chunks.back();
+        size_t take = min(n, tail.capacity - tail.used);
+        memcpy(tail.data.get() + tail.used, data, take);
+        tail.used += take;
+        data += take;
+        n -= take;
+    }
+    if (n == 0) return;
+
+    // A reply larger than a chunk gets a chunk of its own size (one copy,
+    // one iovec) instead of being split across many
+    Chunk chunk;
+    if (spare.data && n <= spare.capacity) {
+        chunk = std::move(spare);
+    } else {
+        chunk.capacity = max(n, CHUNK_SIZE);
+        chunk.data.reset(new char[chunk.capacity]);
+    }
+    memcpy(chunk.data.get(), data, n);
+    chunk.used = n;
+    chunks.push_back(std::move(chunk));
+}
+
+// Drop the fully written front chunk, keeping one standard chunk for reuse
+void OutputBuffer::releaseFront() {
+    Chunk& front = chunks.front();
+    if (!spare.data && front.capacity == CHUNK_SIZE) {
+        front.used = 0;
+        spare = std::move(front);
+    }
+    chunks.pop_front();
+    sentInFront = 0;
+}
+
+int OutputBuffer::prepareSend(iovec* iov) const {
+    int count = 0;
+    for (size_t i = 0; i < chunks.size() && count < MAX_IOV; i++) {
+        size_t skip = i == 0 ? sentInFront : 0;
+        iov[count].iov_base = chunks[i].data.get() + skip;
+        iov[count].iov_len = chunks[i].used - skip;
+        count++;
+    }
+    return count;
+}
+
+void OutputBuffer::consume(size_t n) {
+    bytes -= n;
+    while (n > 0) {
+        size_t left = chunks.front().used - sentInFront;
+        if (n < left) {
+            sentInFront += n;
+            break;
+        }
+        n -= left;
+        releaseFront();
+    }
+    if (bytes == 0) softLimitSince = -1;
+}
+
+string OutputBuffer::take() {
+    string out;
+    out.reserve(bytes);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        size_t skip = i == 0 ? sentInFront : 0;
+        out.append(chunks[i].data.get() + skip, chunks[i].used - skip);
+    }
+    consume(bytes);
+    return out;
+}
+
+OutputBuffer::FlushResult OutputBuffer::flush(int fd) {
+    while (bytes > 0) {
+        iovec iov[MAX_IOV];
+        int count = prepareSend(iov);
+
+        // sendmsg is writev with flags: MSG_NOSIGNAL turns a closed peer
+        // into EPIPE instead of a process-killing SIGPIPE
+        msghdr msg = {};
+        msg.msg_iov = iov;
+        msg.msg_iovlen = count;
+        ssize_t n = sendmsg(fd, &msg, MSG_NOSIGNAL);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            if (errno == EAGAIN || errno == EWOULDBLOCK) return FlushResult::Pending;
+            return FlushResult::Error;
+        }
+        consume(n);
+    }
+    softLimitSince = -1;
+    return FlushResult::Done;
+}
+
+size_t OutputBuffer::memoryUsage() const {
+    size_t total = spare.capacity;
+    for (const auto& chunk : chunks) total += chunk.capacity;
+    return total;
+}
+
+bool OutputBuffer::overLimit(const OutputLimits& limits, int64_t nowMs) {
+    if (limits.hardBytes && bytes >= limits.hardBytes) return true;
+    if (!limits.softBytes || bytes < limits.softBytes) {
+        softLimitSince = -1;
+        return false;
+    }
+    if (softLimitSince == -1) softLimitSince = nowMs;
+    return nowMs - softLimitSince >= limits.softSeconds * 1000;
+}
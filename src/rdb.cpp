@@ -0,0 +1,414 @@
+#include "../include/rdb.h"
+#include "../include/crc64.h"
+#include "../include/shard.h"
+#include <iostream>
+#include <algorithm>
+#include <iomanip>
+#include <chrono>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+
+static const char MAGIC[] = "RCRDB001";
+static const size_t MAGIC_LEN = sizeof(MAGIC) - 1;
+
+static const uint8_t OPCODE_AUX = 0xFA;
+static const uint8_t OPCODE_RESIZEDB = 0xFB;
+static const uint8_t OPCODE_EXPIRETIME_MS = 0xFC;
+static const uint8_t OPCODE_EOF = 0xFF;
+
+static const uint8_t TYPE_STRING = 0;
+static const uint8_t TYPE_INT = 1;
+
+static const int64_t BGSAVE_RETRY_DELAY_MS = 5000;  // Redis CONFIG_BGSAVE_RETRY_DELAY
+static const size_t RELEASE_CHUNK = 64 * 1024 * 1024;
+
+static std::string tempFileName(pid_t pid) {
+    return "temp-" + std::to_string(pid) + ".rdb";
+}
+
+// Buffered writer; the checksum is taken over each chunk as it goes out
+class SnapshotWriter {
+    int fd;
+    std::string buf;
+    uint64_t crc = 0;
+    bool ok = true;
+
+public:
+    explicit SnapshotWriter(int fd) : fd(fd) { buf.reserve(1 << 20); }
+
+    void flush() {
+        crc = crc64(crc, buf.data(), buf.size());
+        size_t done = 0;
+        while (ok && done < buf.size()) {
+            ssize_t n = write(fd, buf.data() + done, buf.size() - done);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) ok = false;
+            else done += n;
+        }
+        buf.clear();
+    }
+
+    void byte(uint8_t b) { buf.push_back((char)b); }
+
+    void length(uint64_t n) {
+        while (n >= 0x80) {
+            buf.push_back((char)(n | 0x80));
+            n >>= 7;
+        }
+        buf.push_back((char)n);
+    }
+
+    void string(std::string_view s) {
+        length(s.size());
+        buf.append(s);
+        if (buf.size() >= (1 << 20)) flush();
+    }
+
+    void int64(int64_t v) {
+        char bytes[8];
+        memcpy(bytes, &v, 8);  // Little-endian host
+        buf.append(bytes, 8);
+    }
+
+    void integer(int64_t v) { length(((uint64_t)v << 1) ^ (uint64_t)(v >> 63)); }  // Zigzag
+
+    // EOF opcode and the checksum of everything before it
+    bool finish() {
+        byte(OPCODE_EOF);
+        flush();
+        uint64_t sum = crc;
+        int64((int64_t)sum);
+        flush();
+        return ok;
+    }
+};
+
+// Bounds-checked cursor over the mapped file; any read past the end fails
+class SnapshotReader {
+    const char* p;
+    const char* end;
+
+public:
+    bool ok = true;
+
+    SnapshotReader(const char* begin, const char* end) : p(begin), end(end) {}
+
+    const char* position() const { return p; }
+    bool atEnd() const { return p >= end; }
+
+    uint8_t byte() {
+        if (p >= end) { ok = false; return OPCODE_EOF; }
+        return (uint8_t)*p++;
+    }
+
+    uint64_t length() {
+        uint64_t n = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            if (p >= end) break;
+            uint8_t b = (uint8_t)*p++;
+            n |= (uint64_t)(b & 0x7F) << shift;
+            if (!(b & 0x80)) return n;
+        }
+        ok = false;
+        return 0;
+    }
+
+    std::string_view string() {
+        uint64_t n = length();
+        if (!ok || n > (uint64_t)(end - p)) { ok = false; return std::string_view(); }
+        std::string_view s(p, n);
+        p += n;
+        return s;
+    }
+
+    int64_t int64() {
+        if (end - p < 8) { ok = false; return 0; }
+        int64_t v;
+        memcpy(&v, p, 8);
+        p += 8;
+        return v;
+    }
+
+    int64_t integer() {
+        uint64_t z = length();
+        return (int64_t)(z >> 1) ^ -(int64_t)(z & 1);
+    }
+};
+
+// Magic and AUX fields, up to the first other opcode (left unread)
+static bool readHeader(SnapshotReader& in, const char* begin, size_t size, SnapshotInfo& info) {
+    if (size < MAGIC_LEN || memcmp(begin, MAGIC, MAGIC_LEN) != 0) return false;
+    for (size_t i = 0; i < MAGIC_LEN; i++) in.byte();
+    while (in.ok && !in.atEnd() && (uint8_t)*in.position() == OPCODE_AUX) {
+        in.byte();
+        std::string_view name = in.string();
+        std::string_view value = in.string();
+        // Unknown fields are skipped, so newer writers can add some
+        uint64_t n = strtoull(std::string(value).c_str(), nullptr, 10);
+        if (name == "aof-inode") info.aofInode = n;
+        else if (name == "aof-offset") info.aofOffset = n;
+        else if (name == "ctime") info.createdMs = (int64_t)n;
+    }
+    return in.ok;
+}
+
+RDB::RDB(const std::string& filepath) : filename(filepath), lastSaveMs(Storage::getCurrentTimeMs()) {}
+
+RDB::~RDB() {
+    killBackgroundSave();
+}
+
+bool RDB::save(const std::vector<Storage*>& shards, const SnapshotInfo& info, uint64_t dirty) {
+    std::string temp = tempFileName(getpid());
+    int fd = open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        std::cerr << "RDB: could not create " << temp << ": " << strerror(errno) << std::endl;
+        lastSaveOk = false;
+        return false;
+    }
+
+    int64_t now = Storage::getCurrentTimeMs();
+    size_t keys = 0, expiring = 0;
+    for (Storage* storage : shards) {
+        keys += storage->size();
+        expiring += storage->expiresCount();
+    }
+
+    SnapshotWriter out(fd);
+    for (size_t i = 0; i < MAGIC_LEN; i++) out.byte(MAGIC[i]);
+    auto aux = [&](std::string_view name, uint64_t value) {
+        out.byte(OPCODE_AUX);
+        out.string(name);
+        out.string(std::to_string(value));
+    };
+    aux("ctime", now);
+    aux("aof-inode", info.aofInode);
+    aux("aof-offset", info.aofOffset);
+    out.byte(OPCODE_RESIZEDB);
+    out.length(keys);
+    out.length(expiring);
+
+    // Keys expired but not reclaimed yet are left out, as in the AOF rewrite
+    for (Storage* storage : shards) {
+        storage->forEach([&](std::string_view key, const StoredValue& value, int64_t expiresAt) {
+            if (expiresAt != -1) {
+                if (expiresAt <= now) return;
+                out.byte(OPCODE_EXPIRETIME_MS);
+                out.int64(expiresAt);
+            }
+            if (value.encoding() == OBJ_ENCODING_INT) {
+                out.byte(TYPE_INT);
+                out.string(key);
+                out.integer(value.intValue());
+            } else {
+                out.byte(TYPE_STRING);
+                out.string(key);
+                out.string(value.strValue());
+            }
+        });
+    }
+
+    bool ok = out.finish() && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    if (!ok || rename(temp.c_str(), filename.c_str()) != 0) {
+        std::cerr << "RDB: could not write " << filename << ": " << strerror(errno) << std::endl;
+        unlink(temp.c_str());
+        lastSaveOk = false;
+        return false;
+    }
+    dirtyAtLastSave = dirty;
+    lastSaveMs = now;
+    lastSaveOk = true;
+    return true;
+}
+
+bool RDB::bgSave(const std::vector<Storage*>& shards, const SnapshotInfo& info, uint64_t dirty) {
+    if (saveChildPid != -1) return false;
+    lastAttemptMs = Storage::getCurrentTimeMs();
+
+    pid_t pid = fork();
+    if (pid == 0) {
+        // Child: _exit, so the parent's atexit handlers and static
+        // destructors (the AOF writer thread) don't run here
+        _exit(save(shards, info) ? 0 : 1);
+    }
+    if (pid < 0) {
+        std::cerr << "Can't save in background: fork: " << strerror(errno) << std::endl;
+        lastSaveOk = false;
+        return false;
+    }
+    saveChildPid = pid;
+    dirtyAtFork = dirty;
+    std::cout << "Background saving started by pid " << pid << std::endl;
+    return true;
+}
+
+bool RDB::isSaveInProgress() {
+    if (saveChildPid == -1) return false;
+
+    int status;
+    pid_t result = waitpid(saveChildPid, &status, WNOHANG);
+    if (result == 0) return true;  // Still running
+
+    saveChildPid = -1;
+    if (result > 0 && WIFEXITED(status) && WEXITSTATUS(status) == 0) {
+        std::cout << "Background saving terminated with success" << std::endl;
+        dirtyAtLastSave = dirtyAtFork;  // Writes made meanwhile are still unsaved
+        lastSaveMs = Storage::getCurrentTimeMs();
+        lastSaveOk = true;
+    } else {
+        std::cerr << "Background saving error" << std::endl;
+        lastSaveOk = false;
+    }
+    return false;
+}
+
+void RDB::killBackgroundSave() {
+    if (saveChildPid == -1) return;
+    kill(saveChildPid, SIGKILL);
+    waitpid(saveChildPid, nullptr, 0);
+    unlink(tempFileName(saveChildPid).c_str());
+    saveChildPid = -1;
+}
+
+bool RDB::savePointReached(uint64_t dirty) const {
+    int64_t now = Storage::getCurrentTimeMs();
+    if (!lastSaveOk && now - lastAttemptMs < BGSAVE_RETRY_DELAY_MS) return false;
+    for (const SavePoint& point : savePoints) {
+        if (dirty - dirtyAtLastSave >= point.changes && now - lastSaveMs >= point.seconds * 1000) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RDB::LoadStatus RDB::readInfo(SnapshotInfo& info) {
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return LoadStatus::NoFile;
+    char head[4096];
+    ssize_t n = pread(fd, head, sizeof(head), 0);
+    close(fd);
+    SnapshotReader in(head, head + std::max<ssize_t>(n, 0));
+    return readHeader(in, head, std::max<ssize_t>(n, 0), info) ? LoadStatus::Ok : LoadStatus::Corrupt;
+}
+
+RDB::LoadStatus RDB::load(const std::vector<Storage*>& shards) {
+    int fd = open(filename.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) return LoadStatus::NoFile;
+    struct stat st;
+    size_t fileSize = fstat(fd, &st) == 0 ? st.st_size : 0;
+    if (fileSize < MAGIC_LEN + 1 + 8) {
+        close(fd);
+        std::cerr << "RDB: " << filename << " is too short to be a snapshot" << std::endl;
+        return LoadStatus::Corrupt;
+    }
+    void* map = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        std::cerr << "RDB: could not map " << filename << std::endl;
+        return LoadStatus::Corrupt;
+    }
+    madvise(map, fileSize, MADV_SEQUENTIAL);
+    const char* begin = static_cast<const char*>(map);
+    const char* body = begin + fileSize - 8;  // The checksum follows
+    auto start = std::chrono::steady_clock::now();
+
+    // Checksum first, so a damaged file loads nothing. Mapped pages are
+    // given back as they're done with (the page cache keeps them)
+    auto release = [&](size_t from, size_t to) {
+        from &= ~(RELEASE_CHUNK - 1);
+        to = std::min(to, fileSize) & ~(RELEASE_CHUNK - 1);
+        if (to > from) madvise(const_cast<char*>(begin) + from, to - from, MADV_DONTNEED);
+    };
+    uint64_t crc = 0;
+    for (size_t done = 0; done < fileSize - 8; done += RELEASE_CHUNK) {
+        crc = crc64(crc, begin + done, std::min(RELEASE_CHUNK, fileSize - 8 - done));
+        release(done, done + RELEASE_CHUNK);
+    }
+    uint64_t expected;
+    memcpy(&expected, body, 8);
+
+    SnapshotReader in(begin, body);
+    SnapshotInfo info;
+    if (crc != expected || !readHeader(in, begin, fileSize, info)) {
+        munmap(map, fileSize);
+        std::cerr << "RDB: " << filename << (crc != expected ? ": checksum mismatch" : ": not a snapshot")
+                  << ", the file is corrupt" << std::endl;
+        return LoadStatus::Corrupt;
+    }
+
+    // The clock is read once per 4096 keys, as AOF::replay does
+    int64_t now = Storage::getCurrentTimeMs();
+    uint64_t keysLoaded = 0, keysExpired = 0;
+    size_t released = 0;
+    bool sawEof = false;
+    while (in.ok && !in.atEnd()) {
+        uint8_t opcode = in.byte();
+        if (opcode == OPCODE_EOF) {
+            sawEof = true;
+            break;
+        }
+        if (opcode == OPCODE_RESIZEDB) {
+            uint64_t keys = in.length(), expiring = in.length();
+            for (Storage* storage : shards) storage->reserve(keys / shards.size(), expiring / shards.size());
+            continue;
+        }
+        int64_t expiresAt = -1;
+        if (opcode == OPCODE_EXPIRETIME_MS) {
+            expiresAt = in.int64();
+            opcode = in.byte();
+        }
+        std::string_view key = in.string();
+        StoredValue value;
+        if (opcode == TYPE_STRING) {
+            value.setString(in.string());
+        } else if (opcode == TYPE_INT) {
+            value.setInt(in.integer());
+        } else {
+            in.ok = false;
+        }
+        if (!in.ok) break;
+
+        if (((keysLoaded + keysExpired) & 4095) == 0) {
+            Storage::updateCachedClock();
+            now = Storage::getCurrentTimeMs();
+        }
+        if (expiresAt != -1 && expiresAt <= now) {
+            keysExpired++;
+        } else {
+            Storage* storage = shards.size() > 1 ? shards[shardForKey(key, shards.size())] : shards[0];
+            storage->restore(key, std::move(value), expiresAt);
+            keysLoaded++;
+        }
+
+        size_t done = in.position() - begin;
+        if (done >= released + RELEASE_CHUNK) {
+            release(released, done);
+            released = done & ~(RELEASE_CHUNK - 1);
+        }
+    }
+    Storage::disableCachedClock();
+    size_t offset = in.position() - begin;
+    munmap(map, fileSize);
+
+    if (!in.ok || !sawEof || offset != fileSize - 8) {
+        // The checksum matched, so this was written that way
+        std::cerr << "RDB: bad record at offset " << offset << ", after " << keysLoaded
+                  << " keys: the file is corrupt" << std::endl;
+        return LoadStatus::Corrupt;
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "DB loaded from disk: " << keysLoaded << " keys";
+    if (keysExpired > 0) std::cout << " (" << keysExpired << " expired, skipped)";
+    std::cout << " in " << std::fixed << std::setprecision(3) << seconds << "s (" << std::setprecision(0)
+              << keysLoaded / std::max(seconds, 1e-9) << " keys/s, " << std::setprecision(1)
+              << fileSize / std::max(seconds, 1e-9) / (1 << 20) << " MB/s)" << std::defaultfloat << std::endl;
+    return LoadStatus::Ok;
+}
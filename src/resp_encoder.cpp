@@ -1,29 +1,70 @@
 #include "../include/resp_encoder.h"
 
+// Shared ":0\r\n" .. ":9999\r\n", built once: one flat buffer, each entry
+// in a fixed 8-byte slot
+namespace {
+const size_t SLOT = 8;
+
+struct SmallIntegers {
+    char text[SharedReplies::SMALL_INTEGERS * SLOT];
+    uint8_t len[SharedReplies::SMALL_INTEGERS];
+
+    SmallIntegers() {
+        for (int64_t n = 0; n < SharedReplies::SMALL_INTEGERS; n++) {
+            char* slot = text + n * SLOT;
+            slot[0] = ':';
+            char* p = to_chars(slot + 1, slot + SLOT, n).ptr;
+            *p++ = '\r';
+            *p++ = '\n';
+            len[n] = p - slot;
+        }
+    }
+};
+
+const SmallIntegers smallIntegers;
+}
+
+string_view SharedReplies::integer(int64_t n) {
+    return string_view(smallIntegers.text + n * SLOT, smallIntegers.len[n]);
+}
+
 string RESPEncoder::encodeSimpleString(const string& s) {
-    return "+" + s + "\r\n";
+    string out;
+    out.reserve(s.size() + 3);
+    addSimpleString(out, s);
+    return out;
 }
 
 string RESPEncoder::encodeError(const string& s) {
-    return "-" + s + "\r\n";
+    string out;
+    out.reserve(s.size() + 3);
+    addError(out, s);
+    return out;
 }
 
 string RESPEncoder::encodeBulkString(const string& s) {
-    return "$" + to_string(s.size()) + "\r\n" + s + "\r\n";
+    string out;
+    out.reserve(s.size() + 16);
+    addBulkString(out, s);
+    return out;
 }
 
 string RESPEncoder::encodeNull() {
-    return "$-1\r\n";
+    return string(SharedReplies::NULL_BULK);
 }
 
 string RESPEncoder::encodeInteger(int64_t n) {
-    return ":" + to_string(n) + "\r\n";
+    string out;
+    addInteger(out, n);
+    return out;
 }
 
 string RESPEncoder::encodeArray(const vector<string>& arr) {
-    string result = "*" + to_string(arr.size()) + "\r\n";
-    for (const auto& item : arr) {
-        result += encodeBulkString(item);
-    }
-    return result;
+    size_t size = 16;
+    for (const auto& item : arr) size += item.size() + 16;
+    string out;
+    out.reserve(size);
+    addArrayHeader(out, arr.size());
+    for (const auto& item : arr) addBulkString(out, item);
+    return out;
 }
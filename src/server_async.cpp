@@ -1,8 +1,7 @@
-// Linux Async Redis Server with epoll
+// Linux Async Redis Server with epoll (or io_uring)
 // Handles 20,000+ concurrent clients
 
 #include <sys/socket.h>
-#include <sys/epoll.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
@@ -10,18 +9,28 @@
 #include <signal.h>
 #include <atomic>
 #include <cerrno>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
 
 #include <iostream>
 #include <string>
-#include <map>
 #include <vector>
 #include <chrono>
 #include <algorithm>
-#include "../include/resp_parser.h"
+#include <memory>
+#include <thread>
+#include <sstream>
+#include "../include/connection.h"
+#include "../include/io_threads.h"
+#include "../include/event_backend.h"
 #include "../include/resp_encoder.h"
 #include "../include/command_handler.h"
 #include "../include/storage.h"
 #include "../include/aof.h"
+#include "../include/rdb.h"
+#include "../include/shard.h"
 using namespace std;
 using namespace std::chrono;
 
@@ -39,13 +48,95 @@ void signalHandler(int signum) {
 // Global storage (single-threaded, no mutex needed!)
 Storage storage;
 AOF aof("appendonly.aof");
+RDB rdb("dump.rdb");
 
-// Active expiration timer
-auto lastCleanupTime = steady_clock::now();
-const auto cleanupInterval = seconds(1);  // Run every 1 second
+// Active expiration interval
+const auto cleanupInterval = milliseconds(100);  // 10 times per second (Redis hz 10)
 
 const string HOST = "0.0.0.0";
-const int PORT = 7379;
+int port = 7379;       // --port
+int ioThreadCount = 1; // --io-threads (includes the main thread)
+int shardCount = 1;    // --shards
+bool useIoUring = false; // --io-uring yes (falls back to epoll if the kernel can't)
+string appendFsync = "everysec"; // --appendfsync always|everysec|no
+string saveConfig = "3600 1 300 100 60 10000"; // --save (Redis's default save points)
+size_t maxMemory = 0;  // --maxmemory (0 = no limit), split evenly over the shards
+string maxMemoryPolicy = "allkeys-lru"; // --maxmemory-policy
+
+// Keyspace shard (thread-per-core mode, --shards N): each shard is an event
+// loop thread owning the keys that hash to it (its own Storage) and
+// accepting on its own SO_REUSEPORT listener, so shards share nothing on
+// the command path. A command for another shard's key is forwarded to that
+// shard's inbox and the reply comes back the same way. With one shard the
+// loop runs on the main thread over the global storage.
+struct Shard {
+    int id = 0;
+    Storage* storage = nullptr;
+    ShardInbox inbox;
+    vector<vector<ShardMessage>> outbox;  // Per destination shard, posted once per iteration
+};
+vector<unique_ptr<Shard>> shards;
+vector<unique_ptr<Storage>> shardStorage;  // Storage of shards 1..N-1
+
+// Value of an integer reply (":3\r\n"), 0 for anything else
+int64_t replyInteger(const string& reply) {
+    int64_t n = 0;
+    if (reply.size() > 3 && reply[0] == ':') RespParser::parseInt(reply.data() + 1, reply.data() + reply.size() - 2, n);
+    return n;
+}
+
+// Owned copy of a command's arguments, to send to another shard (its
+// views point into this connection's query buffer)
+RespValue materialize(CommandArgs args) {
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    cmd.arr_value.resize(args.size());
+    for (size_t i = 0; i < args.size(); i++) {
+        cmd.arr_value[i].type = RespType::BulkString;
+        cmd.arr_value[i].str_value.assign(args[i].data(), args[i].size());
+    }
+    return cmd;
+}
+
+// Commands whose first argument is not a key (run on the receiving shard)
+bool isKeyless(string_view name) {
+    return equalsIgnoreCase(name, "PING") || equalsIgnoreCase(name, "INFO") || equalsIgnoreCase(name, "BGREWRITEAOF") ||
+           equalsIgnoreCase(name, "SAVE") || equalsIgnoreCase(name, "BGSAVE");
+}
+
+// Save points as in redis.conf: "<seconds> <changes> ...", "" = none
+bool parseSavePoints(const string& spec, vector<SavePoint>& points) {
+    istringstream in(spec);
+    long long seconds, changes;
+    points.clear();
+    while (in >> seconds) {
+        if (!(in >> changes) || seconds <= 0 || changes < 0) return false;
+        points.push_back({seconds, (uint64_t)changes});
+    }
+    return in.eof();
+}
+
+// Memory size as in redis.conf: "1000", "100mb", "1gb", "512k" (k/m/g are
+// powers of 1000, kb/mb/gb powers of 1024; any case)
+bool parseMemory(const string& spec, size_t& bytes) {
+    size_t digits = 0;
+    while (digits < spec.size() && spec[digits] >= '0' && spec[digits] <= '9') digits++;
+    if (digits == 0 || digits > 18) return false;
+    string unit = spec.substr(digits);
+    for (char& c : unit) c = (char)tolower((unsigned char)c);
+    static const pair<const char*, size_t> units[] = {
+        {"", 1}, {"b", 1}, {"k", 1000}, {"kb", 1024}, {"m", 1000 * 1000}, {"mb", 1024 * 1024},
+        {"g", 1000ULL * 1000 * 1000}, {"gb", 1024ULL * 1024 * 1024},
+    };
+    for (const auto& [name, multiplier] : units) {
+        if (unit != name) continue;
+        size_t n = strtoull(spec.substr(0, digits).c_str(), nullptr, 10);
+        if (n > SIZE_MAX / multiplier) return false;
+        bytes = n * multiplier;
+        return true;
+    }
+    return false;
+}
 
 // Set socket to non-blocking mode
 void setNonBlocking(int sock) {
@@ -53,165 +144,523 @@ void setNonBlocking(int sock) {
     fcntl(sock, F_SETFL, flags | O_NONBLOCK);
 }
 
-// Read from socket (non-blocking)
-string readFromSocket(int sock) {
-    char buf[512];
-    int n = recv(sock, buf, 512, 0);
-    if (n <= 0) return "";
-    return string(buf, buf + n);
-}
+// Log every connect/disconnect (verbose; off so that connection churn
+// doesn't write to the terminal per client)
+const bool LOG_CONNECTIONS = false;
 
-// Write to socket
-void writeToSocket(int sock, const string& data) {
-    send(sock, data.c_str(), data.size(), 0);
-}
+// Reply buffer limits for normal clients
+const OutputLimits clientOutputLimits;
 
-// Run async server with epoll
-void runAsyncServer() {
-    cout << "\033[1;33m[Linux] Using epoll - Max 20,000+ clients\033[0m" << endl;
+// Run async server (one per shard)
+void runAsyncServer(Shard& shard) {
+    Storage& storage = *shard.storage;
+    const bool sharded = shards.size() > 1;
     
     // Create server socket
     int serverSock = socket(AF_INET, SOCK_STREAM, 0);
     setNonBlocking(serverSock);
+    int reuse = 1;
+    setsockopt(serverSock, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+    if (sharded) {
+        // Every shard listens on the port; the kernel spreads connections
+        setsockopt(serverSock, SOL_SOCKET, SO_REUSEPORT, &reuse, sizeof(reuse));
+    }
     
     // Bind to port
     sockaddr_in addr = {};
     addr.sin_family = AF_INET;
-    addr.sin_port = htons(PORT);
+    addr.sin_port = htons(port);
     inet_pton(AF_INET, HOST.c_str(), &addr.sin_addr);
     
     bind(serverSock, (sockaddr*)&addr, sizeof(addr));
-    listen(serverSock, 10);
-    
-    // Create epoll instance
-    int epollFd = epoll_create1(0);
-    
-    // Add server socket to epoll
-    epoll_event ev;
-    ev.events = EPOLLIN | EPOLLET;  // Edge-triggered
-    ev.data.fd = serverSock;
-    epoll_ctl(epollFd, EPOLL_CTL_ADD, serverSock, &ev);
+    listen(serverSock, 511);  // Redis tcp-backlog
     
     // Track clients
-    map<int, RespParser> parsers;
+    ConnectionTable connections;
     CommandHandler handler(storage);
-    epoll_event events[100];
+    IOThreads ioThreads(sharded || useIoUring ? 1 : ioThreadCount);
+    uint64_t nextConnId = 1;
+    auto lastCleanupTime = steady_clock::now();
+    
+    // Network backend: io_uring if asked for and the kernel has it, else epoll
+    unique_ptr<EventBackend> backend;
+    if (useIoUring) {
+        unique_ptr<UringBackend> uring(new UringBackend(connections));
+        if (uring->init()) {
+            backend = std::move(uring);
+        } else if (shard.id == 0) {
+            cout << "\033[1;33mio_uring unavailable (" << strerror(errno) << "), using epoll\033[0m" << endl;
+        }
+    }
+    if (!backend) backend.reset(new EpollBackend(ioThreads));
+    
+    // Messages from other shards wake the loop through the inbox eventfd
+    backend->watch(serverSock, sharded ? shard.inbox.eventFd() : -1);
+    vector<ShardMessage> inbox;
+    LoopEvents events;
+    vector<Connection*> writable;  // This iteration's write batch
+    
+    auto closeClient = [&](Connection* conn, const string& reason, bool always = false) {
+        if (always || LOG_CONNECTIONS) {
+            cout << "✗ Client " << reason << " (Total: " << connections.size() - 1 << ")" << endl;
+        }
+        backend->removeClient(conn);
+        close(conn->fd);
+        connections.remove(conn->fd);  // Frees conn
+    };
+    
+    // Act on a flush (run by the write phase): drop broken clients and
+    // ones over the output limits. Returns false if the client was closed
+    auto afterFlush = [&](Connection* conn) {
+        if (conn->flushResult == OutputBuffer::FlushResult::Error) {
+            closeClient(conn, "disconnected");
+            return false;
+        }
+        if (conn->reply.overLimit(clientOutputLimits, Storage::getCurrentTimeMs())) {
+            closeClient(conn, "closed for overcoming output buffer limits ("
+                        + to_string(conn->reply.pending()) + " bytes pending)", true);
+            return false;
+        }
+        if (conn->closeAfterReply && conn->pendingReplies.empty() &&
+            conn->flushResult == OutputBuffer::FlushResult::Done) {
+            closeClient(conn, "disconnected");
+            return false;
+        }
+        return true;
+    };
+    
+    // Queue a connection for the write phase (at most once per iteration)
+    auto queueWrite = [&](Connection* conn) {
+        if (!conn->queuedWrite) {
+            conn->queuedWrite = true;
+            writable.push_back(conn);
+        }
+    };
     
-    cout << "\033[1;32mServer ready on port " << PORT << "\033[0m" << endl;
+    // Run one command on this shard's storage, appending its reply to out.
+    // frame: the command's bytes as the client sent them, if known
+    string aofBuf;               // This iteration's AOF batch (shards share the file)
+    vector<string_view> aofArgs;
+    vector<string_view> argv;    // Views of the running client command (reused)
+    vector<string_view> forwardedArgv;  // Views of a command from another shard
+    OutputBuffer scratch;  // Replies that can't go straight to a client
+    
+    // Where a snapshot taken now ends in the AOF: this iteration's writes
+    // so far are in the keyspace, so they go to the file first
+    auto snapshotInfo = [&]() {
+        aof.isRewriteInProgress();  // A finished rewrite: record the new file, not the replaced one
+        aof.flush(aofBuf);
+        SnapshotInfo info;
+        aof.position(info.aofInode, info.aofOffset);
+        return info;
+    };
+    
+    auto runLocal = [&](CommandArgs args, OutputBuffer& out, string_view frame = string_view()) {
+        uint64_t dirtyBefore = handler.dirtyCount();
+        string_view name = args[0];
+        
+        // Check for BGREWRITEAOF command (handled separately)
+        if (equalsIgnoreCase(name, "BGREWRITEAOF")) {
+            if (sharded) {
+                // The forked child would snapshot shards mid-command
+                RESPEncoder::addError(out, "ERR BGREWRITEAOF is not supported with --shards");
+            } else if (rdb.isSaveInProgress()) {
+                // One forked child at a time (each doubles memory in the worst case)
+                RESPEncoder::addError(out, "ERR Background save in progress");
+            } else if (aof.bgRewriteAOF(storage)) {
+                RESPEncoder::addSimpleString(out, "Background AOF rewrite started");
+            } else {
+                RESPEncoder::addError(out, "ERR rewrite already in progress");
+            }
+        } else if (equalsIgnoreCase(name, "SAVE") || equalsIgnoreCase(name, "BGSAVE")) {
+            // Snapshot to dump.rdb: SAVE blocks the loop, BGSAVE forks
+            if (sharded) {
+                RESPEncoder::addError(out, "ERR SAVE and BGSAVE are not supported with --shards");
+            } else if (rdb.isSaveInProgress()) {
+                RESPEncoder::addError(out, "ERR Background save already in progress");
+            } else if (equalsIgnoreCase(name, "SAVE")) {
+                if (rdb.save({&storage}, snapshotInfo(), handler.dirtyCount())) {
+                    RESPEncoder::addSimpleString(out, "OK");
+                } else {
+                    RESPEncoder::addError(out, "ERR could not write the snapshot");
+                }
+            } else if (aof.isRewriteInProgress()) {
+                RESPEncoder::addError(out, "ERR Another child process is active (AOF rewrite)");
+            } else if (rdb.bgSave({&storage}, snapshotInfo(), handler.dirtyCount())) {
+                RESPEncoder::addSimpleString(out, "Background saving started");
+            } else {
+                RESPEncoder::addError(out, "ERR could not fork for the background save");
+            }
+        } else {
+            handler.handleCommand(args, out);
+        }
+        
+        // Log to this loop's AOF buffer (written out once per iteration) if
+        // it changed the keyspace: the received bytes, copied as they are,
+        // unless the handler rewrote it (relative TTLs made absolute).
+        // Commands that arrived inline, or from another shard, are encoded
+        if (handler.dirtyCount() == dirtyBefore) return;
+        if (!handler.rewrittenCommand().empty()) {
+            aofBuf.append(handler.rewrittenCommand());
+        } else if (!frame.empty()) {
+            aofBuf.append(frame);
+        } else {
+            aofArgs.assign(args.begin(), args.end());
+            AOF::feed(aofBuf, aofArgs);
+        }
+    };
+    auto runToString = [&](CommandArgs args) {
+        runLocal(args, scratch);
+        return scratch.take();
+    };
+    
+    // Sharded mode: reply slots. A reply goes straight to the output
+    // buffer unless an earlier cross-shard reply is still outstanding
+    auto addReply = [&](Connection* conn, string reply) {
+        if (conn->pendingReplies.empty()) {
+            conn->reply.append(reply);
+        } else {
+            conn->pendingReplies.push_back({std::move(reply)});
+        }
+    };
+    auto runAndReply = [&](Connection* conn, CommandArgs args, string_view frame) {
+        if (conn->pendingReplies.empty()) {
+            runLocal(args, conn->reply, frame);
+        } else {
+            runLocal(args, scratch, frame);
+            conn->pendingReplies.push_back({scratch.take()});
+        }
+    };
+    auto openSlot = [&](Connection* conn, int waiting, bool sumIntegers, int64_t sum) {
+        conn->pendingReplies.push_back({"", waiting, sumIntegers, sum});
+        return conn->firstPendingSlot + conn->pendingReplies.size() - 1;
+    };
+    auto releaseReplies = [&](Connection* conn) {
+        size_t ready = 0;
+        for (PendingReply& p : conn->pendingReplies) {
+            if (p.waiting > 0) break;
+            conn->reply.append(p.sumIntegers ? RESPEncoder::encodeInteger(p.sum) : p.reply);
+            ready++;
+        }
+        conn->pendingReplies.erase(conn->pendingReplies.begin(), conn->pendingReplies.begin() + ready);
+        conn->firstPendingSlot += ready;
+    };
+    auto forward = [&](Connection* conn, int owner, uint64_t slot, RespValue&& cmd) {
+        ShardMessage msg;
+        msg.origin = shard.id;
+        msg.fd = conn->fd;
+        msg.connId = conn->id;
+        msg.slot = slot;
+        msg.cmd = std::move(cmd);
+        shard.outbox[owner].push_back(std::move(msg));
+    };
+    
+    // Route a command to the shard(s) owning its keys. Only commands that
+    // leave this shard are copied out of the query buffer
+    auto dispatch = [&](Connection* conn, CommandArgs args, string_view frame) {
+        string_view name = args[0];
+        if (args.size() < 2 || isKeyless(name)) {
+            runAndReply(conn, args, frame);
+            return;
+        }
+        
+        if (equalsIgnoreCase(name, "DEL") && args.size() > 2) {
+            // Multi-key DEL: one partial DEL per owning shard, counts summed
+            vector<vector<string_view>> parts(shards.size());
+            for (size_t i = 1; i < args.size(); i++) {
+                vector<string_view>& part = parts[shardForKey(args[i], shards.size())];
+                if (part.empty()) part.push_back(name);
+                part.push_back(args[i]);
+            }
+            int remote = 0;
+            int64_t localCount = 0;
+            for (size_t s = 0; s < parts.size(); s++) {
+                if (parts[s].empty()) continue;
+                if ((int)s == shard.id) {
+                    localCount = replyInteger(runToString(CommandArgs(parts[s].data(), parts[s].size())));
+                } else {
+                    remote++;
+                }
+            }
+            if (remote == 0) {
+                addReply(conn, RESPEncoder::encodeInteger(localCount));
+                return;
+            }
+            uint64_t slot = openSlot(conn, remote, true, localCount);
+            for (size_t s = 0; s < parts.size(); s++) {
+                if ((int)s != shard.id && !parts[s].empty()) {
+                    forward(conn, s, slot, materialize(CommandArgs(parts[s].data(), parts[s].size())));
+                }
+            }
+            return;
+        }
+        
+        int owner = shardForKey(args[1], shards.size());
+        if (owner == shard.id) {
+            runAndReply(conn, args, frame);
+        } else {
+            forward(conn, owner, openSlot(conn, 1, false, 0), materialize(args));
+        }
+    };
+    
+    // Run a connection's parsed commands, straight from its query buffer
+    auto execute = [&](Connection* conn) {
+        for (size_t i = 0; i < conn->commands.size(); i++) {
+            CommandArgs args = conn->args(i, argv);
+            if (sharded) {
+                dispatch(conn, args, conn->frame(i));
+            } else {
+                runLocal(args, conn->reply, conn->frame(i));
+            }
+            conn->commandsProcessed++;
+        }
+        conn->clearCommands();
+    };
+    
+    // Sharded mode: run commands forwarded by other shards, and deliver
+    // replies to ours
+    auto drainInbox = [&]() {
+        shard.inbox.take(inbox);
+        for (ShardMessage& msg : inbox) {
+            if (msg.kind == ShardMessage::Kind::Request) {
+                msg.kind = ShardMessage::Kind::Reply;
+                forwardedArgv.clear();
+                for (const RespValue& arg : msg.cmd.arr_value) forwardedArgv.push_back(arg.str_value);
+                msg.reply = runToString(CommandArgs(forwardedArgv.data(), forwardedArgv.size()));
+                msg.cmd = RespValue();
+                shard.outbox[msg.origin].push_back(std::move(msg));
+                continue;
+            }
+            Connection* conn = connections.get(msg.fd);
+            if (!conn || conn->id != msg.connId) continue;  // Client gone
+            PendingReply& slot = conn->pendingReplies[msg.slot - conn->firstPendingSlot];
+            if (slot.sumIntegers) {
+                slot.sum += replyInteger(msg.reply);
+            } else {
+                slot.reply = std::move(msg.reply);
+            }
+            if (--slot.waiting == 0) {
+                releaseReplies(conn);
+                if (!conn->reply.empty()) queueWrite(conn);
+            }
+        }
+    };
+    
+    if (shard.id == 0) {
+        if (sharded) {
+            cout << "\033[1;33mShards: " << shards.size() << " (one event loop thread each)\033[0m" << endl;
+        } else {
+            cout << "\033[1;33mI/O threads: " << ioThreads.count() << "\033[0m" << endl;
+        }
+        cout << "\033[1;33mEvent backend: " << backend->name() << "\033[0m" << endl;
+        cout << "\033[1;32mServer ready on port " << port << "\033[0m" << endl;
+    }
+    
+    Storage::updateCachedClock();
     
     // Main event loop - run until shutdown requested
     while (!shutdownRequested.load()) {
-        // Active expiration - check every 1 second
+        // Active expiration - every 100ms, bounded by the slow cycle budget
         auto now = steady_clock::now();
         if (now - lastCleanupTime >= cleanupInterval) {
             storage.deleteExpiredKeys();
+            storage.incrementallyRehash();
             lastCleanupTime = now;
+            
+            // Reap a finished BGREWRITEAOF (the AOF is reopened on the new
+            // file, which replaced the one still open) and a finished
+            // BGSAVE; start a BGSAVE when a save point is reached
+            bool rewriting = aof.isRewriteInProgress();
+            if (!sharded && !rdb.isSaveInProgress() && !rewriting && rdb.savePointReached(handler.dirtyCount())) {
+                cout << rdb.changesSinceSave(handler.dirtyCount()) << " changes since the last save, saving..." << endl;
+                rdb.bgSave({&storage}, snapshotInfo(), handler.dirtyCount());
+            }
         }
         
-        // Wait for events with timeout (so we can check shutdown flag)
-        int nfds = epoll_wait(epollFd, events, 100, 1000);  // 1 second timeout
+        // Keep draining a mass expiry between events (no-op unless the
+        // last expire cycle ran out of time)
+        storage.activeExpireCycle(ExpireCycle::FAST);
         
-        if (nfds == -1) {
-            if (errno == EINTR) {
-                // Interrupted by signal, check shutdown flag
-                continue;
-            }
-            break;
-        }
+        // Wait for events with timeout (so we can check shutdown flag).
+        // Readable clients come back already read and parsed
+        events.clear();
+        writable.clear();
+        if (!backend->poll(events, 100)) break;  // Wake up for the cron tick
+        Storage::updateCachedClock();  // One clock read for everything this iteration
         
-        for (int i = 0; i < nfds; i++) {
-            if (events[i].data.fd == serverSock) {
-                // New client connection
+        // New client connections
+        for (int fd : events.accepted) {
+            Connection* added = connections.add(fd);
+            added->id = nextConnId++;
+            added->createdMs = added->lastInteractionMs = Storage::getCurrentTimeMs();
+            backend->addClient(added);
+            
+            if (LOG_CONNECTIONS) {
                 sockaddr_in clientAddr;
                 socklen_t len = sizeof(clientAddr);
-                int newClient = accept(serverSock, (sockaddr*)&clientAddr, &len);
-                
-                if (newClient >= 0) {
-                    setNonBlocking(newClient);
-                    
-                    // Add to epoll
-                    ev.events = EPOLLIN | EPOLLET;
-                    ev.data.fd = newClient;
-                    epoll_ctl(epollFd, EPOLL_CTL_ADD, newClient, &ev);
-                    
-                    parsers[newClient] = RespParser();
-                    
-                    char ip[16];
-                    inet_ntop(AF_INET, &clientAddr.sin_addr, ip, 16);
-                    cout << "✓ Client connected: " << ip << " (Total: " << parsers.size() << ")" << endl;
-                }
-            } else {
-                // Existing client has data
-                int clientFd = events[i].data.fd;
-                string msg = readFromSocket(clientFd);
-                
-                if (msg.empty()) {
-                    // Client disconnected
-                    cout << "✗ Client disconnected (Total: " << parsers.size() - 1 << ")" << endl;
-                    epoll_ctl(epollFd, EPOLL_CTL_DEL, clientFd, nullptr);
-                    close(clientFd);
-                    parsers.erase(clientFd);
-                } else {
-                    // Process ALL commands in buffer (pipelining support)
-                    string allResponses;
-                    int pos = 0;
-                    
-                    // Loop through all commands in the message
-                    while (pos < msg.size()) {
-                        RespValue cmd = parsers[clientFd].decodeInternal(msg, pos);
-                        
-                        // Check for BGREWRITEAOF command (handled separately)
-                        string response;
-                        if (cmd.type == RespType::Array && !cmd.arr_value.empty()) {
-                            string cmdName = cmd.arr_value[0].str_value;
-                            transform(cmdName.begin(), cmdName.end(), cmdName.begin(), ::toupper);
-                            
-                            if (cmdName == "BGREWRITEAOF") {
-                                if (aof.bgRewriteAOF(storage)) {
-                                    response = RESPEncoder::encodeSimpleString("Background AOF rewrite started");
-                                } else {
-                                    response = RESPEncoder::encodeError("ERR rewrite already in progress");
-                                }
-                            } else {
-                                response = handler.handleCommand(cmd);
-                            }
-                        } else {
-                            response = handler.handleCommand(cmd);
-                        }
-                        
-                        // Log to AOF
-                        if (cmd.type == RespType::Array) {
-                            std::vector<std::string> command;
-                            for (const auto& val : cmd.arr_value) {
-                                command.push_back(val.str_value);
-                            }
-                            aof.log(command);
-                        }
-                        
-                        allResponses += response;
-                    }
-                    
-                    writeToSocket(clientFd, allResponses);
-                }
+                getpeername(fd, (sockaddr*)&clientAddr, &len);
+                char ip[16];
+                inet_ntop(AF_INET, &clientAddr.sin_addr, ip, 16);
+                cout << "✓ Client connected: " << ip << " (Total: " << connections.size() << ")" << endl;
             }
         }
+        for (Connection* conn : events.writable) queueWrite(conn);
+        
+        // Execute phase, main thread only
+        for (Connection* conn : events.readable) {
+            if (conn->readResult == ReadResult::Failed) {
+                closeClient(conn, "disconnected");
+                continue;
+            }
+            if (conn->readResult == ReadResult::TooBig) {
+                closeClient(conn, "closed for overcoming query buffer limits ("
+                            + to_string(conn->parser.bufferedBytes()) + " bytes)", true);
+                continue;
+            }
+            if (!conn->commands.empty()) conn->lastInteractionMs = Storage::getCurrentTimeMs();
+            execute(conn);
+            
+            if (conn->parseStatus == ParseStatus::Error) {
+                // Unparseable stream: reply and drop the client (as Redis does)
+                RESPEncoder::addError(conn->reply, "ERR " + conn->parser.error());
+                aof.flush(aofBuf);  // Its earlier writes are logged before they're acknowledged
+                if (!conn->sendInFlight) conn->reply.flush(conn->fd);
+                closeClient(conn, "sent a bad request: " + conn->parser.error());
+            } else if (conn->readResult == ReadResult::Closed) {
+                // Peer shut down its side after its last commands: they
+                // ran above; the write phase closes it once the replies
+                // (cross-shard ones included) are out
+                conn->closeAfterReply = true;
+                queueWrite(conn);
+            } else if (!conn->reply.empty()) {
+                queueWrite(conn);
+            }
+        }
+        
+        // Cross-shard traffic: run forwarded commands, deliver replies, then
+        // send this iteration's messages (one inbox lock per destination).
+        // The AOF batch is written first: replies to other shards and our
+        // clients must not go out before the writes they acknowledge
+        if (events.inboxReady) drainInbox();
+        aof.flush(aofBuf);
+        for (size_t s = 0; s < shard.outbox.size(); s++) {
+            if (!shard.outbox[s].empty()) shards[s]->inbox.post(shard.outbox[s]);
+        }
+        
+        // Write phase: flush replies (epoll: spread over the I/O threads)
+        backend->flush(writable);
+        for (Connection* conn : writable) {
+            conn->queuedWrite = false;
+            afterFlush(conn);
+        }
     }
     
     // Cleanup on shutdown
-    cout << "\033[1;33m🔄 Flushing data to disk...\033[0m" << endl;
+    if (shard.id == 0) cout << "\033[1;33m🔄 Flushing data to disk...\033[0m" << endl;
     
-    // Close all client connections
-    for (const auto& pair : parsers) {
-        close(pair.first);
+    // With save points, unsaved changes are snapshotted before exiting (a
+    // BGSAVE still running is abandoned for it, as Redis does)
+    if (!sharded && rdb.hasSavePoints() && rdb.changesSinceSave(handler.dirtyCount()) > 0) {
+        rdb.killBackgroundSave();
+        cout << "Saving the final snapshot before exiting" << endl;
+        rdb.save({&storage}, snapshotInfo(), handler.dirtyCount());
     }
     
-    cout << "\033[1;32m✓ Graceful shutdown complete\033[0m" << endl;
+    // Close all client connections
+    connections.forEach([](const Connection& conn) { close(conn.fd); });
     
     close(serverSock);
-    close(epollFd);
 }
 
-int main() {
+// Restore the keyspace: the snapshot, then the AOF written after it (each
+// key on its shard). The snapshot records the AOF file it was taken
+// against and how much of it it holds; if that file has been replaced
+// since (BGREWRITEAOF) or cut shorter, the AOF alone is the data. With an
+// empty AOF the snapshot alone is
+bool loadDataFromDisk() {
+    vector<Storage*> storages;
+    for (auto& shard : shards) storages.push_back(shard->storage);
+    
+    uint64_t aofInode = 0, aofSize = 0, aofFrom = 0;
+    aof.position(aofInode, aofSize);
+    SnapshotInfo info;
+    RDB::LoadStatus status = rdb.readInfo(info);
+    if (status == RDB::LoadStatus::Ok) {
+        bool covers = info.aofInode == aofInode && info.aofOffset <= aofSize;
+        if (covers || aofSize == 0) {
+            status = rdb.load(storages);
+            if (covers) aofFrom = info.aofOffset;
+        } else {
+            cout << "dump.rdb was taken against another AOF file, loading the AOF only" << endl;
+        }
+    }
+    if (status == RDB::LoadStatus::Corrupt) {
+        cerr << "\033[1;31mCould not load dump.rdb, exiting (move it away to start from the AOF alone)\033[0m" << endl;
+        return false;
+    }
+    
+    vector<unique_ptr<CommandHandler>> loaders;
+    for (Storage* storage : storages) loaders.emplace_back(new CommandHandler(*storage));
+    bool loaded = aof.replay([&loaders](string_view key) -> CommandHandler& {
+        return *loaders[shardForKey(key, loaders.size())];
+    }, aofFrom);
+    if (!loaded) {
+        cerr << "\033[1;31mCould not load the AOF, exiting\033[0m" << endl;
+        return false;
+    }
+    return true;
+}
+
+int main(int argc, char* argv[]) {
+    // Options: --port N, --io-threads N, --shards N, --io-uring yes|no,
+    // --appendfsync always|everysec|no, --aof-load-truncated yes|no,
+    // --save "<seconds> <changes> ...", --maxmemory <bytes>[k|kb|m|mb|g|gb],
+    // --maxmemory-policy <policy> (as redis-server accepts config on the
+    // command line)
+    for (int i = 1; i + 1 < argc; i += 2) {
+        string opt = argv[i];
+        if (opt == "--port") {
+            port = atoi(argv[i + 1]);
+        } else if (opt == "--io-threads") {
+            ioThreadCount = max(1, min(128, atoi(argv[i + 1])));
+        } else if (opt == "--shards") {
+            shardCount = max(1, min(256, atoi(argv[i + 1])));
+        } else if (opt == "--io-uring") {
+            useIoUring = string(argv[i + 1]) == "yes";
+        } else if (opt == "--appendfsync") {
+            appendFsync = argv[i + 1];
+            if (!aof.setSyncMode(appendFsync)) {
+                cerr << "Invalid --appendfsync: " << appendFsync << endl;
+                return 1;
+            }
+        } else if (opt == "--aof-load-truncated") {
+            aof.setLoadTruncated(string(argv[i + 1]) == "yes");
+        } else if (opt == "--save") {
+            saveConfig = argv[i + 1];
+        } else if (opt == "--maxmemory") {
+            if (!parseMemory(argv[i + 1], maxMemory)) {
+                cerr << "Invalid --maxmemory: " << argv[i + 1] << " (expected e.g. 100mb)" << endl;
+                return 1;
+            }
+        } else if (opt == "--maxmemory-policy") {
+            maxMemoryPolicy = argv[i + 1];
+            if (!storage.setEvictionPolicy(maxMemoryPolicy)) {
+                cerr << "Invalid --maxmemory-policy: " << maxMemoryPolicy << endl;
+                return 1;
+            }
+        } else {
+            cerr << "Unknown option: " << opt << endl;
+            return 1;
+        }
+    }
+    
+    vector<SavePoint> savePoints;
+    if (!parseSavePoints(saveConfig, savePoints)) {
+        cerr << "Invalid --save: \"" << saveConfig << "\" (expected \"<seconds> <changes> ...\")" << endl;
+        return 1;
+    }
+    rdb.setSavePoints(savePoints);
+    
     // Display RED REDIS banner
     cout << "\033[1;31m" << endl;
     cout << "██████╗ ███████╗██████╗     ██████╗ ███████╗██████╗ ██╗███████╗" << endl;
@@ -222,7 +671,7 @@ int main() {
     cout << "╚═╝  ╚═╝╚══════╝╚═════╝     ╚═╝  ╚═╝╚══════╝╚═════╝ ╚═╝╚══════╝" << endl;
     cout << "\033[0m" << endl;
     cout << "\033[1;33mRedis Clone - Async Server v1.0 (Linux)\033[0m" << endl;
-    cout << "\033[1;33mPort: " << PORT << "\033[0m" << endl;
+    cout << "\033[1;33mPort: " << port << "\033[0m" << endl;
     cout << "\033[1;32mReady to accept connections...\033[0m" << endl;
     cout << "\033[1;33mPress Ctrl+C for graceful shutdown\033[0m" << endl;
     cout << endl;
@@ -231,11 +680,44 @@ int main() {
     signal(SIGINT, signalHandler);   // Ctrl+C
     signal(SIGTERM, signalHandler);  // kill command
     
-    // Replay AOF to restore data
-    aof.replay(storage);
+    cout << "\033[1;33m[Linux] Using " << (useIoUring ? "io_uring" : "epoll") << " - Max 20,000+ clients\033[0m" << endl;
+    cout << "\033[1;33mAOF fsync: " << appendFsync << "\033[0m" << endl;
+    cout << "\033[1;33mSave points: " << (saveConfig.empty() ? "none" : saveConfig) << "\033[0m" << endl;
+    if (maxMemory) {
+        cout << "\033[1;33mMaxmemory: " << maxMemory << " bytes (" << maxMemoryPolicy << ")\033[0m" << endl;
+    }
+    if (shardCount > 1 && ioThreadCount > 1) {
+        cout << "\033[1;33m--io-threads is ignored with --shards (each shard does its own I/O)\033[0m" << endl;
+    } else if (useIoUring && ioThreadCount > 1) {
+        cout << "\033[1;33m--io-threads is ignored with --io-uring (the kernel does the I/O)\033[0m" << endl;
+    }
+    
+    // Shard 0 uses the global storage. Keys spread evenly over the shards
+    // (by hash), so each gets an even share of the memory limit
+    for (int i = 0; i < shardCount; i++) {
+        shards.emplace_back(new Shard());
+        shards[i]->id = i;
+        if (i == 0) {
+            shards[i]->storage = &storage;
+        } else {
+            shardStorage.emplace_back(new Storage());
+            shards[i]->storage = shardStorage.back().get();
+        }
+        shards[i]->storage->setMaxMemory(maxMemory / shardCount);
+        shards[i]->storage->setEvictionPolicy(maxMemoryPolicy);
+        shards[i]->outbox.resize(shardCount);
+    }
+    
+    if (!loadDataFromDisk()) return 1;
     cout << endl;
     
-    runAsyncServer();
+    // Shards 1..N-1 get their own threads, shard 0 runs here
+    vector<thread> loops;
+    for (int i = 1; i < shardCount; i++) loops.emplace_back(runAsyncServer, ref(*shards[i]));
+    runAsyncServer(*shards[0]);
+    for (auto& t : loops) t.join();
+    
+    cout << "\033[1;32m✓ Graceful shutdown complete\033[0m" << endl;
     
     return 0;
 }
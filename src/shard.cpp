@@ -0,0 +1,44 @@
+#include "../include/shard.h"
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <functional>
+
+int shardForKey(string_view key, int shards) {
+    uint64_t h = std::hash<string_view>{}(key);
+    return (int)(((h >> 32) * (uint64_t)shards) >> 32);
+}
+
+ShardInbox::ShardInbox() : efd(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+ShardInbox::~ShardInbox() {
+    close(efd);
+}
+
+void ShardInbox::post(vector<ShardMessage>& batch) {
+    if (batch.empty()) return;
+    bool wasEmpty;
+    {
+        lock_guard<mutex> lock(m);
+        wasEmpty = queue.empty();
+        if (wasEmpty) {
+            queue.swap(batch);
+        } else {
+            for (auto& msg : batch) queue.push_back(std::move(msg));
+        }
+    }
+    batch.clear();
+    if (wasEmpty) {
+        uint64_t one = 1;
+        (void)!write(efd, &one, sizeof(one));
+    }
+}
+
+void ShardInbox::take(vector<ShardMessage>& out) {
+    // Reset the eventfd before emptying the queue: a batch posted after the
+    // swap finds the queue empty and signals again, so none is missed
+    uint64_t count;
+    (void)!read(efd, &count, sizeof(count));
+    out.clear();
+    lock_guard<mutex> lock(m);
+    queue.swap(out);
+}
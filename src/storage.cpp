@@ -1,66 +1,292 @@
 #include "storage.h"
 #include <chrono>
+#include <charconv>
 #include <climits>  // For LLONG_MAX
-#include <cstdlib>  // For rand()
-#include <ctime>    // For time()
 
-// Check if value is expired
-bool StoredValue::isExpired() const {
-    if (expiresAt == -1) return false;
-    return expiresAt <= Storage::getCurrentTimeMs();
+static_assert(sizeof(StoredValue) == 16, "StoredValue grew");
+
+// ============================================================================
+// STORED VALUE ENCODINGS
+// ============================================================================
+
+// Parse a canonical decimal integer: exactly what to_string would print back,
+// so GET returns the bytes that were SET ("007" and "+1" stay strings)
+static bool parseCanonicalInt(string_view v, int64_t& out) {
+    if (v.empty() || v.size() > 20) return false;
+    auto [end, ec] = from_chars(v.data(), v.data() + v.size(), out);
+    if (ec != errc() || end != v.data() + v.size()) return false;
+    char buf[24];
+    auto res = to_chars(buf, buf + sizeof(buf), out);
+    return string_view(buf, res.ptr - buf) == v;
+}
+
+uint8_t StoredValue::deduceEncoding(string_view v) {
+    int64_t n;
+    if (parseCanonicalInt(v, n)) return OBJ_ENCODING_INT;
+    return v.size() <= EMBSTR_MAX ? OBJ_ENCODING_EMBSTR : OBJ_ENCODING_RAW;
+}
+
+StoredValue& StoredValue::operator=(StoredValue&& o) noexcept {
+    if (this != &o) {
+        releaseRaw();
+        memcpy(payload, o.payload, sizeof(payload));
+        flags = o.flags;
+        typeEncoding = o.typeEncoding;
+        lru = o.lru;
+        o.typeEncoding = OBJ_TYPE_STRING | OBJ_ENCODING_EMBSTR;  // o no longer owns a buffer
+        o.flags = 0;
+    }
+    return *this;
+}
+
+void StoredValue::releaseRaw() {
+    if (encoding() == OBJ_ENCODING_RAW) delete[] rawPtr();
+}
+
+void StoredValue::setString(string_view v) {
+    int64_t n;
+    if (parseCanonicalInt(v, n)) {
+        setInt(n);
+        return;
+    }
+    releaseRaw();
+    if (v.size() <= EMBSTR_MAX) {
+        memcpy(payload, v.data(), v.size());
+        flags = (flags & HAS_EXPIRE) | (uint8_t)v.size();
+        typeEncoding = OBJ_TYPE_STRING | OBJ_ENCODING_EMBSTR;
+    } else {
+        uint32_t len = (uint32_t)v.size();
+        char* p = new char[sizeof(len) + len];
+        memcpy(p, &len, sizeof(len));
+        memcpy(p + sizeof(len), v.data(), len);
+        memcpy(payload, &p, sizeof(p));
+        typeEncoding = OBJ_TYPE_STRING | OBJ_ENCODING_RAW;
+    }
+}
+
+void StoredValue::setInt(int64_t v) {
+    releaseRaw();
+    memcpy(payload, &v, sizeof(v));
+    typeEncoding = OBJ_TYPE_STRING | OBJ_ENCODING_INT;
+}
+
+string_view StoredValue::strValue() const {
+    if (encoding() == OBJ_ENCODING_EMBSTR) {
+        return string_view(payload, flags & EMBSTR_LEN_MASK);
+    }
+    char* p = rawPtr();
+    uint32_t len;
+    memcpy(&len, p, sizeof(len));
+    return string_view(p + sizeof(len), len);
+}
+
+string StoredValue::toString() const {
+    if (encoding() == OBJ_ENCODING_INT) return to_string(intValue());
+    return string(strValue());
+}
+
+size_t StoredValue::rawAllocSize() const {
+    if (encoding() != OBJ_ENCODING_RAW) return 0;
+    return sizeof(uint32_t) + strValue().size();
 }
 
-// Get current time in milliseconds (Unix timestamp)
-int64_t Storage::getCurrentTimeMs() {
+// ============================================================================
+// CLOCK
+// ============================================================================
+
+int64_t Storage::mockTimeMs = 0;
+thread_local int64_t Storage::cachedTimeMs = 0;
+
+// Read the system clock in milliseconds (Unix timestamp)
+int64_t Storage::systemTimeMs() {
     using namespace std::chrono;
     return duration_cast<milliseconds>(system_clock::now().time_since_epoch()).count();
 }
 
+// Refresh the cached clock: wall-clock anchor + monotonic elapsed time
+void Storage::updateCachedClock() {
+    using namespace std::chrono;
+    static const int64_t wallAnchorMs = systemTimeMs();
+    static const steady_clock::time_point monoAnchor = steady_clock::now();
+    cachedTimeMs = wallAnchorMs + duration_cast<milliseconds>(steady_clock::now() - monoAnchor).count();
+}
+
 // Set without expiration
-void Storage::set(const string& key, const string& value) {
+void Storage::set(string_view key, string_view value) {
     evictIfNeeded();  // Evict before inserting if needed
-    int64_t now = getCurrentTimeMs();
-    data[key] = {value, -1, now};  // -1 = no expiration, now = lastAccessTime
+    writeValue(key, StoredValue(value), -1);  // -1 = no expiration
 }
 
 // Set with expiration (DiceDB approach)
-void Storage::setWithExpiry(const string& key, const string& value, int64_t durationMs) {
+void Storage::setWithExpiry(string_view key, string_view value, int64_t durationMs) {
+    setWithExpireAt(key, value, durationMs > 0 ? getCurrentTimeMs() + durationMs : -1);
+}
+
+void Storage::setWithExpireAt(string_view key, string_view value, int64_t expiresAt) {
     evictIfNeeded();  // Evict before inserting if needed
-    int64_t now = getCurrentTimeMs();
-    int64_t expiresAt = -1;
+    writeValue(key, StoredValue(value), expiresAt);
+}
+
+// Insert a value decoded from a snapshot, in whatever encoding it came with
+void Storage::restore(string_view key, StoredValue&& value, int64_t expiresAt) {
+    evictIfNeeded();
+    writeValue(key, std::move(value), expiresAt);
+}
+
+// ============================================================================
+// MEMORY ACCOUNTING
+// ============================================================================
+
+// Malloc chunk size for an n-byte request (glibc: 8-byte header, 16-byte
+// alignment, 32-byte minimum) - includes allocator slack
+static size_t mallocChunkSize(size_t n) {
+    size_t chunk = (n + 8 + 15) & ~(size_t)15;
+    return chunk < 32 ? 32 : chunk;
+}
+
+// Heap bytes owned by a key (0 when stored inline)
+size_t Storage::keyHeapBytes(const CompactString& key) {
+    return key.isInline() ? 0 : mallocChunkSize(key.size());
+}
+
+// Heap bytes owned by a value (0 for INT/EMBSTR)
+size_t Storage::valueHeapBytes(const StoredValue& sv) {
+    size_t n = sv.rawAllocSize();
+    return n ? mallocChunkSize(n) : 0;
+}
+
+void Storage::updatePeak() {
+    size_t used = usedMemory();
+    if (used > usedMemoryPeak) usedMemoryPeak = used;
+}
+
+// Remove a key (and its expires entry), releasing its accounted memory;
+// returns next iterator
+Dict<StoredValue>::iterator Storage::deleteEntry(Dict<StoredValue>::iterator it) {
+    if (it->second.hasExpire()) {
+        setExpireIndex(it->first, -1);
+    }
+    heapBytes -= keyHeapBytes(it->first) + valueHeapBytes(it->second);
+    return data.erase(it);
+}
+
+// Delete a key whose TTL passed (lazy or active expiration)
+void Storage::expireEntry(Dict<StoredValue>::iterator it) {
+    deleteEntry(it);
+    expiredKeys++;
+}
+
+// Keep the expires index in sync with a key's expiry (-1 removes)
+void Storage::setExpireIndex(string_view key, int64_t expiresAt) {
+    if (expiresAt == -1) {
+        auto it = expires.find(key);
+        if (it != expires.end()) {
+            heapBytes -= keyHeapBytes(it->first);
+            expires.erase(it);
+        }
+        return;
+    }
+    // A deadline moved later keeps its wheel entry: when that comes due,
+    // the expire cycle finds the new deadline and schedules it then. So a
+    // TTL refreshed on every access (sliding expiry) adds no entries
+    auto [it, inserted] = expires.try_emplace(key);
+    if (inserted || expiresAt < it->second) {
+        expireWheel.add(string(key), expiresAt, getCurrentTimeMs());
+        // A compaction's scan may have passed this key already
+        if (wheelRebuilding) spareWheel.add(string(key), expiresAt, getCurrentTimeMs());
+    }
+    it->second = expiresAt;
+    if (inserted) heapBytes += keyHeapBytes(it->first);
+}
+
+// Expiry of a key (Unix ms), -1 if it has none
+int64_t Storage::getExpire(const StoredValue& sv, string_view key) {
+    if (!sv.hasExpire()) return -1;
+    auto it = expires.find(key);
+    return it == expires.end() ? -1 : it->second;
+}
+
+// Both Dicts hash keys the same way, so the expires lookup reuses the hash
+bool Storage::isExpired(Dict<StoredValue>::iterator it) {
+    if (!it->second.hasExpire()) return false;
+    auto exp = expires.find(it->first, it.hash());
+    return exp != expires.end() && exp->second <= getCurrentTimeMs();
+}
+
+// Store an integer in place (INCR)
+void Storage::replaceValue(StoredValue* obj, int64_t value) {
+    heapBytes -= valueHeapBytes(*obj);
+    obj->setInt(value);
+    updatePeak();
+}
+
+// Insert or overwrite a key (Redis dbSetValue)
+// New keys start at LFU_INIT_VAL; overwrites keep frequency history and count as an access
+void Storage::writeValue(string_view key, StoredValue&& sv, int64_t expiresAt) {
+    auto [it, inserted] = data.try_emplace(key);
+    StoredValue& cur = it->second;
+    bool hadExpire = false;
     
-    if (durationMs > 0) {
-        expiresAt = now + durationMs;
+    if (inserted) {
+        heapBytes += keyHeapBytes(it->first);
+        sv.lru = evictionAlgo == EvictionAlgo::LFU
+            ? ((uint32_t)lfuTimeInMinutes() << 8) | LFU_INIT_VAL
+            : lruClock();
+    } else {
+        heapBytes -= valueHeapBytes(cur);
+        hadExpire = cur.hasExpire();
+        sv.lru = cur.lru;
+        touch(sv);
     }
     
-    // Deduce encoding for the value
-    uint8_t encoding = deduceEncoding(value);
-    data[key] = StoredValue(value, expiresAt, now, OBJ_TYPE_STRING | encoding);
+    sv.setHasExpire(expiresAt != -1);
+    cur = std::move(sv);  // Frees the previous RAW buffer, if any
+    heapBytes += valueHeapBytes(cur);
+    
+    if (expiresAt != -1 || hadExpire) {
+        setExpireIndex(key, expiresAt);
+    }
+    updatePeak();
+}
+
+// Record an access for the eviction policy
+void Storage::touch(StoredValue& sv) {
+    if (evictionAlgo == EvictionAlgo::LFU) {
+        sv.lru = ((uint32_t)lfuTimeInMinutes() << 8) | lfuLogIncr(lfuDecrAndReturn(sv));
+    } else {
+        sv.lru = lruClock();
+    }
 }
 
 // Get value with lazy expiration check
-optional<string> Storage::get(const string& key) {
+const StoredValue* Storage::getValue(string_view key) {
     auto it = data.find(key);
     
     // Key doesn't exist
     if (it == data.end()) {
-        return nullopt;
+        return nullptr;
     }
     
     // Check if expired (lazy deletion - Redis approach)
-    if (it->second.isExpired()) {
-        data.erase(it);  // Delete expired key from map
-        return nullopt;
+    if (isExpired(it)) {
+        expireEntry(it);  // Delete expired key from map
+        return nullptr;
     }
     
-    // Update lastAccessTime for LRU tracking
-    it->second.lastAccessTime = getCurrentTimeMs();
+    // Update access time / frequency for eviction
+    touch(it->second);
     
-    return it->second.value;
+    return &it->second;
+}
+
+optional<string> Storage::get(string_view key) {
+    const StoredValue* value = getValue(key);
+    if (!value) return nullopt;
+    return value->toString();
 }
 
 // Check existence with expiration check
-bool Storage::exists(const string& key) {
+bool Storage::exists(string_view key) {
     auto it = data.find(key);
     
     if (it == data.end()) {
@@ -68,21 +294,16 @@ bool Storage::exists(const string& key) {
     }
     
     // Expired keys are treated as non-existent (lazy deletion)
-    if (it->second.isExpired()) {
-        data.erase(it);  // Delete expired key from map
+    if (isExpired(it)) {
+        expireEntry(it);  // Delete expired key from map
         return false;
     }
     
     return true;
 }
 
-// Delete key
-// void Storage::del(const string& key) {
-//     data.erase(key);
-// }
-
 // Get TTL in seconds (DiceDB TTL command logic)
-int64_t Storage::getTTL(const string& key) {
+int64_t Storage::getTTL(string_view key) {
     auto it = data.find(key);
     
     // Key doesn't exist
@@ -90,33 +311,37 @@ int64_t Storage::getTTL(const string& key) {
         return -2;
     }
     
-    // Check if expired (lazy deletion)
-    if (it->second.isExpired()) {
-        data.erase(it);  // Delete expired key from map
-        return -2;  // Expired = doesn't exist
-    }
-    
     // No expiration set
-    if (it->second.expiresAt == -1) {
+    int64_t expiresAt = getExpire(it->second, key);
+    if (expiresAt == -1) {
         return -1;
     }
     
+    // Check if expired (lazy deletion)
+    int64_t remainingMs = expiresAt - getCurrentTimeMs();
+    if (remainingMs <= 0) {
+        expireEntry(it);  // Delete expired key from map
+        return -2;  // Expired = doesn't exist
+    }
+    
     // Calculate remaining time in seconds
-    int64_t remainingMs = it->second.expiresAt - getCurrentTimeMs();
     return remainingMs / 1000;  // Convert to seconds
 }
 
 // Delete key (returns true if deleted, false if didn't exist)
-bool Storage::del(const string& key) {
-    if (data.find(key) != data.end()) {
-        data.erase(key);
-        return true;
-    }
-    return false;
+bool Storage::del(string_view key) {
+    auto it = data.find(key);
+    if (it == data.end()) return false;
+    deleteEntry(it);
+    return true;
 }
 
 // Set expiration on existing key (returns true if set, false if key doesn't exist)
-bool Storage::expire(const string& key, int64_t durationSec) {
+bool Storage::expire(string_view key, int64_t durationSec) {
+    return expireAt(key, getCurrentTimeMs() + durationSec * 1000);
+}
+
+bool Storage::expireAt(string_view key, int64_t expiresAt) {
     auto it = data.find(key);
     
     // Key doesn't exist
@@ -125,106 +350,303 @@ bool Storage::expire(const string& key, int64_t durationSec) {
     }
     
     // Check if already expired
-    if (it->second.isExpired()) {
-        data.erase(it);
+    if (isExpired(it)) {
+        expireEntry(it);
         return false;
     }
     
     // Set new expiration time
-    int64_t durationMs = durationSec * 1000;  // Convert seconds to milliseconds
-    it->second.expiresAt = getCurrentTimeMs() + durationMs;
+    it->second.setHasExpire(true);
+    setExpireIndex(key, expiresAt);
+    updatePeak();
     
     return true;
 }
 
-// Active expiration - delete expired keys using sampling (Redis/DiceDB approach)
-void Storage::deleteExpiredKeys() {
-    if (data.empty()) return;
+// Snapshot every key with its value as a string and absolute expiry
+std::map<std::string, KeySnapshot> Storage::getAll() {
+    std::map<std::string, KeySnapshot> all;
+    for (const auto& [key, value] : data) {
+        all.emplace(key.str(), KeySnapshot{value.toString(), getExpire(value, key)});
+    }
+    return all;
+}
+
+// Drop stale wheel entries (deleted, persisted or re-armed earlier keys,
+// otherwise kept until their own deadline), about max entries per step:
+// re-add the live deadlines to the spare wheel, swap it in once the scan
+// of the expires index is done, then free the old one
+void Storage::compactExpireWheel(size_t max) {
+    if (!wheelRebuilding) {
+        spareWheel.release(max);
+        return;
+    }
+    int64_t now = getCurrentTimeMs();
+    size_t added = 0;
+    do {
+        wheelScanCursor = expires.scan(wheelScanCursor, [&](const Dict<int64_t>::Entry& entry) {
+            spareWheel.add(string(string_view(entry.first)), entry.second, now);
+            added++;
+        });
+    } while (wheelScanCursor != 0 && added < max);
+    if (wheelScanCursor == 0) {
+        swap(expireWheel, spareWheel);
+        wheelRebuilding = false;
+    }
+}
+
+// Active expiration (Redis activeExpireCycle) - pop due deadlines off the
+// timing wheel and delete exactly those keys, until caught up or out of time.
+// Wheel entries are never cancelled, so each one is checked against the
+// expires index: key deleted or persisted = stale, deadline moved later =
+// scheduled again for it.
+void Storage::activeExpireCycle(ExpireCycle type) {
+    using namespace std::chrono;
+    const size_t BATCH = 64;  // Keys per budget check
+    int64_t startUs = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+    int64_t budgetUs = config.activeExpireBudgetUs;
     
-    const int SAMPLE_SIZE = 20;
-    const float THRESHOLD = 0.25f;  // 25%
+    if (type == ExpireCycle::FAST) {
+        // Only when the last cycle left work behind, and at most once per
+        // two fast budgets so events still get most of the time
+        if (!expireTimelimitHit) return;
+        if (startUs < lastFastCycleUs + config.activeExpireFastBudgetUs * 2) return;
+        lastFastCycleUs = startUs;
+        budgetUs = config.activeExpireFastBudgetUs;
+    }
     
-    int sampled = 0;
-    int expired = 0;
-    int checked = 0;
+    // Stale entries outnumbering the live ones (e.g. many keys deleted
+    // before their TTL): compact the wheel, on this and later slow cycles
+    if (type == ExpireCycle::SLOW && !isExpireWheelCompacting() &&
+        expireWheel.size() > 2 * expires.size() + 1024) {
+        wheelRebuilding = true;
+        wheelScanCursor = 0;
+    }
     
-    // Sample up to 20 keys with expiration set
-    for (auto it = data.begin(); it != data.end() && sampled < SAMPLE_SIZE; ) {
-        // Only check keys that have expiration set
-        if (it->second.expiresAt != -1) {
-            sampled++;
-            
-            // Check if expired
-            if (it->second.isExpired()) {
-                it = data.erase(it);  // Delete and advance iterator
-                expired++;
-            } else {
-                ++it;  // Move to next key
+    int64_t now = getCurrentTimeMs();
+    int64_t elapsedUs = 0;
+    bool caughtUp = false;
+    vector<TimingWheel::Entry> batch;
+    
+    while (!caughtUp) {
+        batch.clear();
+        caughtUp = expireWheel.collectExpired(now, batch, BATCH);
+        
+        for (const auto& e : batch) {
+            auto idx = expires.find(e.key);
+            if (idx == expires.end()) continue;
+            if (idx->second > now) {
+                expireWheel.add(e.key, idx->second, now);
+                continue;
             }
-        } else {
-            ++it;  // Skip keys without expiration
+            expireEntry(data.find(e.key));
         }
         
-        checked++;
-        
-        // Safety limit: don't check too many keys in one pass
-        if (checked > 100) break;
+        elapsedUs = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() - startUs;
+        if (elapsedUs >= budgetUs) break;
+    }
+    
+    // Then a pending compaction, with the budget left (at least a batch,
+    // so it finishes even while expiring takes all the time)
+    if (type == ExpireCycle::SLOW) {
+        while (isExpireWheelCompacting()) {
+            compactExpireWheel(BATCH);
+            elapsedUs = duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count() - startUs;
+            if (elapsedUs >= budgetUs) break;
+        }
     }
     
-    // Recursive cleanup: if >= 25% expired, continue sampling
-    if (sampled > 0 && ((float)expired / sampled) >= THRESHOLD) {
-        deleteExpiredKeys();
+    expireTimelimitHit = !caughtUp;
+    expireCycleTimeUs += elapsedUs;
+    
+    // Estimate how much of the TTL keyspace is expired but still in memory
+    // (0 when caught up), smoothed like Redis stat_expired_stale_perc
+    double stalePerc = 0;
+    if (expireTimelimitHit && !expires.empty()) {
+        const size_t SAMPLES = 20;
+        size_t stale = 0;
+        for (size_t i = 0; i < SAMPLES; i++) {
+            if (expires.randomEntry(rng)->second <= now) stale++;
+        }
+        stalePerc = (double)stale / SAMPLES;
     }
+    expiredStalePerc = stalePerc * 0.05 + expiredStalePerc * 0.95;
 }
 
 // ============================================================================
-// EVICTION LOGIC (LRU with sampling)
+// EVICTION LOGIC (sampled LRU/LFU with eviction pool)
 // ============================================================================
 
-// Find LRU victim by sampling random keys (Redis-style)
-string Storage::findVictimLRU() {
-    if (data.empty()) return "";
+bool Storage::setEvictionPolicy(const string& policy) {
+    static const map<string, pair<EvictionAlgo, bool>> policies = {
+        {"allkeys-lru",     {EvictionAlgo::LRU,    false}},
+        {"allkeys-lfu",     {EvictionAlgo::LFU,    false}},
+        {"allkeys-random",  {EvictionAlgo::RANDOM, false}},
+        {"volatile-lru",    {EvictionAlgo::LRU,    true}},
+        {"volatile-lfu",    {EvictionAlgo::LFU,    true}},
+        {"volatile-random", {EvictionAlgo::RANDOM, true}},
+        {"volatile-ttl",    {EvictionAlgo::TTL,    true}},
+    };
     
-    // Seed random generator on first call
-    static bool seeded = false;
-    if (!seeded) {
-        srand(static_cast<unsigned>(time(nullptr)));
-        seeded = true;
+    auto it = policies.find(policy);
+    if (it == policies.end()) {
+        return false;
+    }
+    config.evictionPolicy = policy;
+    evictionAlgo = it->second.first;
+    volatilePolicy = it->second.second;
+    evictionPool.clear();  // Scores from the old policy aren't comparable
+    return true;
+}
+
+// LFU minutes clock (16 bits, wraps every ~45 days)
+uint16_t Storage::lfuTimeInMinutes() {
+    return (uint16_t)((getCurrentTimeMs() / 60000) & 0xFFFF);
+}
+
+// Counter after applying time decay: -1 per lfuDecayTime minutes idle
+// (LFU keeps the minutes clock in the top 16 bits of lru, the counter below)
+uint8_t Storage::lfuDecrAndReturn(const StoredValue& sv) {
+    uint8_t counter = sv.lru & 0xFF;
+    uint16_t decayTime = sv.lru >> 8;
+    if (config.lfuDecayTime <= 0) return counter;
+    uint16_t now = lfuTimeInMinutes();
+    uint16_t elapsed = now >= decayTime ? now - decayTime : 65535 - decayTime + now;
+    int64_t periods = elapsed / config.lfuDecayTime;
+    return periods > counter ? 0 : counter - periods;
+}
+
+// LRU clock: seconds, 24 bits
+uint32_t Storage::lruClock() {
+    return (uint32_t)((getCurrentTimeMs() / LRU_CLOCK_RESOLUTION_MS) & LRU_CLOCK_MAX);
+}
+
+// Time since last access, assuming the clock wrapped at most once
+int64_t Storage::estimateIdleTimeMs(const StoredValue& sv) {
+    uint32_t now = lruClock();
+    uint32_t idle = now >= sv.lru ? now - sv.lru : now + (LRU_CLOCK_MAX - sv.lru);
+    return (int64_t)idle * LRU_CLOCK_RESOLUTION_MS;
+}
+
+// Morris-style logarithmic increment: the higher the counter, the less
+// likely it grows, so 8 bits cover millions of accesses
+uint8_t Storage::lfuLogIncr(uint8_t counter) {
+    if (counter == 255) return 255;
+    double r = (double)(rng.next() >> 11) / (double)(1ULL << 53);
+    double baseval = counter > LFU_INIT_VAL ? counter - LFU_INIT_VAL : 0;
+    double p = 1.0 / (baseval * config.lfuLogFactor + 1);
+    return r < p ? counter + 1 : counter;
+}
+
+// Eviction score (higher = evict first)
+int64_t Storage::evictionScore(string_view key, const StoredValue& sv) {
+    switch (evictionAlgo) {
+        case EvictionAlgo::LFU:
+            return 255 - lfuDecrAndReturn(sv);
+        case EvictionAlgo::TTL:
+            return LLONG_MAX - getExpire(sv, key);
+        default:
+            return estimateIdleTimeMs(sv);
+    }
+}
+
+// Offer one key to the eviction pool, keeping it sorted by score ascending
+void Storage::evictionPoolInsert(string_view key, int64_t score) {
+    // Pool full and this key is a worse victim than every candidate: not useful
+    if (evictionPool.size() == EVPOOL_SIZE && score <= evictionPool.front().score) {
+        return;
     }
     
-    int sampleSize = min(config.samplingSize, (int)data.size());
-    string victim;
-    int64_t oldestTime = LLONG_MAX;
+    // Skip keys already in the pool
+    for (const auto& entry : evictionPool) {
+        if (entry.key == key) return;
+    }
     
-    // Sample random keys from different positions each time
-    for (int i = 0; i < sampleSize; i++) {
-        // Generate random position in the map
-        int randomPos = rand() % data.size();
-        
-        // Advance iterator to random position
-        auto it = data.begin();
-        advance(it, randomPos);
-        
-        // Check if this key is older than current victim
-        if (it->second.lastAccessTime < oldestTime) {
-            oldestTime = it->second.lastAccessTime;
-            victim = it->first;
-        }
+    // Drop the worst candidate to make room
+    if (evictionPool.size() == EVPOOL_SIZE) {
+        evictionPool.erase(evictionPool.begin());
     }
     
-    return victim;
+    auto pos = evictionPool.begin();
+    while (pos != evictionPool.end() && pos->score <= score) ++pos;
+    evictionPool.insert(pos, EvictionPoolEntry{score, string(key)});
 }
 
-// Check if eviction needed and evict one key if necessary
-void Storage::evictIfNeeded() {
-    // Skip if no limit set or under limit
-    if (config.maxKeys == 0 || data.size() < config.maxKeys) {
+// Sample random keys into the eviction pool (Redis evictionPoolPopulate)
+// Each sample is O(1) via Dict::randomEntry, independent of keyspace size;
+// volatile-* policies sample the expires index only
+void Storage::evictionPoolPopulate() {
+    if (volatilePolicy) {
+        // Tiny index: consider every key instead of sampling with replacement
+        if (expires.size() <= (size_t)config.samplingSize) {
+            for (const auto& [key, when] : expires) {
+                auto it = data.find(key);
+                if (it != data.end()) evictionPoolInsert(key, evictionScore(key, it->second));
+            }
+            return;
+        }
+        for (int i = 0; i < config.samplingSize; i++) {
+            auto e = expires.randomEntry(rng);
+            auto it = data.find(e->first);
+            if (it != data.end()) evictionPoolInsert(it->first, evictionScore(it->first, it->second));
+        }
         return;
     }
     
-    // Find and evict LRU victim
-    string victim = findVictimLRU();
-    if (!victim.empty()) {
-        data.erase(victim);
+    if (data.size() <= (size_t)config.samplingSize) {
+        for (const auto& [key, value] : data) {
+            evictionPoolInsert(key, evictionScore(key, value));
+        }
+        return;
+    }
+    
+    for (int i = 0; i < config.samplingSize; i++) {
+        auto it = data.randomEntry(rng);
+        evictionPoolInsert(it->first, evictionScore(it->first, it->second));
+    }
+}
+
+// Find victim: refine the pool, then take the best candidate that is still
+// valid (not deleted, and not accessed since it was sampled - its score
+// would have dropped)
+string Storage::findVictim() {
+    // *-random: no pool, any candidate will do
+    if (evictionAlgo == EvictionAlgo::RANDOM) {
+        if (volatilePolicy) {
+            return expires.empty() ? "" : expires.randomEntry(rng)->first;
+        }
+        return data.empty() ? "" : data.randomEntry(rng)->first;
+    }
+    
+    // A few rounds in case every pooled candidate went stale
+    for (int round = 0; round < 3 && !data.empty(); round++) {
+        evictionPoolPopulate();
+        
+        while (!evictionPool.empty()) {
+            EvictionPoolEntry best = std::move(evictionPool.back());
+            evictionPool.pop_back();
+            
+            auto it = data.find(best.key);
+            if (it == data.end()) continue;
+            if (volatilePolicy && !it->second.hasExpire()) continue;
+            if (evictionScore(best.key, it->second) >= best.score) {
+                return best.key;
+            }
+        }
+    }
+    
+    return "";
+}
+
+// Check limits and evict until back under maxKeys / maxMemory
+void Storage::evictIfNeeded() {
+    while ((config.maxKeys != 0 && data.size() >= config.maxKeys) ||
+           (config.maxMemory != 0 && usedMemory() > config.maxMemory)) {
+        // Find and evict victim per policy
+        string victim = findVictim();
+        if (victim.empty()) break;  // No candidates (e.g. volatile-* with no TTL keys)
+        
+        deleteEntry(data.find(victim));
+        evictedKeys++;
     }
 }
@@ -0,0 +1,152 @@
+#include "../include/timing_wheel.h"
+#include <algorithm>
+
+TimingWheel::TimingWheel() {
+    wheel[0].resize(LEVEL0_SIZE);
+    for (int level = 1; level < LEVELS; level++) {
+        wheel[level].resize(LEVEL_SIZE);
+    }
+}
+
+// Entry plus the key's heap buffer when it doesn't fit inline (SSO)
+size_t TimingWheel::entryBytes(const string& key) {
+    size_t heap = key.size() >= 16 ? ((key.size() + 1 + 8 + 15) & ~(size_t)15) : 0;
+    return sizeof(Entry) + heap;
+}
+
+void TimingWheel::add(const string& key, int64_t deadlineMs, int64_t nowMs) {
+    if (count == 0) current = nowMs;  // Empty wheel: nothing to preserve, re-anchor
+    count++;
+    bytes += entryBytes(key);
+    place(Entry{deadlineMs, key});
+}
+
+void TimingWheel::clear() {
+    for (int level = 0; level < LEVELS; level++) {
+        for (auto& slot : wheel[level]) vector<Entry>().swap(slot);
+        levelCount[level] = 0;
+    }
+    vector<Entry>().swap(due);
+    vector<Entry>().swap(pending);
+    count = 0;
+    bytes = 0;
+}
+
+void TimingWheel::release(size_t max) {
+    auto drop = [&](vector<Entry>& entries, size_t& levelEntries) {
+        for (; max > 0 && !entries.empty(); max--) {
+            bytes -= entryBytes(entries.back().key);
+            entries.pop_back();
+            count--;
+            levelEntries--;
+        }
+        if (entries.empty()) vector<Entry>().swap(entries);
+    };
+    size_t unplaced = 0;  // due and pending have no level count
+    drop(due, unplaced);
+    drop(pending, unplaced);
+    for (int level = 0; level < LEVELS && max > 0 && count > 0; level++) {
+        for (size_t i = 0; i < wheel[level].size() && max > 0 && levelCount[level] > 0; i++) {
+            drop(wheel[level][i], levelCount[level]);
+        }
+    }
+}
+
+// Put an entry on the lowest level whose span covers its distance from now
+void TimingWheel::place(Entry&& e) {
+    int64_t delta = e.deadline - current;
+    if (delta <= 0) {
+        due.push_back(std::move(e));
+        return;
+    }
+
+    int level = 0;
+    int64_t when = e.deadline;
+    if (delta >= MAX_SPAN) {
+        // Beyond the top level: park at the far end, re-placed on cascade
+        level = LEVELS - 1;
+        when = current + MAX_SPAN - 1;
+    } else {
+        while (level < LEVELS - 1 && delta >= (1LL << shift(level + 1))) level++;
+    }
+
+    int64_t mask = (level == 0 ? LEVEL0_SIZE : LEVEL_SIZE) - 1;
+    wheel[level][(when >> shift(level)) & mask].push_back(std::move(e));
+    levelCount[level]++;
+}
+
+// Take a slot's entries out for re-placing: onto the levels below when
+// cascading, into due for level 0. collectExpired places them in chunks so
+// a crowded slot (e.g. a million keys sharing one deadline) can't blow the
+// caller's budget
+void TimingWheel::drainSlot(int level, size_t index) {
+    vector<Entry>& slot = wheel[level][index];
+    levelCount[level] -= slot.size();
+    if (pending.empty()) {
+        pending.swap(slot);
+    } else {
+        for (auto& e : slot) pending.push_back(std::move(e));
+    }
+    vector<Entry>().swap(slot);
+}
+
+// Advance one millisecond
+void TimingWheel::tick() {
+    current++;
+    for (int level = LEVELS - 1; level >= 1; level--) {
+        if ((current & ((1LL << shift(level)) - 1)) == 0) {
+            drainSlot(level, (current >> shift(level)) & (LEVEL_SIZE - 1));
+        }
+    }
+    drainSlot(0, current & (LEVEL0_SIZE - 1));  // Deadline == current: lands in due
+}
+
+bool TimingWheel::collectExpired(int64_t nowMs, vector<Entry>& out, size_t max) {
+    while (true) {
+        // Hand out what's due (entries can be ahead of nowMs if the clock went back)
+        size_t i = due.size();
+        while (i > 0 && out.size() < max) {
+            i--;
+            if (due[i].deadline > nowMs) continue;
+            count--;
+            bytes -= entryBytes(due[i].key);
+            out.push_back(std::move(due[i]));
+            if (i != due.size() - 1) due[i] = std::move(due.back());
+            due.pop_back();
+        }
+        if (due.empty() && due.capacity() > 1024) vector<Entry>().swap(due);
+
+        if (out.size() >= max) return false;
+
+        // Finish re-placing drained slots before time moves on
+        if (!pending.empty()) {
+            for (size_t n = 0; n < max && !pending.empty(); n++) {
+                place(std::move(pending.back()));
+                pending.pop_back();
+            }
+            if (!pending.empty()) return false;
+            vector<Entry>().swap(pending);
+            continue;
+        }
+
+        if (current >= nowMs) return true;
+
+        if (count == due.size()) {
+            current = nowMs;  // Nothing scheduled: skip straight ahead
+        } else if (levelCount[0] == 0) {
+            // Lower levels empty: nothing happens until the lowest occupied
+            // level's next cascade, so jump to just before it
+            int level = 1;
+            while (levelCount[level] == 0) level++;
+            int64_t boundary = current | ((1LL << shift(level)) - 1);
+            if (boundary >= nowMs) {
+                current = nowMs;
+            } else {
+                current = boundary;
+                tick();
+            }
+        } else {
+            tick();
+        }
+    }
+}
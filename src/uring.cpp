@@ -0,0 +1,138 @@
+#include "../include/uring.h"
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+
+IoUring::~IoUring() {
+    if (bufData) munmap(bufData, bufDataSize);
+    if (bufRing) munmap(bufRing, bufRingSize);
+    if (sqes) munmap(sqes, sqesSize);
+    if (ringMem) munmap(ringMem, ringMemSize);
+    if (ringFd >= 0) close(ringFd);
+}
+
+bool IoUring::init(unsigned entries, unsigned cqEntries) {
+    // One thread submits and reaps, so completions can be deferred until
+    // it waits (Linux 6.1+); older kernels reject the flags, retry without
+    io_uring_params params = {};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_SINGLE_ISSUER | IORING_SETUP_DEFER_TASKRUN;
+    params.cq_entries = cqEntries;
+    ringFd = syscall(__NR_io_uring_setup, entries, &params);
+    if (ringFd < 0 && errno == EINVAL) {
+        params = {};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = cqEntries;
+        ringFd = syscall(__NR_io_uring_setup, entries, &params);
+    }
+    if (ringFd < 0) return false;
+
+    const unsigned needed = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_SUBMIT_STABLE
+                          | IORING_FEAT_EXT_ARG;
+    if ((params.features & needed) != needed) {
+        errno = ENOTSUP;
+        return false;
+    }
+
+    // SQ and CQ rings share one mapping (FEAT_SINGLE_MMAP); SQEs have their own
+    ringMemSize = max(params.sq_off.array + params.sq_entries * sizeof(unsigned),
+                      params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe));
+    ringMem = mmap(nullptr, ringMemSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                   IORING_OFF_SQ_RING);
+    if (ringMem == MAP_FAILED) {
+        ringMem = nullptr;
+        return false;
+    }
+    sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+    void* sqeMem = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                        IORING_OFF_SQES);
+    if (sqeMem == MAP_FAILED) return false;
+    sqes = static_cast<io_uring_sqe*>(sqeMem);
+
+    char* ring = static_cast<char*>(ringMem);
+    sqEntries = params.sq_entries;
+    sqHead = reinterpret_cast<unsigned*>(ring + params.sq_off.head);
+    sqTail = reinterpret_cast<unsigned*>(ring + params.sq_off.tail);
+    sqMask = *reinterpret_cast<unsigned*>(ring + params.sq_off.ring_mask);
+    sqeTail = *sqTail;
+    cqHead = reinterpret_cast<unsigned*>(ring + params.cq_off.head);
+    cqTail = reinterpret_cast<unsigned*>(ring + params.cq_off.tail);
+    cqMask = *reinterpret_cast<unsigned*>(ring + params.cq_off.ring_mask);
+    cqes = reinterpret_cast<io_uring_cqe*>(ring + params.cq_off.cqes);
+
+    // SQ slot i always holds SQE i
+    unsigned* array = reinterpret_cast<unsigned*>(ring + params.sq_off.array);
+    for (unsigned i = 0; i < sqEntries; i++) array[i] = i;
+    return true;
+}
+
+io_uring_sqe* IoUring::getSqe() {
+    if (sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) {
+        submit();  // The kernel consumes every SQE it is handed
+        if (sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) return nullptr;
+    }
+    io_uring_sqe* sqe = &sqes[sqeTail & sqMask];
+    sqeTail++;
+    memset(sqe, 0, sizeof(*sqe));
+    return sqe;
+}
+
+int IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags, void* arg, size_t argSize) {
+    int ret = syscall(__NR_io_uring_enter, ringFd, toSubmit, minComplete, flags, arg, argSize);
+    return ret < 0 ? -errno : ret;
+}
+
+int IoUring::submit() {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned queued = sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    return queued ? enter(queued, 0, 0, nullptr, 0) : 0;
+}
+
+int IoUring::submitAndWait(int timeoutMs) {
+    __atomic_store_n(sqTail, sqeTail, __ATOMIC_RELEASE);
+    unsigned queued = sqeTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+    __kernel_timespec ts = {timeoutMs / 1000, (timeoutMs % 1000) * 1000000LL};
+    io_uring_getevents_arg arg = {};
+    arg.sigmask_sz = _NSIG / 8;
+    arg.ts = reinterpret_cast<uint64_t>(&ts);
+    return enter(queued, 1, IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG, &arg, sizeof(arg));
+}
+
+bool IoUring::setupBufferRing(uint16_t group, unsigned entries, unsigned size) {
+    bufRingSize = entries * sizeof(io_uring_buf);
+    void* ringPages = mmap(nullptr, bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ringPages == MAP_FAILED) return false;
+    bufRing = static_cast<io_uring_buf*>(ringPages);
+    bufDataSize = (size_t)entries * size;
+    void* data = mmap(nullptr, bufDataSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (data == MAP_FAILED) return false;
+    bufData = static_cast<char*>(data);
+    bufSize = size;
+    bufMask = entries - 1;
+
+    io_uring_buf_reg reg = {};
+    reg.ring_addr = reinterpret_cast<uint64_t>(bufRing);
+    reg.ring_entries = entries;
+    reg.bgid = group;
+    if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return false;
+
+    for (unsigned bid = 0; bid < entries; bid++) recycleBuffer(bid);
+    publishBuffers();
+    return true;
+}
+
+void IoUring::recycleBuffer(uint16_t bid) {
+    io_uring_buf& buf = bufRing[bufTail & bufMask];
+    buf.addr = reinterpret_cast<uint64_t>(bufData + (size_t)bid * bufSize);
+    buf.len = bufSize;
+    buf.bid = bid;
+    bufTail++;
+}
+
+void IoUring::publishBuffers() {
+    // The ring's tail overlays the reserved field of its first entry
+    __atomic_store_n(&reinterpret_cast<io_uring_buf_ring*>(bufRing)->tail, bufTail, __ATOMIC_RELEASE);
+}
@@ -0,0 +1,116 @@
+// AOF Logging Benchmark - cost of putting one SET into the AOF buffer
+//
+// Everything between "the command ran" and "its bytes are in the loop's
+// AOF buffer" (the write() and fsync are the same for all three):
+//
+// 1. vector<string> + encodeArray: copy the arguments out of the parsed
+//    command, re-serialize them as RESP, append (the original AOF::log)
+// 2. views + AOF::feed: argument views, encoded straight into the buffer
+// 3. raw frame: at parse time, look the command up and keep its received
+//    bytes if it is a write (Connection::frame()); after it ran, append them
+//
+// Usage: ./tests/bench_aof_feed [commands]   (default: 1000000)
+
+#include "../include/aof.h"
+#include "../include/command_handler.h"
+#include "../include/resp_encoder.h"
+#include "../include/resp_parser.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+struct Result {
+    double nsPerCmd;
+    double allocsPerCmd;
+};
+
+template <typename F>
+static Result measure(size_t n, string& aofBuf, F logOne) {
+    Result best = {1e18, 0};
+    for (int attempt = 0; attempt < 3; attempt++) {
+        size_t before = allocations;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            logOne();
+            if (aofBuf.size() > (1 << 20)) aofBuf.clear();  // Written out
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n;
+        if (ns < best.nsPerCmd) best = {ns, (double)(allocations - before) / n};
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    cout << "\n=== AOF logging per SET: " << n << " commands ===\n" << endl;
+    cout << left << setw(10) << "Value" << setw(34) << "Path" << right << setw(10) << "ns/cmd"
+         << setw(14) << "allocs/cmd" << endl;
+    cout << string(68, '-') << endl;
+
+    for (size_t valueSize : {16, 1024}) {
+        // One parsed SET, as the event loop has it
+        string wire = RESPEncoder::encodeArray({"SET", "key:000123", string(valueSize, 'v')});
+        RespParser parser;
+        parser.feed(wire);
+        vector<string_view> args;
+        parser.next(args);
+        RespValue cmd;
+        cmd.type = RespType::Array;
+        for (string_view arg : args) {
+            RespValue v;
+            v.type = RespType::BulkString;
+            v.str_value.assign(arg);
+            cmd.arr_value.push_back(std::move(v));
+        }
+        string_view received = parser.lastFrame();
+
+        string aofBuf, frames;
+        aofBuf.reserve(2 << 20);
+        vector<string_view> views;
+
+        Result copy = measure(n, aofBuf, [&]() {
+            vector<string> command;
+            for (const auto& val : cmd.arr_value) command.push_back(val.str_value);
+            aofBuf += RESPEncoder::encodeArray(command);
+        });
+        Result feed = measure(n, aofBuf, [&]() {
+            views.clear();
+            for (const auto& val : cmd.arr_value) views.push_back(val.str_value);
+            AOF::feed(aofBuf, views);
+        });
+        Result raw = measure(n, aofBuf, [&]() {
+            const CommandInfo* info = CommandHandler::lookupCommand(args[0]);
+            frames.clear();
+            if (info && (info->flags & CMD_WRITE)) frames.append(received);
+            aofBuf.append(frames);
+        });
+
+        string label = to_string(valueSize) + "B";
+        auto row = [&](const string& value, const char* path, const Result& r) {
+            cout << left << setw(10) << value << setw(34) << path << right << fixed << setprecision(1)
+                 << setw(10) << r.nsPerCmd << setprecision(2) << setw(14) << r.allocsPerCmd << endl;
+        };
+        row(label, "vector<string> + encodeArray", copy);
+        row("", "views + AOF::feed", feed);
+        row("", "raw frame", raw);
+    }
+    cout << endl;
+    return 0;
+}
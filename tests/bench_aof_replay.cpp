@@ -0,0 +1,219 @@
+// AOF Replay Benchmark - startup time and memory loading a large AOF
+//
+// Writes an AOF of the given size (SETs with 64-192B values over a fixed
+// keyspace, some with PXAT deadlines, plus INCR, PEXPIREAT, DEL, and SETs
+// already expired), then loads it, each loader in a forked child so its
+// peak RSS is its own:
+//
+// 1. fread + hand dispatch: the whole file read into a string, copied into
+//    the parser, each command copied into a vector<string> and matched
+//    against SET/DEL/EXPIRE/INCR by string compares (the previous replay).
+//    Needs twice the file in memory, so it is skipped when that won't fit
+// 2. mmap + command table: AOF::replay - parsed in place from the page
+//    cache and run through CommandHandler like client commands
+//
+// The file is read once before the runs, so both start from a warm page
+// cache (a cold start adds the disk's read time to both).
+//
+// Usage: ./tests/bench_aof_replay [MB] [keys]   (default: 256 MB, 1000000 keys)
+//        ./tests/bench_aof_replay 5120           (5 GB)
+
+#include "../include/aof.h"
+#include "../include/storage.h"
+#include "../include/resp_encoder.h"
+#include "../include/resp_parser.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <cstdio>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+using namespace std;
+
+const char* AOF_FILE = "bench_replay.aof";
+
+// The replay this PR replaced, for comparison
+static uint64_t freadReplay(Storage& storage) {
+    FILE* f = fopen(AOF_FILE, "r");
+    fseek(f, 0, SEEK_END);
+    long fileSize = ftell(f);
+    fseek(f, 0, SEEK_SET);
+    string fileContent(fileSize, '\0');
+    (void)!fread(&fileContent[0], 1, fileSize, f);
+    fclose(f);
+
+    RespParser parser;
+    parser.feed(fileContent);
+    fileContent.clear();
+    fileContent.shrink_to_fit();
+    vector<string_view> args;
+    int64_t now = Storage::getCurrentTimeMs();
+    uint64_t commandCount = 0;
+
+    while (parser.next(args) == ParseStatus::Ok) {
+        vector<string> command(args.begin(), args.end());
+        const string& cmd = command[0];
+        if (cmd == "SET") {
+            int64_t expiresAt = command.size() >= 5 && command[3] == "PXAT" ? stoll(command[4]) : -1;
+            if (expiresAt != -1 && expiresAt <= now) {
+                storage.del(command[1]);
+            } else {
+                storage.setWithExpireAt(command[1], command[2], expiresAt);
+            }
+        } else if (cmd == "DEL") {
+            for (size_t i = 1; i < command.size(); i++) storage.del(command[i]);
+        } else if (cmd == "PEXPIREAT") {
+            int64_t expiresAt = stoll(command[2]);
+            if (expiresAt <= now) {
+                storage.del(command[1]);
+            } else {
+                storage.expireAt(command[1], expiresAt);
+            }
+        } else if (cmd == "INCR") {
+            auto val = storage.get(command[1]);
+            storage.set(command[1], val ? to_string(stoll(*val) + 1) : "1");
+        }
+        commandCount++;
+    }
+    return commandCount;
+}
+
+static size_t writeAof(size_t targetBytes, size_t keys) {
+    int fd = open(AOF_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    int64_t now = Storage::getCurrentTimeMs();
+    string value(192, 'v');
+    string buf;
+    size_t written = 0, commands = 0;
+    uint64_t x = 88172645463325252ULL;  // xorshift64: same file every run
+    while (written < targetBytes) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        string key = "key:" + to_string(x % keys);
+        string_view val(value.data(), 64 + (x >> 32) % 129);
+        switch (commands++ % 20) {
+        case 14:
+        case 15:
+            AOF::feed(buf, {"SET", key, val, "PXAT", to_string(now + 3600000)});
+            break;
+        case 16:
+            AOF::feed(buf, {"INCR", "counter:" + to_string(x % 1000)});
+            break;
+        case 17:
+            AOF::feed(buf, {"PEXPIREAT", key, to_string(now + 3600000)});
+            break;
+        case 18:
+            AOF::feed(buf, {"DEL", key});
+            break;
+        case 19:
+            AOF::feed(buf, {"SET", key, val, "PXAT", to_string(now - 1000)});  // Expired before the restart
+            break;
+        default:
+            AOF::feed(buf, {"SET", key, val});
+        }
+        if (buf.size() >= (4 << 20) || written + buf.size() >= targetBytes) {
+            written += write(fd, buf.data(), buf.size());
+            buf.clear();
+        }
+    }
+    close(fd);
+    return commands;
+}
+
+struct Run {
+    double seconds = 0;
+    uint64_t commands = 0;
+    size_t keys = 0;
+    long maxRssKb = 0;
+};
+
+template <typename F>
+static Run inChild(F load) {
+    int fds[2];
+    (void)!pipe(fds);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);  // replay's own progress lines
+        Storage storage;
+        storage.setMaxKeys(0);
+        auto start = chrono::steady_clock::now();
+        Run run;
+        run.commands = load(storage);
+        run.seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+        run.keys = storage.size();
+        (void)!write(fds[1], &run, sizeof(run));
+        _exit(0);
+    }
+    close(fds[1]);
+    Run run;
+    ssize_t got = read(fds[0], &run, sizeof(run));
+    close(fds[0]);
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (got != sizeof(run)) run.seconds = -1;  // Killed (out of memory)
+    run.maxRssKb = usage.ru_maxrss;
+    return run;
+}
+
+int main(int argc, char* argv[]) {
+    size_t mb = argc > 1 ? strtoull(argv[1], nullptr, 10) : 256;
+    size_t keys = argc > 2 ? strtoull(argv[2], nullptr, 10) : 1000000;
+    size_t fileBytes = mb << 20;
+
+    cout << "\n=== AOF replay: " << mb << " MB, " << keys << " keys ===\n" << endl;
+    auto start = chrono::steady_clock::now();
+    size_t commands = writeAof(fileBytes, keys);
+    cout << "Wrote " << commands << " commands in " << fixed << setprecision(1)
+         << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s" << endl;
+
+    // Warm the page cache
+    int fd = open(AOF_FILE, O_RDONLY);
+    vector<char> chunk(1 << 20);
+    while (read(fd, chunk.data(), chunk.size()) > 0) {}
+    close(fd);
+
+    cout << "\n" << left << setw(28) << "Loader" << right << setw(10) << "seconds" << setw(14) << "commands/s"
+         << setw(10) << "MB/s" << setw(14) << "peak RSS MB" << setw(10) << "keys" << endl;
+    cout << string(86, '-') << endl;
+    auto row = [&](const char* name, const Run& run) {
+        cout << left << setw(28) << name << right;
+        if (run.seconds < 0) {
+            cout << "  killed (peak RSS " << run.maxRssKb / 1024 << " MB)" << endl;
+            return;
+        }
+        cout << setprecision(2) << setw(10) << run.seconds << setprecision(0) << setw(14)
+             << run.commands / run.seconds << setprecision(1) << setw(10) << mb / run.seconds
+             << setprecision(0) << setw(14) << run.maxRssKb / 1024.0 << setw(10) << run.keys << endl;
+    };
+
+    // MemAvailable: free memory plus what the page cache would give back
+    size_t available = 0;
+    FILE* meminfo = fopen("/proc/meminfo", "r");
+    char line[256];
+    while (meminfo && fgets(line, sizeof(line), meminfo)) {
+        if (sscanf(line, "MemAvailable: %zu kB", &available) == 1) available <<= 10;
+    }
+    if (meminfo) fclose(meminfo);
+    if (fileBytes * 2 + (512 << 20) < available) {
+        row("fread + hand dispatch", inChild([](Storage& storage) { return freadReplay(storage); }));
+    } else {
+        cout << left << setw(28) << "fread + hand dispatch" << right << "  skipped: needs 2 x "
+             << mb << " MB, " << available / (1 << 20) << " MB available" << endl;
+    }
+    row("mmap + command table", inChild([&](Storage& storage) {
+        AOF aof(AOF_FILE, "no");
+        aof.replay(storage);
+        return (uint64_t)commands;
+    }));
+
+    remove(AOF_FILE);
+    cout << endl;
+    return 0;
+}
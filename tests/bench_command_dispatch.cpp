@@ -0,0 +1,178 @@
+// Command Dispatch Benchmark - per-command latency and allocations
+//
+// 1. Name lookup alone, for names in mixed case:
+//    - copy + upper-case + unordered_map<string>::find (the old dispatch)
+//    - CommandHandler::lookupCommand (compile-time table, case-insensitive
+//      compare on the argument view)
+// 2. Each command end to end into an OutputBuffer, via
+//    - handleCommand(RespValue): views built over the parsed command
+//    - handleCommand(CommandArgs): views handed in directly
+//    with heap allocations per command (operator new is counted)
+// 3. The server's read-to-reply path: a pipeline of GET/SET/INCR fed into
+//    a Connection, parseCommands(), each command run, clearCommands():
+//    - a RespValue built per command (the old Connection::commands)
+//    - Connection::args(): views of the query buffer, nothing copied
+//
+// Usage: ./tests/bench_command_dispatch [iterations]   (default: 2000000)
+
+#include "../include/storage.h"
+#include "../include/command_handler.h"
+#include "../include/output_buffer.h"
+#include "../include/connection.h"
+#include "../include/resp_encoder.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static RespValue makeCommand(const vector<string>& args) {
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    for (const string& arg : args) {
+        RespValue v;
+        v.type = RespType::BulkString;
+        v.str_value = arg;
+        cmd.arr_value.push_back(v);
+    }
+    return cmd;
+}
+
+template <typename F>
+static double bestNs(size_t n, F run) {
+    double best = 1e18;
+    for (int attempt = 0; attempt < 3; attempt++) {
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) run(i);
+        best = min(best, chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n);
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000000;
+
+    // --- 1. Name lookup ---
+    vector<string> names = {"get", "SET", "Incr", "expire", "PING", "ttl", "DeL", "info", "unknown"};
+    unordered_map<string, int> map = {{"PING", 0}, {"SET", 1}, {"GET", 2}, {"TTL", 3},
+                                      {"DEL", 4}, {"EXPIRE", 5}, {"INCR", 6}, {"INFO", 7}};
+    size_t found = 0;
+    double mapNs = bestNs(n, [&](size_t i) {
+        string name = names[i % names.size()];
+        for (char& c : name) c = toupper(c);
+        found += map.find(name) != map.end();
+    });
+    double tableNs = bestNs(n, [&](size_t i) {
+        found += CommandHandler::lookupCommand(names[i % names.size()]) != nullptr;
+    });
+    cout << "\n=== Command name lookup (" << names.size() << " names, mixed case) ===\n" << endl;
+    cout << fixed << setprecision(1);
+    cout << "  copy + toupper + unordered_map:  " << setw(6) << mapNs << " ns" << endl;
+    cout << "  compile-time table, views:       " << setw(6) << tableNs << " ns" << endl;
+
+    // --- 2. Per command ---
+    Storage storage;
+    storage.setMaxKeys(0);
+    CommandHandler handler(storage);
+    OutputBuffer out;
+    storage.set("key:1", "value");
+    storage.set("counter", "1");
+    storage.set("volatile", "v");
+
+    vector<pair<string, vector<string>>> commands = {
+        {"PING", {"PING"}},
+        {"GET (hit)", {"GET", "key:1"}},
+        {"GET (miss)", {"GET", "nokey"}},
+        {"SET", {"SET", "key:1", "value"}},
+        {"SET EX", {"set", "key:2", "value", "ex", "100"}},
+        {"INCR", {"INCR", "counter"}},
+        {"TTL", {"TTL", "key:2"}},
+        {"EXPIRE", {"EXPIRE", "volatile", "100"}},
+        {"DEL (miss)", {"DEL", "nokey"}},
+        {"unknown command", {"NOSUCHCMD", "x"}},
+    };
+
+    cout << "\n=== Per command: " << n << " runs each ===\n" << endl;
+    cout << left << setw(18) << "Command" << right << setw(16) << "RespValue ns"
+         << setw(12) << "views ns" << setw(14) << "allocs/cmd" << endl;
+    cout << string(60, '-') << endl;
+    for (auto& [label, args] : commands) {
+        RespValue cmd = makeCommand(args);
+        vector<string_view> views(args.begin(), args.end());
+        CommandArgs viewArgs(views.data(), views.size());
+        auto drain = [&]() { if (out.pending() > (1 << 20)) out.consume(out.pending()); };
+
+        double respNs = bestNs(n, [&](size_t) { handler.handleCommand(cmd, out); drain(); });
+        size_t before = allocations;
+        double viewNs = bestNs(n, [&](size_t) { handler.handleCommand(viewArgs, out); drain(); });
+        double allocsPerCmd = (double)(allocations - before) / (3 * n);
+
+        cout << left << setw(18) << label << right << setprecision(1) << setw(16) << respNs
+             << setw(12) << viewNs << setprecision(3) << setw(14) << allocsPerCmd << endl;
+    }
+
+    // --- 3. Read to reply, as the event loop runs it ---
+    const size_t PIPELINE = 64;
+    string wire;
+    for (size_t i = 0; i < PIPELINE; i++) {
+        string key = "key:" + to_string(i % 8);
+        switch (i % 3) {
+        case 0: wire += RESPEncoder::encodeArray({"GET", key}); break;
+        case 1: wire += RESPEncoder::encodeArray({"SET", key, string(32, 'v')}); break;
+        default: wire += RESPEncoder::encodeArray({"INCR", "counter"});
+        }
+    }
+    Connection conn;
+    vector<string_view> argv;
+    size_t rounds = max<size_t>(n / PIPELINE, 1);
+    auto serve = [&](bool materialize) {
+        conn.parser.feed(wire);
+        parseCommands(conn);
+        for (size_t i = 0; i < conn.commands.size(); i++) {
+            CommandArgs args = conn.args(i, argv);
+            if (materialize) {
+                RespValue cmd;
+                cmd.type = RespType::Array;
+                cmd.arr_value.resize(args.size());
+                for (size_t a = 0; a < args.size(); a++) {
+                    cmd.arr_value[a].type = RespType::BulkString;
+                    cmd.arr_value[a].str_value.assign(args[a]);
+                }
+                handler.handleCommand(cmd, conn.reply);
+            } else {
+                handler.handleCommand(args, conn.reply);
+            }
+        }
+        conn.clearCommands();
+        conn.reply.consume(conn.reply.pending());
+    };
+
+    cout << "\n=== Read to reply: " << PIPELINE << "-command pipelines (GET/SET 32B/INCR) ===\n" << endl;
+    cout << left << setw(34) << "Commands held as" << right << setw(10) << "ns/cmd" << setw(14) << "allocs/cmd" << endl;
+    cout << string(58, '-') << endl;
+    for (bool materialize : {true, false}) {
+        serve(materialize);  // Warm: buffers at their working size
+        size_t before = allocations;
+        double ns = bestNs(rounds, [&](size_t) { serve(materialize); }) / PIPELINE;
+        double allocsPerCmd = (double)(allocations - before) / (3 * rounds * PIPELINE);
+        cout << left << setw(34) << (materialize ? "RespValue per command" : "offsets into the query buffer")
+             << right << setprecision(1) << setw(10) << ns << setprecision(3) << setw(14) << allocsPerCmd << endl;
+    }
+    cout << endl;
+    return found == 0;  // Keep the lookups from being optimized out
+}
@@ -0,0 +1,166 @@
+// Event Dispatch Benchmark - per-event cost with many idle connections
+//
+// 100 active clients send a PING per round while 20,000 idle connections
+// sit in the client table. Each event is handled as in the event loop
+// (lookup, drain the socket, parse, run, flush the reply), with the
+// connection found either by:
+//
+// 1. map<int, Connection> keyed by data.fd (the old client table)
+// 2. epoll_event.data.ptr into the fd-indexed ConnectionTable
+//
+// The sandbox this was written in caps open files at 20,000, so the idle
+// connections are table entries without sockets. That's all an idle client
+// costs here: it never shows up in epoll_wait, it only grows the table.
+//
+// Usage: ./tests/bench_event_dispatch [rounds] [idle] [active]   (default: 5000 20000 100)
+
+#include "../include/connection.h"
+#include "../include/command_handler.h"
+#include "../include/storage.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <string>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+const string PING = "*1\r\n$4\r\nPING\r\n";
+
+struct Setup {
+    vector<int> serverFds, clientFds;
+    int firstIdleFd = 0;
+};
+
+// Handle one readable connection; returns commands run
+static size_t serve(Connection& conn, CommandHandler& handler, vector<string_view>& args) {
+    readQuery(conn.fd, conn.parser);
+    size_t ran = 0;
+    while (conn.parser.next(args) == ParseStatus::Ok) {
+        RespValue cmd;
+        cmd.type = RespType::Array;
+        cmd.arr_value.resize(args.size());
+        for (size_t i = 0; i < args.size(); i++) {
+            cmd.arr_value[i].type = RespType::BulkString;
+            cmd.arr_value[i].str_value.assign(args[i]);
+        }
+        conn.reply.append(handler.handleCommand(cmd));
+        ran++;
+    }
+    conn.reply.flush(conn.fd);
+    return ran;
+}
+
+// Run rounds of PINGs through epoll; lookup picks the dispatch style.
+// Returns ns per event, counting only the server side
+template <typename Lookup>
+static double runRounds(const Setup& setup, int epollFd, size_t rounds, CommandHandler& handler,
+                        Lookup lookup) {
+    vector<epoll_event> events(setup.serverFds.size());
+    vector<string_view> args;
+    char sink[4096];
+    size_t handled = 0;
+    nanoseconds spent(0);
+    for (size_t r = 0; r < rounds; r++) {
+        for (int fd : setup.clientFds) (void)!write(fd, PING.data(), PING.size());
+        auto start = steady_clock::now();
+        size_t ran = 0;
+        while (ran < setup.clientFds.size()) {
+            int n = epoll_wait(epollFd, events.data(), events.size(), 1000);
+            for (int i = 0; i < n; i++) ran += serve(*lookup(events[i]), handler, args);
+            handled += n;
+        }
+        spent += steady_clock::now() - start;
+        for (int fd : setup.clientFds) (void)!read(fd, sink, sizeof(sink));
+    }
+    return (double)spent.count() / handled;
+}
+
+int main(int argc, char* argv[]) {
+    size_t rounds = argc > 1 ? strtoull(argv[1], nullptr, 10) : 5000;
+    size_t idle = argc > 2 ? strtoull(argv[2], nullptr, 10) : 20000;
+    size_t active = argc > 3 ? strtoull(argv[3], nullptr, 10) : 100;
+
+    Setup setup;
+    for (size_t i = 0; i < active; i++) {
+        int fds[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+            perror("socketpair");
+            return 1;
+        }
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        setup.serverFds.push_back(fds[0]);
+        setup.clientFds.push_back(fds[1]);
+        setup.firstIdleFd = max(setup.firstIdleFd, max(fds[0], fds[1]) + 1);
+    }
+
+    // Old table: map keyed by fd, epoll data.fd. New table: fd-indexed
+    // array, epoll data.ptr
+    map<int, Connection> clientMap;
+    ConnectionTable table;
+    for (size_t i = 0; i < idle; i++) {
+        clientMap[setup.firstIdleFd + i].fd = setup.firstIdleFd + i;
+        table.add(setup.firstIdleFd + i);
+    }
+    for (int fd : setup.serverFds) {
+        clientMap[fd].fd = fd;
+        table.add(fd);
+    }
+    int epollFd = epoll_create1(0);
+    auto registerAll = [&](bool usePtr) {
+        for (int fd : setup.serverFds) {
+            epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+            epoll_event ev = {};
+            ev.events = EPOLLIN | EPOLLET;
+            if (usePtr) {
+                ev.data.ptr = table.get(fd);
+            } else {
+                ev.data.fd = fd;
+            }
+            epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        }
+    };
+
+    Storage storage;
+    CommandHandler handler(storage);
+    cout << active << " active + " << idle << " idle connections, " << rounds << " rounds" << endl;
+
+    // Interleaved, best of 3 (noisy machine)
+    double mapNs = 1e9, tableNs = 1e9;
+    for (int run = 0; run < 3; run++) {
+        registerAll(false);
+        mapNs = min(mapNs, runRounds(setup, epollFd, rounds, handler, [&](const epoll_event& e) {
+            return &clientMap.find(e.data.fd)->second;
+        }));
+        registerAll(true);
+        tableNs = min(tableNs, runRounds(setup, epollFd, rounds, handler, [](const epoll_event& e) {
+            return static_cast<Connection*>(e.data.ptr);
+        }));
+    }
+
+    // Lookup alone, cycling through the active fds
+    const size_t LOOKUPS = 10000000;
+    size_t sum = 0;
+    auto start = steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++) sum += clientMap.find(setup.serverFds[i % active])->second.fd;
+    double mapLookupNs = duration<double, nano>(steady_clock::now() - start).count() / LOOKUPS;
+    start = steady_clock::now();
+    for (size_t i = 0; i < LOOKUPS; i++) sum += table.get(setup.serverFds[i % active])->fd;
+    double tableLookupNs = duration<double, nano>(steady_clock::now() - start).count() / LOOKUPS;
+
+    cout << left << setw(28) << "" << right << setw(14) << "per event" << setw(14) << "lookup only" << endl;
+    cout << fixed << setprecision(1);
+    cout << left << setw(28) << "map<int, Connection>" << right << setw(11) << mapNs << " ns"
+         << setw(11) << mapLookupNs << " ns" << endl;
+    cout << left << setw(28) << "data.ptr / fd-indexed" << right << setw(11) << tableNs << " ns"
+         << setw(11) << tableLookupNs << " ns" << endl;
+
+    return sum == 0;
+}
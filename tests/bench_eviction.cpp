@@ -0,0 +1,54 @@
+// Eviction Microbenchmark - SET throughput at full capacity
+// Every SET of a new key triggers evictIfNeeded() -> findVictimLRU()
+//
+// Usage: ./tests/bench_eviction [maxKeys ...]   (default: 10000 1000000 10000000)
+
+#include "../include/storage.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+using namespace std;
+using namespace std::chrono;
+
+const size_t MAX_OPS = 1000000;          // SETs per size...
+const auto TIME_LIMIT = seconds(5);      // ...or until this much time has passed
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {10000, 1000000, 10000000};
+
+    cout << left << setw(12) << "maxKeys" << right << setw(12) << "SETs"
+         << setw(16) << "SET ops/s" << setw(16) << "us/SET" << endl;
+
+    for (size_t n : sizes) {
+        Storage storage;
+        storage.setMaxKeys(n);
+
+        // Fill to capacity (no evictions yet)
+        for (size_t i = 0; i < n; i++) {
+            storage.set("key:" + to_string(i), "value");
+        }
+
+        // Measure: every new key forces one eviction
+        auto start = steady_clock::now();
+        size_t ops = 0;
+        while (ops < MAX_OPS) {
+            storage.set("new:" + to_string(ops), "value");
+            ops++;
+            if ((ops & 1023) == 0 && steady_clock::now() - start >= TIME_LIMIT) break;
+        }
+        double secs = duration<double>(steady_clock::now() - start).count();
+
+        cout << left << setw(12) << n << right << setw(12) << ops
+             << setw(16) << fixed << setprecision(0) << ops / secs
+             << setw(16) << setprecision(3) << secs * 1e6 / ops << endl;
+
+        if (storage.size() != n) cerr << "size drifted: " << storage.size() << endl;
+    }
+    return 0;
+}
@@ -0,0 +1,110 @@
+// Keyspace Microbenchmark - GET/SET throughput
+// Compares the old std::map keyspace against Storage's Dict-backed keyspace
+//
+// Usage: ./tests/bench_keyspace [numKeys ...]   (default: 1000000 10000000)
+
+#include "../include/storage.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <map>
+#include <vector>
+#include <string>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+using namespace std::chrono;
+
+static double opsPerSec(size_t ops, steady_clock::time_point start) {
+    double secs = duration<double>(steady_clock::now() - start).count();
+    return ops / secs;
+}
+
+static void printRow(const string& name, size_t n, double setOps, double getOps) {
+    cout << left << setw(12) << name << right << setw(12) << n
+         << setw(16) << fixed << setprecision(0) << setOps
+         << setw(16) << getOps << endl;
+}
+
+// The original StoredValue (string value, expiry and access time inline)
+struct MapValue {
+    string value;
+    int64_t expiresAt = -1;
+    int64_t lastAccessTime = 0;
+    bool isExpired() const {
+        return expiresAt != -1 && Storage::getCurrentTimeMs() >= expiresAt;
+    }
+};
+
+// Baseline: the previous keyspace representation
+static void benchMap(const vector<string>& keys, const vector<string>& lookups) {
+    map<string, MapValue> data;
+
+    auto start = steady_clock::now();
+    for (const auto& key : keys) {
+        data[key] = MapValue{"value", -1, Storage::getCurrentTimeMs()};
+    }
+    double setOps = opsPerSec(keys.size(), start);
+
+    size_t hits = 0;
+    start = steady_clock::now();
+    for (const auto& key : lookups) {
+        auto it = data.find(key);
+        if (it != data.end() && !it->second.isExpired()) {
+            it->second.lastAccessTime = Storage::getCurrentTimeMs();
+            hits++;
+        }
+    }
+    double getOps = opsPerSec(lookups.size(), start);
+
+    if (hits != lookups.size()) cerr << "map: unexpected misses" << endl;
+    printRow("std::map", keys.size(), setOps, getOps);
+}
+
+static void benchStorage(const vector<string>& keys, const vector<string>& lookups) {
+    Storage storage;
+    storage.setMaxKeys(0);  // Unlimited - measure the table, not eviction
+
+    auto start = steady_clock::now();
+    for (const auto& key : keys) {
+        storage.set(key, "value");
+    }
+    double setOps = opsPerSec(keys.size(), start);
+
+    size_t hits = 0;
+    start = steady_clock::now();
+    for (const auto& key : lookups) {
+        if (storage.get(key).has_value()) hits++;
+    }
+    double getOps = opsPerSec(lookups.size(), start);
+
+    if (hits != lookups.size()) cerr << "Storage: unexpected misses" << endl;
+    printRow("Storage", keys.size(), setOps, getOps);
+}
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes;
+    for (int i = 1; i < argc; i++) sizes.push_back(strtoull(argv[i], nullptr, 10));
+    if (sizes.empty()) sizes = {1000000, 10000000};
+
+    cout << left << setw(12) << "keyspace" << right << setw(12) << "keys"
+         << setw(16) << "SET ops/s" << setw(16) << "GET ops/s" << endl;
+
+    for (size_t n : sizes) {
+        vector<string> keys;
+        keys.reserve(n);
+        for (size_t i = 0; i < n; i++) keys.push_back("key:" + to_string(i));
+
+        // Random-order inserts and lookups (like real traffic) so the tree
+        // doesn't benefit from hot paths on near-sorted keys
+        shuffle(keys.begin(), keys.end(), mt19937(7));
+        vector<string> lookups = keys;
+        shuffle(lookups.begin(), lookups.end(), mt19937(42));
+
+        benchMap(keys, lookups);
+        benchStorage(keys, lookups);
+    }
+    return 0;
+}
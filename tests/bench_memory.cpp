@@ -0,0 +1,143 @@
+// Memory Benchmark - per-key overhead of the keyspace for small keys/values
+// Compares the previous entry layout (std::string key + 56-byte StoredValue
+// with a std::string value and 64-bit expiry/access times) against Storage's
+// compact entries (16-byte key, 16-byte StoredValue with INT/EMBSTR inline)
+//
+// Each layout is built in a forked child and measured by its RSS growth, so
+// allocator and table overhead are included.
+//
+// Usage: ./tests/bench_memory [numKeys]   (default: 10000000)
+
+#include "../include/storage.h"
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <string>
+#include <functional>
+#include <cstdlib>
+#include <unistd.h>
+#include <sys/wait.h>
+
+using namespace std;
+
+// The previous StoredValue, kept here as the baseline
+struct LegacyValue {
+    string value;
+    int64_t expiresAt = -1;
+    int64_t lastAccessTime = 0;
+    uint8_t typeEncoding = 0;
+    uint8_t lfuCounter = 0;
+    uint16_t lfuDecayTime = 0;
+};
+
+// Open-addressing table with the previous Dict's slot layout and growth
+// policy (hash array + pair<string, value> array, doubling past 0.75 load)
+class LegacyTable {
+    typedef pair<string, LegacyValue> Entry;
+    uint64_t* hashes = nullptr;
+    Entry* entries = nullptr;
+    size_t capacity = 0;
+    size_t used = 0;
+
+    void insertHashed(uint64_t h, Entry&& e) {
+        size_t i = h & (capacity - 1);
+        while (hashes[i] != 0) i = (i + 1) & (capacity - 1);
+        hashes[i] = h;
+        new (&entries[i]) Entry(std::move(e));
+    }
+
+    void grow(size_t newCapacity) {
+        uint64_t* oldHashes = hashes;
+        Entry* oldEntries = entries;
+        size_t oldCapacity = capacity;
+        hashes = new uint64_t[newCapacity]();
+        entries = static_cast<Entry*>(::operator new(newCapacity * sizeof(Entry)));
+        capacity = newCapacity;
+        for (size_t i = 0; i < oldCapacity; i++) {
+            if (oldHashes[i] == 0) continue;
+            insertHashed(oldHashes[i], std::move(oldEntries[i]));
+            oldEntries[i].~Entry();
+        }
+        delete[] oldHashes;
+        ::operator delete(oldEntries);
+    }
+
+public:
+    void set(const string& key, const string& value) {
+        if (capacity == 0) grow(16);
+        else if ((used + 1) * 4 > capacity * 3) grow(capacity * 2);
+        uint64_t h = hash<string>()(key) | 1;  // 0 marks an empty slot
+        LegacyValue v;
+        v.value = value;
+        insertHashed(h, Entry(key, std::move(v)));
+        used++;
+    }
+};
+
+static size_t residentBytes() {
+    ifstream statm("/proc/self/statm");
+    size_t pages = 0, resident = 0;
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+}
+
+// Half the values are integers (INT), half short strings (EMBSTR)
+static string valueFor(size_t i) {
+    return i % 2 ? to_string(i) : "val:" + to_string(i % 1000);
+}
+
+// Run fill() in a child process and return its RSS growth (fill leaks its
+// table on purpose: the child exits right after measuring)
+static size_t measure(const function<void()>& fill) {
+    int fds[2];
+    if (pipe(fds) != 0) return 0;
+    pid_t pid = fork();
+    if (pid == 0) {
+        close(fds[0]);
+        size_t before = residentBytes();
+        fill();
+        size_t grown = residentBytes() - before;
+        ssize_t n = write(fds[1], &grown, sizeof(grown));
+        _exit(n == sizeof(grown) ? 0 : 1);
+    }
+    close(fds[1]);
+    size_t grown = 0;
+    if (read(fds[0], &grown, sizeof(grown)) != sizeof(grown)) grown = 0;
+    close(fds[0]);
+    waitpid(pid, nullptr, 0);
+    return grown;
+}
+
+static void printRow(const string& name, size_t n, size_t bytes) {
+    cout << left << setw(22) << name << right << setw(12) << n
+         << setw(12) << bytes / (1024 * 1024)
+         << setw(14) << fixed << setprecision(1) << (double)bytes / n << endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+
+    cout << left << setw(22) << "layout" << right << setw(12) << "keys"
+         << setw(12) << "RSS MB" << setw(14) << "bytes/key" << endl;
+
+    size_t legacy = measure([n] {
+        LegacyTable* table = new LegacyTable;
+        for (size_t i = 0; i < n; i++) table->set("key:" + to_string(i), valueFor(i));
+    });
+    printRow("string + StoredValue", n, legacy);
+
+    size_t compact = measure([n] {
+        Storage* storage = new Storage;
+        storage->setMaxKeys(0);
+        for (size_t i = 0; i < n; i++) storage->set("key:" + to_string(i), valueFor(i));
+    });
+    printRow("Storage (compact)", n, compact);
+
+    if (legacy == 0 || compact == 0) {
+        cerr << "measurement failed" << endl;
+        return 1;
+    }
+    cout << "per-key overhead reduced by " << setprecision(1)
+         << 100.0 * (1.0 - (double)compact / legacy) << "%" << endl;
+    return 0;
+}
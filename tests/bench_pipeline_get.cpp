@@ -0,0 +1,158 @@
+// Pipelined GET Benchmark - large replies over a loopback TCP connection
+//
+// The server side runs in-process (RespParser -> CommandHandler -> socket)
+// on a non-blocking socket, as in the event loop; a reader thread plays
+// the client and counts the bytes that arrive. Batches of pipelined
+// GETs for 100KB values produce replies far larger than the socket buffer:
+//
+// 1. single send():  the old reply path (concatenate, one send, ignore the
+//    result) - everything past the first partial write is lost
+// 2. OutputBuffer:   chunked replies, sendmsg() flushes, waiting for
+//    POLLOUT while replies are pending (EPOLLOUT in the server)
+//
+// Usage: ./tests/bench_pipeline_get [numGets] [pipeline] [valueBytes]   (default: 2000 16 102400)
+
+#include "../include/storage.h"
+#include "../include/command_handler.h"
+#include "../include/resp_parser.h"
+#include "../include/resp_encoder.h"
+#include "../include/output_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+// Connected loopback TCP pair: fds[0] server side (non-blocking), fds[1] client
+static void tcpPair(int fds[2]) {
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    bind(listener, (sockaddr*)&addr, sizeof(addr));
+    socklen_t len = sizeof(addr);
+    getsockname(listener, (sockaddr*)&addr, &len);
+    listen(listener, 1);
+    fds[1] = socket(AF_INET, SOCK_STREAM, 0);
+    connect(fds[1], (sockaddr*)&addr, sizeof(addr));
+    fds[0] = accept(listener, nullptr, nullptr);
+    close(listener);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+}
+
+struct Result {
+    size_t expected = 0;
+    size_t received = 0;
+    double secs = 0;
+};
+
+// Serve numGets GETs in pipelined batches; bufferedReplies selects the path
+static Result run(CommandHandler& handler, const string& batch, size_t batches,
+                  size_t replyBytes, bool bufferedReplies) {
+    int fds[2];
+    tcpPair(fds);
+    Result result;
+    result.expected = replyBytes * batches;
+
+    // Client: read until the server closes its side
+    atomic<size_t> received{0};
+    thread reader([&] {
+        vector<char> buf(256 * 1024);
+        ssize_t n;
+        while ((n = read(fds[1], buf.data(), buf.size())) > 0) received += n;
+    });
+
+    RespParser parser;
+    OutputBuffer out;
+    vector<string_view> args;
+    auto start = steady_clock::now();
+    for (size_t b = 0; b < batches; b++) {
+        parser.feed(batch);
+        string response;
+        while (parser.next(args) == ParseStatus::Ok) {
+            RespValue cmd;
+            cmd.type = RespType::Array;
+            for (string_view arg : args) {
+                RespValue v;
+                v.type = RespType::BulkString;
+                v.str_value.assign(arg);
+                cmd.arr_value.push_back(std::move(v));
+            }
+            if (bufferedReplies) {
+                out.append(handler.handleCommand(cmd));
+            } else {
+                response += handler.handleCommand(cmd);
+            }
+        }
+        if (!bufferedReplies) {
+            send(fds[0], response.data(), response.size(), MSG_NOSIGNAL);
+            continue;
+        }
+        while (out.flush(fds[0]) == OutputBuffer::FlushResult::Pending) {
+            pollfd pfd = {fds[0], POLLOUT, 0};
+            poll(&pfd, 1, -1);
+        }
+    }
+    shutdown(fds[0], SHUT_WR);
+    reader.join();
+    result.secs = duration<double>(steady_clock::now() - start).count();
+    result.received = received;
+    close(fds[0]);
+    close(fds[1]);
+    return result;
+}
+
+static void printRow(const string& name, const Result& r) {
+    cout << left << setw(18) << name << right << setw(10) << fixed << setprecision(1)
+         << r.received / r.secs / (1024 * 1024) << " MB/s" << setw(9) << setprecision(1)
+         << 100.0 * r.received / r.expected << "% delivered"
+         << (r.received == r.expected ? "" : "  (replies lost)") << endl;
+}
+
+int main(int argc, char* argv[]) {
+    size_t numGets = argc > 1 ? strtoull(argv[1], nullptr, 10) : 2000;
+    size_t pipeline = argc > 2 ? strtoull(argv[2], nullptr, 10) : 16;
+    size_t valueBytes = argc > 3 ? strtoull(argv[3], nullptr, 10) : 102400;
+
+    Storage storage;
+    storage.setMaxKeys(0);
+    CommandHandler handler(storage);
+    string value(valueBytes, 'v');
+    string batch;
+    for (size_t i = 0; i < pipeline; i++) {
+        string key = "big:" + to_string(i);
+        storage.set(key, value);
+        batch += RESPEncoder::encodeArray({"GET", key});
+    }
+    size_t batches = numGets / pipeline;
+    size_t replyBytes = pipeline * RESPEncoder::encodeBulkString(value).size();
+
+    cout << batches * pipeline << " GETs of " << valueBytes / 1024 << " KB, pipeline " << pipeline
+         << " (" << replyBytes / 1024 << " KB of replies per batch)" << endl;
+
+    // Best of 3 (noisy machine)
+    Result single, buffered;
+    for (int i = 0; i < 3; i++) {
+        Result r = run(handler, batch, batches, replyBytes, false);
+        if (i == 0 || r.received / r.secs > single.received / single.secs) single = r;
+        r = run(handler, batch, batches, replyBytes, true);
+        if (i == 0 || r.secs < buffered.secs) buffered = r;
+    }
+    printRow("single send()", single);
+    printRow("OutputBuffer", buffered);
+
+    return buffered.received != buffered.expected;
+}
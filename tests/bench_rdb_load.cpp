@@ -0,0 +1,191 @@
+// Snapshot Benchmark - file size, save time and startup time: RDB vs AOF
+//
+// Builds a keyspace of N keys (40% short strings, 30% integers, 30%
+// 64-128B strings; one key in five with a TTL), then persists it two ways:
+//
+// 1. AOF: one SET per key (PXAT for TTLs), what BGREWRITEAOF leaves, the
+//    smallest AOF holding this keyspace. Loaded with AOF::replay
+// 2. RDB: RDB::save (keys in slot order). Loaded with RDB::load
+//
+// Each load runs in a forked child (its own peak RSS), from a warm page
+// cache (a cold start adds the disk's read time to both, in proportion to
+// file size).
+//
+// Usage: ./tests/bench_rdb_load [keys]   (default: 10000000)
+
+#include "../include/aof.h"
+#include "../include/rdb.h"
+#include "../include/storage.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+using namespace std;
+
+const char* AOF_FILE = "bench_snapshot.aof";
+const char* RDB_FILE = "bench_snapshot.rdb";
+
+// The keyspace, key by key: emit(key, value, expiresAt)
+template <typename F>
+static void generateKeyspace(size_t keys, F emit) {
+    int64_t now = Storage::getCurrentTimeMs();
+    string value(128, 'v');
+    uint64_t x = 88172645463325252ULL;  // xorshift64: same keyspace every run
+    for (size_t i = 0; i < keys; i++) {
+        x ^= x << 13;
+        x ^= x >> 7;
+        x ^= x << 17;
+        string key = "key:" + to_string(i);
+        int64_t expiresAt = i % 5 == 0 ? now + 3600000 + (int64_t)(x % 3600000) : -1;
+        switch (i % 10) {
+        case 0: case 1: case 2: case 3:
+            emit(key, "user:" + to_string(x % 100000), expiresAt);
+            break;
+        case 4: case 5: case 6:
+            emit(key, to_string((int64_t)(x % 2000000) - 1000000), expiresAt);
+            break;
+        default:
+            emit(key, string(value.data(), 64 + x % 65), expiresAt);
+        }
+    }
+}
+
+// What the AOF rewrite leaves for the keyspace. Written in key order, as
+// the rewrite does (its std::map), not in the Dict's slot order
+static void writeAof(size_t keys) {
+    int fd = open(AOF_FILE, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    string buf;
+    generateKeyspace(keys, [&](const string& key, const string& value, int64_t expiresAt) {
+        if (expiresAt == -1) {
+            AOF::feed(buf, {"SET", key, value});
+        } else {
+            string at = to_string(expiresAt);
+            AOF::feed(buf, {"SET", key, value, "PXAT", at});
+        }
+        if (buf.size() >= (4 << 20)) {
+            (void)!write(fd, buf.data(), buf.size());
+            buf.clear();
+        }
+    });
+    (void)!write(fd, buf.data(), buf.size());
+    fsync(fd);
+    close(fd);
+}
+
+static size_t fileSize(const char* name) {
+    struct stat st;
+    return stat(name, &st) == 0 ? st.st_size : 0;
+}
+
+static void warm(const char* name) {
+    int fd = open(name, O_RDONLY);
+    vector<char> chunk(1 << 20);
+    while (read(fd, chunk.data(), chunk.size()) > 0) {}
+    close(fd);
+}
+
+struct Run {
+    double seconds = 0;
+    size_t keys = 0;
+    long maxRssKb = 0;
+};
+
+template <typename F>
+static Run inChild(F load) {
+    int fds[2];
+    (void)!pipe(fds);
+    pid_t pid = fork();
+    if (pid == 0) {
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);  // The loaders' own progress lines
+        Storage storage;
+        storage.setMaxKeys(0);
+        auto start = chrono::steady_clock::now();
+        Run run;
+        bool ok = load(storage);
+        run.seconds = ok ? chrono::duration<double>(chrono::steady_clock::now() - start).count() : -1;
+        run.keys = storage.size();
+        (void)!write(fds[1], &run, sizeof(run));
+        _exit(0);
+    }
+    close(fds[1]);
+    Run run;
+    ssize_t got = read(fds[0], &run, sizeof(run));
+    close(fds[0]);
+    int status;
+    rusage usage;
+    wait4(pid, &status, 0, &usage);
+    if (got != sizeof(run)) run.seconds = -1;
+    run.maxRssKb = usage.ru_maxrss;
+    return run;
+}
+
+int main(int argc, char* argv[]) {
+    size_t keys = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+
+    cout << "\n=== Snapshot vs AOF: " << keys << " keys ===\n" << endl;
+    double aofSaveSeconds, rdbSaveSeconds;
+    {
+        Storage storage;
+        storage.setMaxKeys(0);
+        auto start = chrono::steady_clock::now();
+        generateKeyspace(keys, [&](const string& key, const string& value, int64_t expiresAt) {
+            storage.setWithExpireAt(key, value, expiresAt);
+        });
+        cout << "Built the keyspace in " << fixed << setprecision(1)
+             << chrono::duration<double>(chrono::steady_clock::now() - start).count() << "s ("
+             << storage.usedMemory() / (1 << 20) << " MB)" << endl;
+
+        start = chrono::steady_clock::now();
+        writeAof(keys);
+        aofSaveSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+        RDB rdb(RDB_FILE);
+        start = chrono::steady_clock::now();
+        rdb.save({&storage}, SnapshotInfo());
+        rdbSaveSeconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    }
+    warm(AOF_FILE);
+    warm(RDB_FILE);
+
+    Run aofRun = inChild([](Storage& storage) {
+        AOF aof(AOF_FILE, "no");
+        return aof.replay(storage);
+    });
+    Run rdbRun = inChild([](Storage& storage) {
+        RDB rdb(RDB_FILE);
+        return rdb.load({&storage}) == RDB::LoadStatus::Ok;
+    });
+
+    cout << "\n" << left << setw(8) << "Format" << right << setw(12) << "file MB" << setw(12) << "write s"
+         << setw(12) << "load s" << setw(14) << "keys/s" << setw(14) << "peak RSS MB" << setw(12) << "keys" << endl;
+    cout << string(84, '-') << endl;
+    auto row = [&](const char* name, const char* file, double saveSeconds, const Run& run) {
+        cout << left << setw(8) << name << right << setprecision(1) << setw(12) << fileSize(file) / 1048576.0
+             << setprecision(2) << setw(12) << saveSeconds;
+        if (run.seconds < 0) {
+            cout << "  load failed (peak RSS " << run.maxRssKb / 1024 << " MB)" << endl;
+            return;
+        }
+        cout << setw(12) << run.seconds << setprecision(0) << setw(14) << run.keys / run.seconds
+             << setw(14) << run.maxRssKb / 1024.0 << setw(12) << run.keys << endl;
+    };
+    row("AOF", AOF_FILE, aofSaveSeconds, aofRun);
+    row("RDB", RDB_FILE, rdbSaveSeconds, rdbRun);
+    if (aofRun.seconds > 0 && rdbRun.seconds > 0) {
+        cout << "\nRDB: " << setprecision(2) << (double)fileSize(AOF_FILE) / fileSize(RDB_FILE)
+             << "x smaller, loads " << aofRun.seconds / rdbRun.seconds << "x faster" << endl;
+    }
+
+    remove(AOF_FILE);
+    remove(RDB_FILE);
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,105 @@
+// Reply Path Benchmark - heap allocations and time per command
+//
+// Counts calls to operator new while CommandHandler runs SET, GET and INCR
+// and the reply lands in a connection's OutputBuffer:
+//
+// 1. string reply:       handleCommand(cmd) returns a std::string that is
+//    then appended to the output buffer (the reply path before shared
+//    replies: one string per reply, more for concatenated headers)
+// 2. direct to buffer:   handleCommand(cmd, out) encodes into the output
+//    buffer; OK/PONG/small integers/common errors are pre-encoded, and GET
+//    encodes straight from the stored value
+//
+// Usage: ./tests/bench_reply_alloc [commands]   (default: 1000000)
+
+#include "../include/storage.h"
+#include "../include/command_handler.h"
+#include "../include/output_buffer.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+using namespace std;
+
+static size_t allocations = 0;
+
+void* operator new(size_t n) {
+    allocations++;
+    void* p = malloc(n ? n : 1);
+    if (!p) throw bad_alloc();
+    return p;
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+static RespValue makeCommand(const vector<string>& args) {
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    for (const string& arg : args) {
+        RespValue v;
+        v.type = RespType::BulkString;
+        v.str_value = arg;
+        cmd.arr_value.push_back(v);
+    }
+    return cmd;
+}
+
+struct Result {
+    double allocsPerCmd;
+    double nsPerCmd;
+};
+
+template <typename F>
+static Result measure(OutputBuffer& out, size_t n, F run) {
+    Result best = {0, 1e18};
+    for (int attempt = 0; attempt < 3; attempt++) {
+        for (size_t i = 0; i < 1000; i++) run();  // Warm up (spare chunk, hash table)
+        size_t before = allocations;
+        auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < n; i++) {
+            run();
+            if (out.pending() > (1 << 20)) out.consume(out.pending());  // The socket took it
+        }
+        double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - start).count() / n;
+        if (ns < best.nsPerCmd) best = {(double)(allocations - before) / n, ns};
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    size_t n = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+
+    Storage storage;
+    storage.setMaxKeys(0);
+    CommandHandler handler(storage);
+    OutputBuffer out;
+    storage.set("key:1", "value");
+    storage.set("value:100", string(100, 'v'));
+    storage.set("counter", "1");
+
+    cout << "\n=== Reply Path: " << n << " commands each ===\n" << endl;
+    cout << left << setw(32) << "Command" << setw(22) << "Path"
+         << right << setw(12) << "allocs/cmd" << setw(12) << "ns/cmd" << endl;
+    cout << string(78, '-') << endl;
+
+    vector<pair<string, RespValue>> commands = {
+        {"SET key:1 value (existing)", makeCommand({"SET", "key:1", "value"})},
+        {"GET (100B value)", makeCommand({"GET", "value:100"})},
+        {"INCR counter", makeCommand({"INCR", "counter"})},
+    };
+    for (auto& [label, cmd] : commands) {
+        Result before = measure(out, n, [&]() { out.append(handler.handleCommand(cmd)); });
+        Result after = measure(out, n, [&]() { handler.handleCommand(cmd, out); });
+        cout << left << setw(32) << label << setw(22) << "string reply"
+             << right << fixed << setprecision(2) << setw(12) << before.allocsPerCmd
+             << setprecision(0) << setw(12) << before.nsPerCmd << endl;
+        cout << left << setw(32) << "" << setw(22) << "direct to buffer"
+             << right << fixed << setprecision(2) << setw(12) << after.allocsPerCmd
+             << setprecision(0) << setw(12) << after.nsPerCmd << endl;
+    }
+    cout << endl;
+    return 0;
+}
@@ -0,0 +1,107 @@
+// RESP Parser Microbenchmark - request parsing throughput in MB/s
+//
+// 1. redis-benchmark style pipelined SET stream (-t set -P 16 -d 3: random
+//    12-digit keys, 3-byte values) through the streaming parser, fed in
+//    recv-sized chunks
+// 2. The same stream through decode() (RespValue tree with copied strings)
+// 3. Inline commands, where every line end has to be scanned for
+//
+// Each row is the best of 5 runs (the machine this runs on is noisy).
+//
+// Usage: ./tests/bench_resp_parser [numCommands] [chunkBytes]   (default: 1000000 16384)
+
+#include "../include/resp_parser.h"
+#include "../include/resp_encoder.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <random>
+#include <cstdio>
+#include <cstdlib>
+
+using namespace std;
+using namespace std::chrono;
+
+const int RUNS = 5;
+
+static void printRow(const string& name, size_t bytes, size_t commands, double secs) {
+    cout << left << setw(34) << name << right << setw(10) << fixed << setprecision(1)
+         << bytes / secs / (1024 * 1024) << " MB/s" << setw(14) << setprecision(0)
+         << commands / secs << " cmd/s" << endl;
+}
+
+// Feed wire in chunks, parse everything; returns commands parsed
+static size_t parseStream(const string& wire, size_t chunk, size_t& argBytes) {
+    RespParser parser;
+    vector<string_view> args;
+    size_t parsed = 0;
+    for (size_t at = 0; at < wire.size(); at += chunk) {
+        parser.feed(wire.data() + at, min(chunk, wire.size() - at));
+        while (parser.next(args) == ParseStatus::Ok) {
+            parsed++;
+            argBytes += args.back().size();
+        }
+    }
+    return parsed;
+}
+
+int main(int argc, char* argv[]) {
+    size_t numCommands = argc > 1 ? strtoull(argv[1], nullptr, 10) : 1000000;
+    size_t chunk = argc > 2 ? strtoull(argv[2], nullptr, 10) : 16384;
+
+    // SET key:<12 digits> xxx, as redis-benchmark sends them
+    mt19937 rng(1);
+    string wire, inlineWire;
+    char key[32];
+    for (size_t i = 0; i < numCommands; i++) {
+        snprintf(key, sizeof(key), "key:%012u", (unsigned)(rng() % 1000000000));
+        wire += RESPEncoder::encodeArray({"SET", key, "xxx"});
+        inlineWire += string("SET ") + key + " " + string(64, 'v') + "\r\n";
+    }
+    cout << "SET stream: " << wire.size() / (1024 * 1024) << " MB, " << numCommands
+         << " commands, " << chunk << "-byte reads" << endl;
+
+    size_t argBytes = 0;
+    double best = 1e9;
+    size_t parsed = 0;
+    for (int run = 0; run < RUNS; run++) {
+        auto start = steady_clock::now();
+        parsed = parseStream(wire, chunk, argBytes);
+        best = min(best, duration<double>(steady_clock::now() - start).count());
+    }
+    printRow("streaming (views)", wire.size(), parsed, best);
+    if (parsed != numCommands) cerr << "parsed " << parsed << endl;
+
+    // decode(): one RespValue tree per command
+    RespParser parser;
+    size_t decoded = 0;
+    best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        size_t used = 0;
+        string_view rest(wire);
+        decoded = 0;
+        auto start = steady_clock::now();
+        while (!rest.empty()) {
+            RespValue v = parser.decode(rest, &used);
+            if (used == 0) break;
+            argBytes += v.arr_value.back().str_value.size();
+            rest.remove_prefix(used);
+            decoded++;
+        }
+        best = min(best, duration<double>(steady_clock::now() - start).count());
+    }
+    printRow("decode() (RespValue copies)", wire.size(), decoded, best);
+
+    best = 1e9;
+    for (int run = 0; run < RUNS; run++) {
+        auto start = steady_clock::now();
+        parsed = parseStream(inlineWire, chunk, argBytes);
+        best = min(best, duration<double>(steady_clock::now() - start).count());
+    }
+    cout << "\nInline stream: " << inlineWire.size() / (1024 * 1024) << " MB" << endl;
+    printRow("inline commands", inlineWire.size(), parsed, best);
+
+    return argBytes == 0;  // Keep the loops from being optimized out
+}
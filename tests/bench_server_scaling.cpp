@@ -0,0 +1,238 @@
+// Server Scaling Benchmark - throughput vs --io-threads, --shards and
+// the event backend
+//
+// Starts ./server_async (in a scratch directory, so its AOF doesn't touch
+// the repo) with --io-threads 1, 2, 4, 8 and then --shards 1, 2, 4, 8, 16,
+// and drives it with 200 clients sending pipelined GETs of random keys
+// among 1000 (redis-benchmark -c 200 -P 16 -r 1000 -t get). With N shards,
+// (N-1)/N of the GETs land on a shard that doesn't own the key and are
+// forwarded. Then epoll and io_uring side by side with 1000 clients (the
+// server falls back to epoll, silently here, if the kernel lacks io_uring).
+// Last, pipelined SETs with --appendfsync always, everysec and no: the AOF
+// cost per write. Requests per second are counted over a fixed window.
+//
+// Threads only help when there are spare cores: the clients and the
+// kernel's loopback work compete with the server's threads for the CPUs.
+//
+// Usage: ./tests/bench_server_scaling [seconds] [clients] [pipeline] [server]
+//        (default: 3 200 16 ./server_async)
+
+#include "../include/resp_encoder.h"
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <thread>
+#include <atomic>
+#include <vector>
+#include <random>
+#include <string>
+#include <cstdlib>
+#include <climits>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <unistd.h>
+
+using namespace std;
+using namespace std::chrono;
+
+const int CLIENT_THREADS = 4;
+const int KEYS = 1000;
+const int BACKEND_CLIENTS = 1000;
+
+static string keyName(int i) {
+    char key[16];
+    snprintf(key, sizeof(key), "key:%03d", i);
+    return key;
+}
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// Start the server in dir; returns its pid once it accepts connections
+static pid_t startServer(const string& server, const string& dir, int port, const string& option,
+                         const string& value) {
+    pid_t pid = fork();
+    if (pid == 0) {
+        if (chdir(dir.c_str()) != 0) _exit(1);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        string portArg = to_string(port);
+        execl(server.c_str(), server.c_str(), "--port", portArg.c_str(), option.c_str(),
+              value.c_str(), (char*)nullptr);
+        _exit(127);
+    }
+    for (int i = 0; i < 100; i++) {
+        int fd = connectTo(port);
+        if (fd >= 0) {
+            close(fd);
+            return pid;
+        }
+        this_thread::sleep_for(milliseconds(50));
+    }
+    kill(pid, SIGKILL);
+    waitpid(pid, nullptr, 0);
+    return -1;
+}
+
+// One client thread: its connections each keep a pipeline of GETs (or
+// SETs) in flight, sending the next batch once all replies arrived
+static void runClients(int port, int conns, int pipeline, const string& command, const atomic<bool>& stop,
+                       atomic<uint64_t>& completed) {
+    // A few different batches of random keys, cycled
+    const bool set = command == "SET";
+    mt19937 rng(port + conns);
+    vector<string> batches(64);
+    for (string& batch : batches) {
+        for (int i = 0; i < pipeline; i++) {
+            batch += set ? RESPEncoder::encodeArray({"SET", keyName(rng() % KEYS), "xxx"})
+                         : RESPEncoder::encodeArray({"GET", keyName(rng() % KEYS)});
+        }
+    }
+    const size_t replyBytes = pipeline * (set ? RESPEncoder::encodeSimpleString("OK")
+                                              : RESPEncoder::encodeBulkString("xxx")).size();
+    size_t next = 0;
+
+    int epollFd = epoll_create1(0);
+    vector<int> fds;
+    vector<size_t> received(conns, 0);
+    for (int i = 0; i < conns; i++) {
+        int fd = connectTo(port);
+        if (fd < 0) continue;
+        fds.push_back(fd);
+        epoll_event ev = {};
+        ev.events = EPOLLIN;
+        ev.data.u32 = fds.size() - 1;
+        epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &ev);
+        const string& batch = batches[next++ % batches.size()];
+        (void)!write(fd, batch.data(), batch.size());
+    }
+
+    vector<epoll_event> events(fds.size() + 1);
+    char buf[65536];
+    while (!stop.load(memory_order_relaxed)) {
+        int n = epoll_wait(epollFd, events.data(), events.size(), 100);
+        for (int i = 0; i < n; i++) {
+            uint32_t c = events[i].data.u32;
+            ssize_t got = read(fds[c], buf, sizeof(buf));
+            if (got <= 0) continue;
+            received[c] += got;
+            if (received[c] >= replyBytes) {
+                received[c] -= replyBytes;
+                completed.fetch_add(pipeline, memory_order_relaxed);
+                const string& batch = batches[next++ % batches.size()];
+                (void)!write(fds[c], batch.data(), batch.size());
+            }
+        }
+    }
+    for (int fd : fds) close(fd);
+    close(epollFd);
+}
+
+// Requests/s of one server configuration
+static double measure(const string& server, int port, const string& option, const string& value, int seconds,
+                      int clients, int pipeline, const string& command) {
+    char dir[] = "/tmp/bench_server_scalingXXXXXX";
+    if (!mkdtemp(dir)) return -1;
+    pid_t pid = startServer(server, dir, port, option, value);
+    if (pid < 0) {
+        rmdir(dir);
+        return -1;
+    }
+
+    // Load the keys, checking every reply arrived
+    int fd = connectTo(port);
+    string load;
+    for (int i = 0; i < KEYS; i++) load += RESPEncoder::encodeArray({"SET", keyName(i), "xxx"});
+    (void)!write(fd, load.data(), load.size());
+    size_t got = 0;
+    char buf[8192];
+    while (got < KEYS * 5) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) break;
+        got += n;
+    }
+    close(fd);
+
+    atomic<bool> stop{false};
+    atomic<uint64_t> completed{0};
+    vector<thread> threads;
+    for (int t = 0; t < CLIENT_THREADS; t++) {
+        int conns = clients / CLIENT_THREADS + (t < clients % CLIENT_THREADS);
+        threads.emplace_back(runClients, port, conns, pipeline, cref(command), cref(stop), ref(completed));
+    }
+    this_thread::sleep_for(milliseconds(500));  // Warm up: all connected
+    uint64_t startCount = completed.load();
+    auto start = steady_clock::now();
+    this_thread::sleep_for(seconds * 1s);
+    stop = true;
+    for (auto& t : threads) t.join();
+    double secs = duration<double>(steady_clock::now() - start).count();
+
+    kill(pid, SIGTERM);
+    waitpid(pid, nullptr, 0);
+    string aofFile = string(dir) + "/appendonly.aof";
+    unlink(aofFile.c_str());
+    rmdir(dir);
+    return (completed.load() - startCount) / secs;
+}
+
+int main(int argc, char* argv[]) {
+    int seconds = argc > 1 ? atoi(argv[1]) : 3;
+    int clients = argc > 2 ? atoi(argv[2]) : 200;
+    int pipeline = argc > 3 ? atoi(argv[3]) : 16;
+    string server = argc > 4 ? argv[4] : "./server_async";
+    char resolved[PATH_MAX];
+    if (!realpath(server.c_str(), resolved)) {
+        cerr << "server binary not found: " << server << " (run make first)" << endl;
+        return 1;
+    }
+    server = resolved;
+
+    cout << "Pipeline " << pipeline << ", " << KEYS << " random keys, " << seconds
+         << "s per run, " << thread::hardware_concurrency() << " CPUs" << endl;
+
+    struct Sweep {
+        string option;
+        vector<string> values;
+        int clients;
+        string command;
+    };
+    const Sweep sweeps[] = {{"--io-threads", {"1", "2", "4", "8"}, clients, "GET"},
+                            {"--shards", {"1", "2", "4", "8", "16"}, clients, "GET"},
+                            {"--io-uring", {"no", "yes"}, BACKEND_CLIENTS, "GET"},
+                            {"--appendfsync", {"always", "everysec", "no"}, clients, "SET"}};
+    int port = 7500 + getpid() % 1000;
+    for (const Sweep& sweep : sweeps) {
+        cout << "\n" << left << setw(14) << sweep.option << right << setw(14) << "req/s"
+             << "   (" << sweep.clients << " clients, " << sweep.command << ")" << endl;
+        for (const string& value : sweep.values) {
+            double rate = measure(server, port++, sweep.option, value, seconds, sweep.clients, pipeline,
+                                  sweep.command);
+            if (rate < 0) {
+                cerr << "server did not start" << endl;
+                return 1;
+            }
+            cout << left << setw(14) << value << right << setw(14) << fixed << setprecision(0)
+                 << rate << endl;
+        }
+    }
+    return 0;
+}
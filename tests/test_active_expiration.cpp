@@ -0,0 +1,341 @@
+// Active Expiration Tests
+// Tests the timing wheel and cron-driven reclamation of expired keys
+
+#include "../include/storage.h"
+#include "../include/timing_wheel.h"
+#include "../include/command_handler.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+
+using namespace std;
+using namespace std::chrono;
+
+// Test: Entries come out exactly when their deadline passes, on every level
+void test_wheel_exact_deadlines() {
+    TimingWheel wheel;
+    mt19937_64 rng(1);
+    const int64_t START = 1700000000000;  // Unaligned Unix ms
+    const int N = 20000;
+
+    // Deadlines from 1ms to ~3 days ahead: exercises all levels plus parking
+    vector<int64_t> deadlines(N);
+    for (int i = 0; i < N; i++) {
+        int64_t span = 1LL << (rng() % 38);
+        deadlines[i] = START + 1 + (int64_t)(rng() % span);
+        wheel.add(to_string(i), deadlines[i], START);
+    }
+
+    vector<int64_t> sorted = deadlines;
+    sort(sorted.begin(), sorted.end());
+    vector<bool> fired(N, false);
+    vector<TimingWheel::Entry> out;
+    int64_t now = START;
+    int firedCount = 0;
+    while (firedCount < N) {
+        now += 1 + (int64_t)(rng() % (1LL << (rng() % 34)));  // Irregular ticks
+        out.clear();
+        assert(wheel.collectExpired(now, out, SIZE_MAX));
+        for (const auto& e : out) {
+            int i = stoi(e.key);
+            assert(!fired[i] && "entry handed out twice");
+            assert(e.deadline == deadlines[i] && e.deadline <= now);
+            fired[i] = true;
+            firedCount++;
+        }
+        // Nothing that is due may be left behind
+        assert(firedCount == upper_bound(sorted.begin(), sorted.end(), now) - sorted.begin());
+    }
+    assert(wheel.size() == 0);
+
+    cout << "✓ Wheel fires every entry exactly once, never early or late" << endl;
+}
+
+// Test: A limited batch leaves the rest for the next call
+void test_wheel_resumes() {
+    TimingWheel wheel;
+    for (int i = 0; i < 1000; i++) wheel.add(to_string(i), 5000, 1000);
+
+    // Each call does a bounded amount of work, the wheel remembers the rest
+    vector<TimingWheel::Entry> out;
+    size_t total = 0;
+    int calls = 0;
+    bool caughtUp = false;
+    while (!caughtUp) {
+        out.clear();
+        caughtUp = wheel.collectExpired(6000, out, 300);
+        assert(out.size() <= 300);
+        total += out.size();
+        calls++;
+    }
+    assert(total == 1000);
+    assert(calls >= 4);
+    assert(wheel.size() == 0);
+
+    cout << "✓ Wheel resumes after a partial collection" << endl;
+}
+
+// Test: Deleted, persisted and re-armed keys are not reclaimed at the old deadline
+void test_stale_entries() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    int64_t base = Storage::getCurrentTimeMs();
+    Storage::setMockTimeMs(base);
+
+    storage.setWithExpiry("expires", "v", 100);
+    storage.setWithExpiry("persisted", "v", 100);
+    storage.setWithExpiry("rearmed", "v", 100);
+    storage.setWithExpiry("deleted", "v", 100);
+    storage.set("persisted", "v2");              // Plain SET drops the TTL
+    storage.expire("rearmed", 60);               // New deadline a minute out
+    storage.del("deleted");
+    storage.setWithExpiry("deleted", "v", 100000);  // Same name, new key
+
+    Storage::setMockTimeMs(base + 200);
+    storage.deleteExpiredKeys();
+
+    assert(storage.size() == 3);
+    assert(storage.expiresCount() == 2);
+    assert(storage.exists("persisted") && storage.exists("rearmed") && storage.exists("deleted"));
+
+    Storage::setMockTimeMs(base + 61000);
+    storage.deleteExpiredKeys();
+    assert(storage.size() == 2);
+    assert(storage.expiresCount() == 1);
+    Storage::setMockTimeMs(0);
+
+    cout << "✓ Stale wheel entries are ignored" << endl;
+}
+
+// Test: A TTL refreshed on every access (sliding expiry) keeps one wheel
+// entry, still fires at the latest deadline; stale entries get compacted
+void test_sliding_ttl_refresh() {
+    Storage storage;
+    int64_t base = Storage::getCurrentTimeMs();
+    Storage::setMockTimeMs(base);
+
+    storage.setWithExpiry("session", "v", 1000);
+    size_t entries = storage.getExpireWheelSize();
+    size_t memory = storage.usedMemory();
+    for (int i = 1; i <= 10000; i++) {
+        Storage::setMockTimeMs(base + i);
+        storage.expireAt("session", base + i + 1000);
+    }
+    assert(storage.getExpireWheelSize() == entries);
+    assert(storage.usedMemory() == memory);
+
+    // The first deadline passes: the key is scheduled for its latest one
+    Storage::setMockTimeMs(base + 10999);
+    storage.deleteExpiredKeys();
+    assert(storage.exists("session") && storage.getExpireWheelSize() == 1);
+    Storage::setMockTimeMs(base + 11000);
+    storage.deleteExpiredKeys();
+    assert(!storage.exists("session") && storage.getExpireWheelSize() == 0);
+
+    // Keys deleted long before their TTL: the cron drops their entries
+    for (int i = 0; i < 5000; i++) {
+        storage.setWithExpiry("temp:" + to_string(i), "v", 3600000);
+        storage.del("temp:" + to_string(i));
+    }
+    storage.setWithExpiry("live", "v", 3600000);
+    assert(storage.getExpireWheelSize() == 5001);
+    storage.deleteExpiredKeys();
+    assert(storage.getExpireWheelSize() == 1 && storage.exists("live"));
+    Storage::setMockTimeMs(0);
+
+    cout << "✓ Sliding TTL refresh keeps one wheel entry; stale entries compacted" << endl;
+}
+
+// Test: compacting a wheel of stale entries is spread over slow cycles,
+// each within its budget, and keeps every live deadline
+void test_wheel_compaction_budget() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    int64_t base = Storage::getCurrentTimeMs();
+    Storage::setMockTimeMs(base);
+
+    // Keys past the SSO length, so each wheel entry owns a heap block
+    // (deleted first: malloc sorts the freed chunks on the next
+    // allocations, which falls on these SETs, as on later traffic)
+    const int N = 600000, LIVE = 100000;
+    auto key = [](int i) { return "session:token:" + to_string(i); };
+    for (int i = LIVE; i < N; i++) storage.setWithExpiry(key(i), "v", 3600000);
+    for (int i = LIVE; i < N; i++) storage.del(key(i));
+    for (int i = 0; i < LIVE; i++) storage.setWithExpiry(key(i), "v", 3600000 + i % 1000);
+    assert(storage.getExpireWheelSize() == (size_t)N);
+
+    storage.setActiveExpireBudgetUs(2000);
+    int cycles = 0;
+    int64_t longestUs = 0, totalUs = 0;
+    do {
+        auto start = steady_clock::now();
+        storage.deleteExpiredKeys();
+        int64_t tookUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+        longestUs = max(longestUs, tookUs);
+        totalUs += tookUs;
+        if (++cycles == 1) {
+            // Deadlines set mid-compaction make it into the new wheel
+            assert(storage.isExpireWheelCompacting());
+            storage.setWithExpiry("added", "v", 1000);
+            storage.expireAt(key(0), base + 500);
+        }
+    } while (storage.isExpireWheelCompacting() && cycles < 100000);
+    cout << "   compaction: " << cycles << " slow cycles of 2ms, longest " << longestUs
+         << "us, " << totalUs << "us in all" << endl;
+    assert(cycles > 1 && !storage.isExpireWheelCompacting());
+    assert(longestUs < 2000 * 5);
+    assert(storage.getExpireWheelSize() >= (size_t)LIVE + 1);
+    assert(storage.getExpireWheelSize() < 2 * ((size_t)LIVE + 1));  // A key is seen twice at most
+
+    // Every live key is still reclaimed by the cron alone
+    Storage::setMockTimeMs(base + 3601000);
+    for (int i = 0; i < 100000 && storage.size() > 0; i++) storage.deleteExpiredKeys();
+    assert(storage.size() == 0);
+    assert(storage.getExpiredKeys() == (uint64_t)LIVE + 1);
+    assert(storage.getExpireWheelSize() == 0);
+    Storage::setMockTimeMs(0);
+
+    cout << "✓ Wheel compaction runs within the slow cycle budget, no deadline lost" << endl;
+}
+
+// Test: 1M short-TTL keys are reclaimed by the cron alone, without reads
+void test_mass_expiry_reclaimed() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    size_t empty = storage.usedMemory();
+
+    const int N = 1000000;
+    for (int i = 0; i < N; i++) {
+        storage.setWithExpiry("session:" + to_string(i), "payload-" + to_string(i),
+                              1000 + i % 500);  // Deadlines spread over 0.5s
+    }
+    assert(storage.size() == (size_t)N);
+    size_t full = storage.usedMemory();
+    int64_t lastDeadline = Storage::getCurrentTimeMs() + 1500;
+
+    // Simulate the server cron (every 100ms) until everything is gone
+    auto start = steady_clock::now();
+    int64_t longestTickUs = 0;
+    while (storage.size() > 0 && steady_clock::now() - start < seconds(30)) {
+        this_thread::sleep_for(milliseconds(100));
+        auto tick = steady_clock::now();
+        storage.deleteExpiredKeys();
+        storage.incrementallyRehash();
+        longestTickUs = max(longestTickUs,
+            (int64_t)duration_cast<microseconds>(steady_clock::now() - tick).count());
+    }
+    double lagSec = (Storage::getCurrentTimeMs() - lastDeadline) / 1000.0;
+
+    cout << "   used_memory: " << full / (1024 * 1024) << " MB -> "
+         << storage.usedMemory() / 1024 << " KB, reclaimed "
+         << lagSec << "s after the last deadline" << endl;
+    cout << "   longest cron tick: " << longestTickUs / 1000.0 << " ms" << endl;
+
+    assert(storage.size() == 0);
+    assert(storage.expiresCount() == 0);
+    assert(lagSec < 10.0);
+    // Key/value heap and wheel entries are gone; slot arrays shrink via rehash
+    assert(storage.usedMemory() < empty + (full - empty) / 10);
+    // Budget is checked every 64 keys, so a tick overshoots by little
+    assert(longestTickUs < storage.getActiveExpireBudgetUs() * 4);
+
+    cout << "✓ Mass expiry reclaimed without any reads" << endl;
+}
+
+// Test: A cycle stops on its budget, later cycles resume, fast cycles only
+// run while there is a backlog
+void test_cycle_budget_and_resume() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    int64_t base = Storage::getCurrentTimeMs();
+    Storage::setMockTimeMs(base);
+
+    const int N = 300000;
+    for (int i = 0; i < N; i++) storage.setWithExpiry("k" + to_string(i), "v", 10);
+    Storage::setMockTimeMs(base + 1000);  // Everything expired at once
+
+    storage.setActiveExpireBudgetUs(2000);
+    auto start = steady_clock::now();
+    storage.deleteExpiredKeys();
+    auto tookUs = duration_cast<microseconds>(steady_clock::now() - start).count();
+
+    size_t left = storage.size();
+    cout << "   2ms slow cycle reclaimed " << N - left << " keys in " << tookUs << "us" << endl;
+    assert(left > 0 && left < (size_t)N);     // Partial progress, stopped on time
+    assert(tookUs < 2000 * 5);
+    assert(storage.getExpiredKeys() == N - left);
+    assert(storage.getExpiredStalePerc() > 0);  // Backlog noticed
+
+    // Fast cycles keep draining from where the slow cycle stopped
+    int fastCycles = 0;
+    while (storage.size() > 0 && fastCycles < 100000) {
+        size_t before = storage.size();
+        storage.activeExpireCycle(ExpireCycle::FAST);
+        assert(storage.size() <= before);
+        if (storage.size() < before) fastCycles++;
+    }
+    assert(storage.size() == 0);
+    assert(storage.getExpiredKeys() == (uint64_t)N);
+    cout << "   fast cycles to drain the rest: " << fastCycles << endl;
+
+    // Caught up: a fast cycle is a no-op even with new expired keys around
+    storage.setWithExpiry("late", "v", 10);
+    Storage::setMockTimeMs(base + 2000);
+    storage.activeExpireCycle(ExpireCycle::FAST);
+    assert(storage.size() == 1);
+    storage.deleteExpiredKeys();
+    assert(storage.size() == 0);
+    Storage::setMockTimeMs(0);
+
+    cout << "✓ Expire cycles honour their budget and resume" << endl;
+}
+
+// Test: INFO reports expiration stats; lazy expiry counts too
+void test_info_expire_stats() {
+    Storage storage;
+    CommandHandler handler(storage);
+    int64_t base = Storage::getCurrentTimeMs();
+    Storage::setMockTimeMs(base);
+    storage.setWithExpiry("lazy", "v", 10);
+    storage.setWithExpiry("active", "v", 10);
+    Storage::setMockTimeMs(base + 100);
+    assert(!storage.get("lazy").has_value());
+    storage.deleteExpiredKeys();
+    Storage::setMockTimeMs(0);
+
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    RespValue name;
+    name.type = RespType::BulkString;
+    name.str_value = "INFO";
+    cmd.arr_value.push_back(name);
+
+    string info = handler.handleCommand(cmd);
+    assert(info.find("expired_keys:2\r\n") != string::npos);
+    assert(info.find("expired_stale_perc:0.00\r\n") != string::npos);
+    assert(info.find("expire_cycle_cpu_ms:") != string::npos);
+
+    cout << "✓ INFO reports expired_keys, expired_stale_perc, expire_cycle_cpu_ms" << endl;
+}
+
+int main() {
+    cout << "\n=== Active Expiration Tests ===\n" << endl;
+
+    test_wheel_exact_deadlines();
+    test_wheel_resumes();
+    test_stale_entries();
+    test_sliding_ttl_refresh();
+    test_cycle_budget_and_resume();
+    test_wheel_compaction_budget();
+    test_info_expire_stats();
+    test_mass_expiry_reclaimed();
+
+    cout << "\n✅ All active expiration tests passed!\n" << endl;
+
+    return 0;
+}
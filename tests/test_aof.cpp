@@ -3,10 +3,13 @@
 
 #include "../include/aof.h"
 #include "../include/storage.h"
+#include "../include/command_handler.h"
+#include "../include/resp_encoder.h"
 #include <iostream>
 #include <cassert>
 #include <fstream>
 #include <unistd.h>
+#include <thread>
 
 using namespace std;
 
@@ -118,6 +121,43 @@ void test_aof_sync_modes() {
     cout << "✓ AOF sync modes (always/everysec/no) work" << endl;
 }
 
+// Test: event loops flushing batches concurrently in always mode (group
+// commit) - every batch is whole in the file when its flush returns
+void test_aof_group_commit() {
+    cleanup();
+    const int LOOPS = 4, BATCHES = 50, PER_BATCH = 20;
+    {
+        AOF aof(TEST_AOF_FILE, "always");
+        vector<thread> loops;
+        for (int t = 0; t < LOOPS; t++) {
+            loops.emplace_back([&aof, t]() {
+                string buf;
+                for (int b = 0; b < BATCHES; b++) {
+                    for (int i = 0; i < PER_BATCH; i++) {
+                        string key = "k" + to_string(t) + "_" + to_string(b * PER_BATCH + i);
+                        AOF::feed(buf, {"SET", key, "v"});
+                    }
+                    aof.flush(buf);
+                    assert(buf.empty());
+                }
+            });
+        }
+        for (auto& t : loops) t.join();
+        assert(aof.setSyncMode("no") && !aof.setSyncMode("sometimes"));
+    }
+    
+    Storage storage;
+    storage.setMaxKeys(0);
+    {
+        AOF aof(TEST_AOF_FILE, "no");
+        aof.replay(storage);
+    }
+    assert(storage.size() == LOOPS * BATCHES * PER_BATCH);
+    
+    cleanup();
+    cout << "✓ Concurrent batches group-committed (always)" << endl;
+}
+
 // Test: Multiple operations persist correctly
 void test_aof_multiple_operations() {
     cleanup();
@@ -149,6 +189,156 @@ void test_aof_multiple_operations() {
     cout << "✓ Multiple AOF operations persist correctly" << endl;
 }
 
+// Test: relative TTLs are logged as deadlines (SET PXAT, PEXPIREAT), so a
+// replay later on a simulated clock keeps them counting from when the
+// commands ran, and skips keys whose deadline has already passed
+void test_aof_absolute_expiry() {
+    cleanup();
+    const int64_t base = 1700000000000;
+    Storage::setMockTimeMs(base);
+    
+    // Run commands like an event loop does, logging those that changed the
+    // keyspace: as rewritten by the handler, else as received
+    {
+        AOF aof(TEST_AOF_FILE, "no");
+        Storage live;
+        CommandHandler handler(live);
+        string buf;
+        auto run = [&](vector<string_view> args) {
+            uint64_t dirtyBefore = handler.dirtyCount();
+            RespValue cmd;
+            cmd.type = RespType::Array;
+            for (string_view arg : args) {
+                RespValue v;
+                v.type = RespType::BulkString;
+                v.str_value.assign(arg);
+                cmd.arr_value.push_back(std::move(v));
+            }
+            handler.handleCommand(cmd);
+            if (handler.dirtyCount() == dirtyBefore) return;
+            if (!handler.rewrittenCommand().empty()) {
+                buf.append(handler.rewrittenCommand());
+            } else {
+                AOF::feed(buf, args);
+            }
+        };
+        run({"SET", "short", "v", "EX", "10"});
+        run({"set", "long", "v", "px", "100000"});
+        run({"SET", "plain", "v"});
+        run({"SET", "fixed", "v", "PXAT", to_string(base + 50000)});
+        run({"EXPIRE", "plain", "20"});
+        run({"SET", "gone", "v", "EX", "1"});
+        run({"EXPIRE", "missing", "5"});  // No change, not logged
+        aof.flush(buf);
+        assert(live.getTTL("short") == 10 && live.getTTL("fixed") == 50);
+    }
+    
+    ifstream file(TEST_AOF_FILE);
+    string content((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+    assert(content.find("$4\r\nPXAT\r\n$13\r\n" + to_string(base + 10000)) != string::npos);
+    assert(content.find("$9\r\nPEXPIREAT\r\n$5\r\nplain\r\n$13\r\n" + to_string(base + 20000)) != string::npos);
+    assert(content.find("EX\r\n") == string::npos && content.find("px\r\n") == string::npos);
+    assert(content.find("missing") == string::npos);
+    
+    // 5s later: TTLs have kept running, the 1s key is not loaded at all
+    Storage::setMockTimeMs(base + 5000);
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        aof.replay(storage);
+        assert(storage.size() == 4 && storage.expiresCount() == 4);
+        assert(storage.getTTL("short") == 5);
+        assert(storage.getTTL("long") == 95);
+        assert(storage.getTTL("plain") == 15);
+        assert(storage.getTTL("fixed") == 45);
+        assert(!storage.exists("gone") && storage.getExpiredKeys() == 0);
+    }
+    
+    // 30s later: only the two long deadlines are left
+    Storage::setMockTimeMs(base + 30000);
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        aof.replay(storage);
+        assert(storage.size() == 2 && storage.getExpiredKeys() == 0);
+        assert(storage.getTTL("long") == 70 && storage.getTTL("fixed") == 20);
+    }
+    
+    Storage::setMockTimeMs(0);
+    cleanup();
+    cout << "✓ TTLs logged as deadlines; replay skips expired keys (simulated clock)" << endl;
+}
+
+// Test: a command cut short by a crash mid-write is reported and cut off
+// the file (appending after it would corrupt the next command), or the
+// file is refused when that's not allowed
+void test_aof_torn_tail() {
+    cleanup();
+    string whole = RESPEncoder::encodeArray({"SET", "a", "1"}) + RESPEncoder::encodeArray({"INCR", "a"});
+    string torn = RESPEncoder::encodeArray({"SET", "b", "lost"}).substr(0, 15);
+    ofstream(TEST_AOF_FILE, ios::binary) << whole << torn;
+    
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        aof.setLoadTruncated(false);
+        assert(!aof.replay(storage));
+    }
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        assert(aof.replay(storage));
+        assert(storage.get("a").value() == "2" && !storage.exists("b"));
+        aof.log({"SET", "c", "3"});  // Appended right after the last whole command
+    }
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        aof.setLoadTruncated(false);
+        assert(aof.replay(storage));
+        assert(storage.get("a").value() == "2" && storage.get("c").value() == "3");
+    }
+    
+    // Corruption before the end is not a torn write: refused either way
+    ofstream(TEST_AOF_FILE, ios::binary) << whole << "*2\r\n#3\r\nDEL\r\n" << whole;
+    {
+        Storage storage;
+        AOF aof(TEST_AOF_FILE, "no");
+        assert(!aof.replay(storage));
+    }
+    
+    cleanup();
+    cout << "✓ Torn last command cut off (or refused); corrupt file refused" << endl;
+}
+
+// Test: replay runs the commands through the command table: any command it
+// knows works (INCR keeps the TTL, multi-key DEL), unknown ones are skipped
+void test_aof_replay_command_table() {
+    cleanup();
+    {
+        AOF aof(TEST_AOF_FILE, "no");
+        string buf;
+        AOF::feed(buf, {"set", "n", "41", "px", "100000"});
+        AOF::feed(buf, {"NOSUCHCMD", "n"});
+        AOF::feed(buf, {"incr", "n"});
+        AOF::feed(buf, {"SET", "x", "1"});
+        AOF::feed(buf, {"SET", "y", "1"});
+        AOF::feed(buf, {"DEL", "x", "y", "missing"});
+        aof.flush(buf);
+    }
+    
+    Storage storage;
+    {
+        AOF aof(TEST_AOF_FILE, "no");
+        assert(aof.replay(storage));
+    }
+    assert(storage.get("n").value() == "42" && storage.getTTL("n") > 0);
+    assert(storage.size() == 1);
+    
+    cleanup();
+    cout << "✓ Replay runs through the command table (unknown commands skipped)" << endl;
+}
+
 // Test: Empty AOF file doesn't crash
 void test_empty_aof() {
     cleanup();
@@ -197,7 +387,11 @@ int main() {
     test_aof_replay();
     test_aof_replay_with_delete();
     test_aof_sync_modes();
+    test_aof_group_commit();
     test_aof_multiple_operations();
+    test_aof_absolute_expiry();
+    test_aof_torn_tail();
+    test_aof_replay_command_table();
     test_empty_aof();
     test_aof_special_chars();
     
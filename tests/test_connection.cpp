@@ -0,0 +1,297 @@
+#include "connection.h"
+#include "io_threads.h"
+#include "command_handler.h"
+#include "resp_encoder.h"
+#include "storage.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <sys/socket.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+using namespace std;
+
+// Run every complete command in the parser, queueing replies
+static size_t runCommands(Connection& client, CommandHandler& handler) {
+    vector<string_view> args;
+    size_t ran = 0;
+    while (client.parser.next(args) == ParseStatus::Ok) {
+        RespValue cmd;
+        cmd.type = RespType::Array;
+        for (string_view arg : args) {
+            RespValue v;
+            v.type = RespType::BulkString;
+            v.str_value.assign(arg);
+            cmd.arr_value.push_back(std::move(v));
+        }
+        client.reply.append(handler.handleCommand(cmd));
+        ran++;
+    }
+    return ran;
+}
+
+// Test: 10,000 commands pipelined in one write all get replies. The server
+// side waits edge-triggered like the event loop: if a wakeup left input
+// unread, no further edge comes and epoll_wait times out
+void testPipelinedBurst() {
+    const size_t COMMANDS = 10000;
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    string request, expected;
+    for (size_t i = 1; i <= COMMANDS; i++) {
+        request += RESPEncoder::encodeArray({"INCR", "counter"});
+        expected += ":" + to_string(i) + "\r\n";
+    }
+
+    string received;
+    thread peer([&] {
+        assert(write(fds[1], request.data(), request.size()) == (ssize_t)request.size());
+        char buf[65536];
+        while (received.size() < expected.size()) {
+            ssize_t n = read(fds[1], buf, sizeof(buf));
+            if (n <= 0) break;
+            received.append(buf, n);
+        }
+    });
+
+    Storage storage;
+    CommandHandler handler(storage);
+    Connection client;
+    int epollFd = epoll_create1(0);
+    epoll_event ev = {};
+    ev.events = EPOLLIN | EPOLLET;
+    ev.data.fd = fds[0];
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fds[0], &ev);
+
+    size_t ran = 0;
+    int wakeups = 0;
+    while (ran < COMMANDS) {
+        epoll_event event;
+        int n = epoll_wait(epollFd, &event, 1, 2000);
+        assert(n == 1);  // Stalled: input left unread after an edge
+        wakeups++;
+        assert(readQuery(fds[0], client.parser) == ReadResult::Drained);
+        ran += runCommands(client, handler);
+        while (client.reply.flush(fds[0]) == OutputBuffer::FlushResult::Pending) {
+            pollfd pfd = {fds[0], POLLOUT, 0};
+            poll(&pfd, 1, 1000);
+        }
+    }
+    peer.join();
+
+    assert(ran == COMMANDS);
+    assert(received == expected);
+    assert(client.parser.bufferedBytes() == 0);
+    close(epollFd);
+    close(fds[0]);
+    close(fds[1]);
+    cout << "✓ " << COMMANDS << " pipelined commands, " << COMMANDS << " replies ("
+         << wakeups << " wakeups)" << endl;
+}
+
+// Test: a frame split across reads waits in the query buffer
+void testPartialFrame() {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    Storage storage;
+    CommandHandler handler(storage);
+    Connection client;
+    string wire = RESPEncoder::encodeArray({"SET", "key", string(100000, 'v')});
+    size_t half = wire.size() / 2;
+
+    assert(write(fds[1], wire.data(), half) == (ssize_t)half);
+    assert(readQuery(fds[0], client.parser) == ReadResult::Drained);
+    assert(runCommands(client, handler) == 0);
+    assert(client.parser.bufferedBytes() == half);
+
+    thread peer([&] { assert(write(fds[1], wire.data() + half, wire.size() - half) > 0); });
+    size_t ran = 0;
+    while (ran == 0) {
+        pollfd pfd = {fds[0], POLLIN, 0};
+        poll(&pfd, 1, 1000);
+        assert(readQuery(fds[0], client.parser) == ReadResult::Drained);
+        ran = runCommands(client, handler);
+    }
+    peer.join();
+    assert(storage.get("key").value_or("").size() == 100000);
+    close(fds[0]);
+    close(fds[1]);
+    cout << "✓ Frame split across reads completes in the query buffer" << endl;
+}
+
+// Test: write commands keep their frames exactly as received (the AOF
+// logs those bytes); reads and inline commands keep none
+void testWriteFrames() {
+    Connection conn;
+    string set = "*3\r\n$3\r\nset\r\n$1\r\nk\r\n$01\r\nv\r\n";  // Non-canonical length kept as is
+    string get = RESPEncoder::encodeArray({"GET", "k"});
+    string del = RESPEncoder::encodeArray({"DEL", "a", "b"});
+    string wire = set + get + "INCR n\r\n" + del;
+    conn.parser.feed(wire.substr(0, 10));
+    parseCommands(conn);
+    assert(conn.commands.empty() && conn.argSpans.empty());
+    conn.parser.feed(wire.substr(10));
+    parseCommands(conn);
+    assert(conn.commands.size() == 4);
+    assert(conn.frame(0) == set && conn.frame(1).empty() && conn.frame(2).empty() && conn.frame(3) == del);
+
+    // Arguments are views of the query buffer itself
+    vector<string_view> argv;
+    CommandArgs args = conn.args(0, argv);
+    assert(args.size() == 3 && args[0] == "set" && args[2] == "v");
+    assert(args[1].data() == conn.frame(0).data() + 17);
+    args = conn.args(2, argv);
+    assert(args.size() == 2 && args[0] == "INCR" && args[1] == "n");
+    assert(conn.args(3, argv).size() == 3 && argv[2] == "b");
+    conn.clearCommands();
+    assert(conn.commands.empty() && conn.argSpans.empty());
+    cout << "✓ Write commands keep their received frames; arguments point into the buffer" << endl;
+}
+
+// Test: query buffer limit and peer close
+void testLimitAndClose() {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+
+    // An unfinished 1MB bulk only counts against the limit
+    RespParser parser;
+    string head = "*2\r\n$3\r\nGET\r\n$1048576\r\n" + string(8192, 'x');
+    assert(write(fds[1], head.data(), head.size()) == (ssize_t)head.size());
+    assert(readQuery(fds[0], parser, 4096) == ReadResult::TooBig);
+
+    RespParser fresh;
+    assert(readQuery(fds[0], fresh) == ReadResult::Drained);
+    close(fds[1]);
+    assert(readQuery(fds[0], fresh) == ReadResult::Closed);
+    close(fds[0]);
+    cout << "✓ Query buffer limit and peer close detected" << endl;
+}
+
+// Test: commands that arrive with the peer's FIN still run and get their
+// replies (a client that writes, then shuts down its write side)
+void testHalfClose() {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    string wire = RESPEncoder::encodeArray({"SET", "k", "v"}) + RESPEncoder::encodeArray({"GET", "k"});
+    assert(write(fds[1], wire.data(), wire.size()) == (ssize_t)wire.size());
+    assert(shutdown(fds[1], SHUT_WR) == 0);
+
+    Storage storage;
+    CommandHandler handler(storage);
+    Connection conn;
+    conn.fd = fds[0];
+    readAndParse(conn);
+    assert(conn.readResult == ReadResult::Closed);
+    assert(conn.commands.size() == 2);
+    vector<string_view> argv;
+    for (size_t i = 0; i < conn.commands.size(); i++) handler.handleCommand(conn.args(i, argv), conn.reply);
+    assert(conn.reply.flush(conn.fd) == OutputBuffer::FlushResult::Done);
+    close(fds[0]);
+
+    char buf[64];
+    ssize_t n = read(fds[1], buf, sizeof(buf));
+    assert(string(buf, n > 0 ? n : 0) == "+OK\r\n$1\r\nv\r\n");
+    assert(storage.get("k").value() == "v");
+    close(fds[1]);
+    cout << "✓ Commands sent right before a half-close run and get replies" << endl;
+}
+
+// Test: the table is indexed by fd and hands out stable pointers
+void testConnectionTable() {
+    ConnectionTable table;
+    assert(table.get(5) == nullptr && table.get(-1) == nullptr);
+
+    Connection* a = table.add(5);
+    Connection* b = table.add(20000);  // Grows to the fd
+    assert(a->fd == 5 && b->fd == 20000);
+    assert(table.get(5) == a && table.get(20000) == b);
+    assert(table.size() == 2);
+    for (int fd = 6; fd < 1000; fd++) table.add(fd);
+    assert(table.get(5) == a);  // Growth doesn't move connections
+
+    table.remove(5);
+    table.remove(5);
+    assert(table.get(5) == nullptr);
+    assert(table.size() == 995);
+    size_t visited = 0;
+    table.forEach([&](const Connection&) { visited++; });
+    assert(visited == 995);
+    cout << "✓ Connection table indexed by fd" << endl;
+}
+
+// Test: I/O threads read+parse and flush every connection of a batch
+void testIOThreads() {
+    const int CLIENTS = 64;
+    IOThreads io(4);
+    assert(io.count() == 4);
+
+    int peers[CLIENTS];
+    vector<unique_ptr<Connection>> conns;
+    vector<Connection*> batch;
+    for (int i = 0; i < CLIENTS; i++) {
+        int fds[2];
+        assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+        fcntl(fds[0], F_SETFL, O_NONBLOCK);
+        peers[i] = fds[1];
+        conns.emplace_back(new Connection());
+        conns.back()->fd = fds[0];
+        batch.push_back(conns.back().get());
+
+        string wire;
+        for (int c = 0; c <= i % 5; c++) wire += RESPEncoder::encodeArray({"GET", "key" + to_string(i)});
+        wire += "*2\r\n$3\r\nGET";  // Partial frame stays buffered
+        assert(write(peers[i], wire.data(), wire.size()) == (ssize_t)wire.size());
+    }
+
+    for (int round = 0; round < 3; round++) {
+        io.run(batch, IOThreads::Op::Read);
+        for (int i = 0; i < CLIENTS; i++) {
+            Connection& conn = *conns[i];
+            assert(conn.readResult == ReadResult::Drained);
+            assert(conn.commands.size() == (round == 0 ? (size_t)(i % 5 + 1) : 0));
+            vector<string_view> argv;
+            for (size_t c = 0; c < conn.commands.size(); c++) assert(conn.args(c, argv)[1] == "key" + to_string(i));
+            conn.clearCommands();
+            conn.reply.append("+reply" + to_string(i) + "\r\n");
+        }
+        io.run(batch, IOThreads::Op::Write);
+        for (int i = 0; i < CLIENTS; i++) {
+            assert(conns[i]->flushResult == OutputBuffer::FlushResult::Done);
+            char buf[64];
+            string expected = "+reply" + to_string(i) + "\r\n";
+            assert(read(peers[i], buf, sizeof(buf)) == (ssize_t)expected.size());
+            assert(string(buf, expected.size()) == expected);
+        }
+    }
+
+    for (int i = 0; i < CLIENTS; i++) {
+        assert(conns[i]->parser.bufferedBytes() == 11);
+        close(conns[i]->fd);
+        close(peers[i]);
+    }
+    cout << "✓ I/O threads read, parse and flush a batch of " << CLIENTS << " clients" << endl;
+}
+
+int main() {
+    cout << "\n=== Connection Read Path Tests ===\n" << endl;
+
+    testPipelinedBurst();
+    testPartialFrame();
+    testWriteFrames();
+    testLimitAndClose();
+    testHalfClose();
+    testConnectionTable();
+    testIOThreads();
+
+    cout << "\n✅ All connection tests passed!\n" << endl;
+    return 0;
+}
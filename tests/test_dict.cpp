@@ -0,0 +1,263 @@
+// Dict (hash table) Tests
+// Tests open addressing, backward-shift deletion and incremental rehashing
+
+#include "../include/dict.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+#include <map>
+#include <random>
+#include <vector>
+
+using namespace std;
+
+// Test: Insert, find, overwrite
+void test_insert_find() {
+    Dict<int> d;
+    d["a"] = 1;
+    d["b"] = 2;
+    d["a"] = 3;  // Overwrite
+
+    assert(d.size() == 2);
+    assert(d.find("a") != d.end() && d.find("a")->second == 3);
+    assert(d.find("b")->second == 2);
+    assert(d.find("missing") == d.end());
+
+    cout << "✓ Insert, find and overwrite work" << endl;
+}
+
+// Test: Erase by key and by iterator
+void test_erase() {
+    Dict<int> d;
+    for (int i = 0; i < 10; i++) d["k" + to_string(i)] = i;
+
+    assert(d.erase("k3") == true);
+    assert(d.erase("k3") == false);
+    assert(d.find("k3") == d.end());
+    assert(d.size() == 9);
+
+    // Every other key must still be reachable after backward shifts
+    for (int i = 0; i < 10; i++) {
+        if (i == 3) continue;
+        assert(d.find("k" + to_string(i))->second == i);
+    }
+
+    cout << "✓ Erase keeps probe chains intact" << endl;
+}
+
+// Test: Growth through incremental rehash keeps every key reachable
+void test_incremental_rehash() {
+    Dict<int> d;
+    const int N = 100000;
+    bool sawRehash = false;
+
+    for (int i = 0; i < N; i++) {
+        d["key:" + to_string(i)] = i;
+        if (d.isRehashing()) sawRehash = true;
+
+        // Spot-check an older key mid-rehash
+        if (i % 997 == 0) {
+            assert(d.find("key:" + to_string(i / 2))->second == i / 2);
+        }
+    }
+
+    assert(sawRehash);
+    assert(d.size() == (size_t)N);
+    for (int i = 0; i < N; i++) {
+        assert(d.find("key:" + to_string(i))->second == i);
+    }
+
+    cout << "✓ Incremental rehash keeps all keys reachable" << endl;
+}
+
+// Test: Table shrinks after mass deletion
+void test_shrink() {
+    Dict<int> d;
+    for (int i = 0; i < 10000; i++) d[to_string(i)] = i;
+    size_t bigCapacity = d.capacity();
+
+    for (int i = 0; i < 9990; i++) d.erase(to_string(i));
+    while (d.rehash(100)) {}
+
+    assert(d.size() == 10);
+    assert(d.capacity() < bigCapacity);
+    for (int i = 9990; i < 10000; i++) {
+        assert(d.find(to_string(i))->second == i);
+    }
+
+    cout << "✓ Table shrinks after mass deletion" << endl;
+}
+
+// Test: Iteration visits every entry once, erase-while-iterating works
+void test_iteration() {
+    Dict<int> d;
+    for (int i = 0; i < 1000; i++) d[to_string(i)] = i;
+
+    size_t count = 0;
+    long sum = 0;
+    for (const auto& [key, value] : d) {
+        count++;
+        sum += value;
+    }
+    assert(count == 1000);
+    assert(sum == 999L * 1000 / 2);
+
+    // Erase all odd values while iterating
+    for (auto it = d.begin(); it != d.end(); ) {
+        if (it->second % 2 == 1) {
+            it = d.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    assert(d.size() == 500);
+    for (const auto& entry : d) assert(entry.second % 2 == 0);
+
+    cout << "✓ Iteration and erase-while-iterating work" << endl;
+}
+
+// Test: Randomized operations match std::map
+void test_against_map() {
+    Dict<int> d;
+    map<string, int> ref;
+    mt19937 rng(42);
+
+    for (int i = 0; i < 200000; i++) {
+        string key = to_string(rng() % 5000);
+        int op = rng() % 3;
+        if (op == 0) {
+            d[key] = i;
+            ref[key] = i;
+        } else if (op == 1) {
+            assert(d.erase(key) == (ref.erase(key) == 1));
+        } else {
+            auto it = d.find(key);
+            auto rit = ref.find(key);
+            assert((it == d.end()) == (rit == ref.end()));
+            if (rit != ref.end()) assert(it->second == rit->second);
+        }
+    }
+    assert(d.size() == ref.size());
+
+    cout << "✓ Randomized operations match std::map" << endl;
+}
+
+// Test: randomEntry samples every key roughly uniformly
+void test_random_entry() {
+    Dict<int> d;
+    FastRandom rng(123);
+    assert(d.randomEntry(rng) == d.end());
+
+    const int N = 100;
+    for (int i = 0; i < N; i++) d[to_string(i)] = i;
+
+    // Delete most keys and sample mid-shrink (both tables populated)
+    for (int i = 0; i < 1000; i++) d[to_string(i)] = i % N;
+    for (int i = N; i < 1000; i++) d.erase(to_string(i));
+
+    vector<int> hits(N, 0);
+    const int SAMPLES = 200000;
+    for (int i = 0; i < SAMPLES; i++) {
+        auto it = d.randomEntry(rng);
+        assert(it != d.end());
+        hits[stoi(it->first)]++;
+    }
+
+    // Expected 2000 per key; allow generous +/-20%
+    for (int h : hits) assert(h > 1600 && h < 2400);
+
+    cout << "✓ randomEntry samples keys uniformly" << endl;
+}
+
+// Test: reserve sizes the table once, empty or not
+void test_reserve() {
+    // Keys in another table's slot order (as a snapshot has them) go in
+    // without a single resize
+    Dict<int> source;
+    const int N = 90000;  // ~69% of 131072 slots
+    for (int i = 0; i < N; i++) source["key:" + to_string(i)] = i;
+    Dict<int> d;
+    d.reserve(N);
+    size_t capacity = d.capacity();
+    assert(capacity >= (size_t)N * 4 / 3);
+    for (auto it = source.begin(); it != source.end(); ++it) {
+        d[it->first] = it->second;
+        assert(!d.isRehashing());
+    }
+    assert(d.capacity() == capacity && d.size() == (size_t)N);
+
+    // A non-empty table is grown in one go, keeping its keys
+    Dict<int> partial;
+    for (int i = 0; i < 1000; i++) partial["key:" + to_string(i)] = i;
+    partial.reserve(N);
+    assert(!partial.isRehashing() && partial.capacity() == capacity);
+    for (int i = 0; i < 1000; i++) assert(partial.find("key:" + to_string(i))->second == i);
+    partial.reserve(10);  // Never shrinks
+    assert(partial.capacity() == capacity);
+
+    cout << "✓ reserve() presizes (keys in slot order never trigger a resize)" << endl;
+}
+
+// Test: scan() visits every entry, even with entries moving between calls
+void test_scan() {
+    Dict<int> d;
+    for (int i = 0; i < 10000; i++) d["key:" + to_string(i)] = i;
+    vector<int> seen(10000);
+    uint64_t cursor = 0;
+    size_t steps = 0;
+    do {
+        cursor = d.scan(cursor, [&](const Dict<int>::Entry& e) { seen[e.second]++; });
+        steps++;
+    } while (cursor != 0);
+    for (int n : seen) assert(n == 1);  // Table unchanged: each exactly once
+    assert(steps == d.capacity());
+
+    // Between steps, erase (backward shifts, then a shrink) and insert
+    // (growth): every key there throughout is still visited
+    Dict<int> m;
+    const int STABLE = 5000, TEMP = 40000;
+    for (int i = 0; i < STABLE; i++) m["stable:" + to_string(i)] = i;
+    for (int i = 0; i < TEMP; i++) m["temp:" + to_string(i)] = -1;
+    vector<int> visits(STABLE);
+    int next = 0;
+    bool rehashed = false;
+    cursor = 0;
+    do {
+        cursor = m.scan(cursor, [&](const Dict<int>::Entry& e) {
+            if (e.second >= 0) visits[e.second]++;
+        });
+        for (int k = 0; k < 2; k++, next++) {
+            if (next < TEMP) {
+                m.erase("temp:" + to_string(next));
+            } else {
+                m["new:" + to_string(next)] = -1;
+            }
+        }
+        rehashed |= m.isRehashing();
+    } while (cursor != 0);
+    assert(rehashed && next > TEMP);
+    for (int n : visits) assert(n >= 1);
+
+    Dict<int> empty;
+    assert(empty.scan(0, [](const Dict<int>::Entry&) { assert(false); }) == 0);
+
+    cout << "✓ scan() visits every entry across resizes and backward shifts" << endl;
+}
+
+int main() {
+    cout << "\n=== Dict (Hash Table) Tests ===\n" << endl;
+
+    test_insert_find();
+    test_erase();
+    test_incremental_rehash();
+    test_shrink();
+    test_iteration();
+    test_against_map();
+    test_random_entry();
+    test_reserve();
+    test_scan();
+
+    cout << "\n✅ All dict tests passed!\n" << endl;
+
+    return 0;
+}
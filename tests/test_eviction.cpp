@@ -11,8 +11,8 @@ void testEviction() {
     
     Storage store;
     
-    // Note: Default maxKeys = 1000, but we can't change it without adding a setter
-    // So let's just demonstrate the concept by manually testing the flow
+    // Note: No key or memory limit by default, so nothing is evicted here;
+    // this just demonstrates the LRU flow
     
     cout << "\n1. Testing eviction when limit is reached:" << endl;
     cout << "   Setting 5 keys: key1, key2, key3, key4, key5" << endl;
@@ -62,7 +62,7 @@ void testEviction() {
     cout << "   All 5 keys confirmed present" << endl;
     
     cout << "\n✓ Eviction test passed!" << endl;
-    cout << "\nNOTE: With default maxKeys=1000, eviction won't trigger in this small test." << endl;
+    cout << "\nNOTE: With no limit set (the default), eviction won't trigger in this test." << endl;
     cout << "In production, when limit is reached, LRU victim (key2) would be evicted." << endl;
 }
 
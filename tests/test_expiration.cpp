@@ -193,6 +193,77 @@ void testCommandTable() {
     result = handler.handleCommand(getCmd);
     assert(result.find("wrong number of arguments") != string::npos);
     
+    // Lookup is case-insensitive and needs the exact name
+    assert(CommandHandler::lookupCommand("expire")->arity == 3);
+    assert(CommandHandler::lookupCommand("eXpIrE") == CommandHandler::lookupCommand("EXPIRE"));
+    assert(CommandHandler::lookupCommand("EXPIREX") == nullptr);
+    assert(CommandHandler::lookupCommand("GE") == nullptr);
+    assert(CommandHandler::lookupCommand("") == nullptr);
+    assert(handler.handleCommand(makeCommand({"set", "k", "v", "px", "1000"})) == "+OK\r\n");
+    
+    // Only changes to the keyspace count as dirty (they get logged)
+    uint64_t dirty = handler.dirtyCount();
+    handler.handleCommand(makeCommand({"GET", "k"}));
+    handler.handleCommand(makeCommand({"DEL", "nokey"}));
+    handler.handleCommand(makeCommand({"INCR", "k"}));  // Not an integer
+    handler.handleCommand(makeCommand({"SET", "k", "v", "EX", "0"}));
+    assert(handler.dirtyCount() == dirty);
+    handler.handleCommand(makeCommand({"SET", "n", "1"}));
+    handler.handleCommand(makeCommand({"INCR", "n"}));
+    handler.handleCommand(makeCommand({"DEL", "n", "nokey"}));
+    assert(handler.dirtyCount() == dirty + 3);
+
+    // Relative TTLs are rewritten as deadlines for the AOF; PXAT and
+    // PEXPIREAT are accepted as sent
+    Storage::setMockTimeMs(1000000);
+    handler.handleCommand(makeCommand({"SET", "t", "v", "EX", "5"}));
+    assert(handler.rewrittenCommand() == RESPEncoder::encodeArray({"SET", "t", "v", "PXAT", "1005000"}));
+    handler.handleCommand(makeCommand({"expire", "t", "7"}));
+    assert(handler.rewrittenCommand() == RESPEncoder::encodeArray({"PEXPIREAT", "t", "1007000"}));
+    assert(handler.handleCommand(makeCommand({"pexpireat", "t", "1009000"})) == ":1\r\n");
+    assert(handler.rewrittenCommand().empty() && storage.getTTL("t") == 9);
+    assert(handler.handleCommand(makeCommand({"SET", "t", "v", "pxat", "1002000"})) == "+OK\r\n");
+    assert(handler.rewrittenCommand().empty() && storage.getTTL("t") == 2);
+    // A deadline already passed deletes the key, propagated as DEL
+    assert(handler.handleCommand(makeCommand({"SET", "t", "v", "PXAT", "999999"})) == "+OK\r\n");
+    assert(!storage.exists("t") && handler.rewrittenCommand() == RESPEncoder::encodeArray({"DEL", "t"}));
+    handler.handleCommand(makeCommand({"SET", "t", "v"}));
+    assert(handler.handleCommand(makeCommand({"EXPIRE", "t", "-1"})) == ":1\r\n" && !storage.exists("t"));
+    Storage::setMockTimeMs(0);
+
+    // Handlers run on argument views directly
+    string_view args[] = {"Get", "k"};
+    OutputBuffer out;
+    handler.handleCommand(CommandArgs(args, 2), out);
+    assert(out.take() == "$1\r\nv\r\n");
+    
+    cout << "PASSED" << endl;
+}
+
+void testExpireOverflow() {
+    cout << "[TEST 11] TTLs whose deadline would overflow... ";
+    Storage storage;
+    CommandHandler handler(storage);
+    handler.handleCommand(makeCommand({"SET", "k", "v"}));
+    
+    // now + amount * unit past INT64_MAX: refused, nothing changed
+    string max = to_string(INT64_MAX);
+    string secondsMax = to_string(INT64_MAX / 1000);
+    const string setError = "-ERR invalid expire time in 'set' command\r\n";
+    const string expireError = "-ERR invalid expire time in 'expire' command\r\n";
+    assert(handler.handleCommand(makeCommand({"SET", "k", "new", "EX", secondsMax})) == setError);
+    assert(handler.handleCommand(makeCommand({"SET", "k", "new", "EX", max})) == setError);
+    assert(handler.handleCommand(makeCommand({"SET", "k", "new", "PX", max})) == setError);
+    assert(handler.handleCommand(makeCommand({"EXPIRE", "k", secondsMax})) == expireError);
+    assert(handler.handleCommand(makeCommand({"EXPIRE", "k", max})) == expireError);
+    assert(storage.get("k").value() == "v" && storage.getTTL("k") == -1);
+    
+    // The largest deadlines that fit are accepted
+    int64_t now = Storage::getCurrentTimeMs();
+    assert(handler.handleCommand(makeCommand({"SET", "k", "v", "PX", to_string(INT64_MAX - now - 1000)})) == "+OK\r\n");
+    assert(handler.handleCommand(makeCommand({"EXPIRE", "k", to_string(INT64_MAX / 1000 - now / 1000 - 1)})) == ":1\r\n");
+    assert(storage.getTTL("k") > 0);
+    
     cout << "PASSED" << endl;
 }
 
@@ -213,10 +284,11 @@ int main() {
         testUnknownOption();
         testStorageDirectly();
         testCommandTable();
+        testExpireOverflow();
         
         cout << endl;
         cout << "========================================" << endl;
-        cout << "✓ All 10 tests passed!" << endl;
+        cout << "✓ All 11 tests passed!" << endl;
         cout << "========================================" << endl;
         return 0;
         
@@ -0,0 +1,127 @@
+#include "../include/storage.h"
+#include <iostream>
+#include <cassert>
+#include <vector>
+#include <string>
+#include <random>
+
+using namespace std;
+
+// Replay a trace against Storage with the given policy, return hit ratio
+// Uses a simulated clock (1ms per access) so results are deterministic
+double runTrace(const string& policy, const vector<string>& trace, size_t capacity) {
+    Storage store;
+    assert(store.setEvictionPolicy(policy));
+    store.setMaxKeys(capacity);
+
+    int64_t clock = 1;
+    size_t hits = 0;
+    for (const auto& key : trace) {
+        Storage::setMockTimeMs(clock++);
+        if (store.get(key).has_value()) {
+            hits++;
+        } else {
+            store.set(key, "v");
+        }
+    }
+    Storage::setMockTimeMs(0);
+
+    assert(store.size() == capacity);
+    return (double)hits / trace.size();
+}
+
+void testPolicyValidation() {
+    cout << "\n=== Testing Eviction Policy Configuration ===" << endl;
+
+    Storage store;
+    assert(store.getEvictionPolicy() == "allkeys-lru");
+    assert(store.setEvictionPolicy("allkeys-lfu"));
+    assert(store.setEvictionPolicy("volatile-lfu"));
+    assert(!store.setEvictionPolicy("bogus"));
+    assert(store.getEvictionPolicy() == "volatile-lfu");
+
+    cout << "   ✓ Known policies accepted, unknown rejected" << endl;
+}
+
+void testScanResistance() {
+    cout << "\n=== Hit Ratio: LRU vs LFU under Scan Pollution ===" << endl;
+
+    const int HOT_KEYS = 500;
+    const size_t CAPACITY = 1000;
+    const int ROUNDS = 30;
+    const int HOT_ACCESSES = 2000;  // Per round, uniform over the hot set
+    const int SCAN_KEYS = 2000;     // Per round, each touched exactly once
+
+    // Hot working set interleaved with one-off scans larger than the cache
+    vector<string> trace;
+    mt19937 rng(7);
+    int scanId = 0;
+    for (int r = 0; r < ROUNDS; r++) {
+        for (int i = 0; i < HOT_ACCESSES; i++) {
+            trace.push_back("hot:" + to_string(rng() % HOT_KEYS));
+        }
+        for (int i = 0; i < SCAN_KEYS; i++) {
+            trace.push_back("scan:" + to_string(scanId++));
+        }
+    }
+
+    double lru = runTrace("allkeys-lru", trace, CAPACITY);
+    double lfu = runTrace("allkeys-lfu", trace, CAPACITY);
+
+    cout << "   allkeys-lru hit ratio: " << lru << endl;
+    cout << "   allkeys-lfu hit ratio: " << lfu << endl;
+
+    // Scans flush the hot set from LRU every round; LFU keeps it
+    assert(lfu > lru + 0.1 && "LFU should resist scan pollution");
+
+    cout << "\n✓ LFU keeps the hot set through scans" << endl;
+}
+
+void testVolatileLFU() {
+    cout << "\n=== Testing volatile-lfu (only TTL keys evicted) ===" << endl;
+
+    Storage store;
+    store.setEvictionPolicy("volatile-lfu");
+    store.setMaxKeys(10);
+
+    // 5 persistent keys, 5 keys with TTL
+    for (int i = 0; i < 5; i++) {
+        store.set("persistent:" + to_string(i), "v");
+        store.setWithExpiry("volatile:" + to_string(i), "v", 60000);
+    }
+
+    // Make volatile:0 frequently used so a colder volatile key goes first
+    for (int i = 0; i < 50; i++) store.get("volatile:0");
+
+    store.set("new", "v");
+
+    for (int i = 0; i < 5; i++) {
+        assert(store.exists("persistent:" + to_string(i)) && "persistent keys must not be evicted");
+    }
+    assert(store.exists("volatile:0") && "hot volatile key should survive");
+    assert(store.exists("new"));
+    assert(store.size() == 10);
+
+    cout << "   ✓ Only keys with TTL were eviction candidates" << endl;
+}
+
+int main() {
+    cout << "╔═══════════════════════════════════════╗" << endl;
+    cout << "║   LFU Eviction - Comprehensive Test  ║" << endl;
+    cout << "╚═══════════════════════════════════════╝" << endl;
+
+    try {
+        testPolicyValidation();
+        testScanResistance();
+        testVolatileLFU();
+
+        cout << "\n╔═══════════════════════════════════════╗" << endl;
+        cout << "║   All LFU Eviction Tests Passed! ✓   ║" << endl;
+        cout << "╚═══════════════════════════════════════╝" << endl;
+
+        return 0;
+    } catch (const exception& e) {
+        cerr << "\n✗ Test failed: " << e.what() << endl;
+        return 1;
+    }
+}
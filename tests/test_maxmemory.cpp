@@ -0,0 +1,130 @@
+// Memory Accounting Tests
+// Tests used_memory tracking and maxmemory-based eviction
+
+#include "../include/storage.h"
+#include "../include/command_handler.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+using namespace std;
+
+// Test: Accounting returns to baseline after deletes
+void test_accounting_round_trip() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    size_t empty = storage.usedMemory();
+
+    for (int i = 0; i < 1000; i++) {
+        storage.set("key:" + to_string(i), string(100, 'x'));
+    }
+    size_t full = storage.usedMemory();
+    assert(full > empty + 1000 * 100);
+
+    for (int i = 0; i < 1000; i++) {
+        storage.del("key:" + to_string(i));
+    }
+    // Slot arrays may not have shrunk yet, but all key/value heap is released
+    storage.set("probe", "x");
+    storage.del("probe");
+    assert(storage.usedMemory() < full);
+    assert(storage.getUsedMemoryPeak() >= full);
+
+    cout << "✓ Memory released on delete, peak retained" << endl;
+}
+
+// Test: Large values are accounted by size, small ones cost nothing extra (SSO)
+void test_value_sizes() {
+    Storage storage;
+    storage.set("a", "tiny");
+    size_t before = storage.usedMemory();
+
+    storage.set("a", string(1000000, 'x'));  // Overwrite with 1 MB
+    size_t after = storage.usedMemory();
+    assert(after - before >= 1000000);
+
+    storage.set("a", "tiny");  // Shrink back
+    assert(storage.usedMemory() == before);
+
+    cout << "✓ Overwrites adjust accounting by value size" << endl;
+}
+
+// Test: INCR that changes the value's encoding is tracked
+void test_incr_accounting() {
+    Storage storage;
+    CommandHandler handler(storage);
+    storage.set("counter", "00000000000000000000000000000999");  // Not canonical: RAW (heap)
+    size_t before = storage.usedMemory();
+
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    for (const char* arg : {"INCR", "counter"}) {
+        RespValue v;
+        v.type = RespType::BulkString;
+        v.str_value = arg;
+        cmd.arr_value.push_back(v);
+    }
+    assert(handler.handleCommand(cmd) == ":1000\r\n");  // INT: no heap buffer
+    assert(storage.usedMemory() < before);
+
+    storage.del("counter");
+    cout << "✓ INCR re-encoding is accounted" << endl;
+}
+
+// Test: maxmemory evicts until back under budget with mixed value sizes
+void test_maxmemory_eviction() {
+    Storage storage;
+    storage.setMaxKeys(0);
+    const size_t LIMIT = 2 * 1024 * 1024;  // 2 MB
+    storage.setMaxMemory(LIMIT);
+
+    for (int i = 0; i < 5000; i++) {
+        size_t len = (i % 10 == 0) ? 64 * 1024 : 10;  // Mostly tiny, some 64 KB
+        storage.set("key:" + to_string(i), string(len, 'v'));
+
+        // Eviction runs before each write: at most one value over budget,
+        // plus a slot array that may have just started growing
+        assert(storage.usedMemory() <= LIMIT + 256 * 1024);
+    }
+
+    assert(storage.getEvictedKeys() > 0);
+    assert(storage.size() < 5000);
+    assert(storage.exists("key:4999"));  // Most recent key survives
+
+    cout << "✓ maxmemory eviction keeps used_memory near the limit" << endl;
+}
+
+// Test: INFO exposes memory stats
+void test_info_memory() {
+    Storage storage;
+    CommandHandler handler(storage);
+    storage.set("key", string(100, 'x'));
+
+    RespValue cmd;
+    cmd.type = RespType::Array;
+    RespValue name;
+    name.type = RespType::BulkString;
+    name.str_value = "INFO";
+    cmd.arr_value.push_back(name);
+
+    string info = handler.handleCommand(cmd);
+    assert(info.find("used_memory:" + to_string(storage.usedMemory())) != string::npos);
+    assert(info.find("used_memory_peak:") != string::npos);
+    assert(info.find("maxmemory_policy:allkeys-lru") != string::npos);
+
+    cout << "✓ INFO reports used_memory and used_memory_peak" << endl;
+}
+
+int main() {
+    cout << "\n=== Memory Accounting Tests ===\n" << endl;
+
+    test_accounting_round_trip();
+    test_value_sizes();
+    test_incr_accounting();
+    test_maxmemory_eviction();
+    test_info_memory();
+
+    cout << "\n✅ All memory tests passed!\n" << endl;
+
+    return 0;
+}
@@ -0,0 +1,159 @@
+#include "output_buffer.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+using namespace std;
+
+// Non-blocking socketpair with small kernel buffers, so flush() hits
+// partial writes and EAGAIN after a few KB
+static void smallSocketPair(int fds[2]) {
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    int size = 4096;
+    setsockopt(fds[0], SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+    setsockopt(fds[1], SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+    fcntl(fds[0], F_SETFL, O_NONBLOCK);
+    fcntl(fds[1], F_SETFL, O_NONBLOCK);
+}
+
+static string readAvailable(int fd) {
+    string out;
+    char buf[8192];
+    ssize_t n;
+    while ((n = read(fd, buf, sizeof(buf))) > 0) out.append(buf, n);
+    return out;
+}
+
+// Test: replies of every size arrive intact and in order across partial
+// writes, EAGAIN and resumed flushes
+void testPartialWrites() {
+    int fds[2];
+    smallSocketPair(fds);
+
+    OutputBuffer out;
+    string expected;
+    for (int i = 0; i < 200; i++) {
+        // Small replies share chunks, big ones get their own
+        string reply = i % 10 == 0 ? string(40000 + i, 'a' + i % 26) : "+reply " + to_string(i) + "\r\n";
+        out.append(reply);
+        expected += reply;
+    }
+    assert(out.pending() == expected.size());
+
+    string received;
+    int pendingRounds = 0;
+    while (true) {
+        OutputBuffer::FlushResult result = out.flush(fds[0]);
+        assert(result != OutputBuffer::FlushResult::Error);
+        if (result == OutputBuffer::FlushResult::Done) break;
+        pendingRounds++;
+        assert(out.pending() > 0);
+        pollfd pfd = {fds[1], POLLIN, 0};
+        poll(&pfd, 1, 1000);
+        received += readAvailable(fds[1]);
+    }
+    received += readAvailable(fds[1]);
+
+    assert(pendingRounds > 0);  // The small socket buffer forced backpressure
+    assert(out.empty());
+    assert(received == expected);
+    close(fds[0]);
+    close(fds[1]);
+    cout << "✓ " << expected.size() << " bytes delivered in order over " << pendingRounds
+         << " EAGAIN rounds" << endl;
+}
+
+// Test: emptied 16KB chunks are reused; big one-off replies are freed
+void testChunkReuse() {
+    int fds[2];
+    smallSocketPair(fds);
+
+    OutputBuffer out;
+    assert(out.memoryUsage() == 0);
+    for (int i = 0; i < 1000; i++) {
+        out.append("+OK\r\n");
+        assert(out.flush(fds[0]) == OutputBuffer::FlushResult::Done);
+        readAvailable(fds[1]);
+    }
+    // One chunk in flight + one spare at most, never one per reply
+    assert(out.memoryUsage() <= 2 * OutputBuffer::CHUNK_SIZE);
+
+    out.append(string(1024 * 1024, 'x'));
+    assert(out.memoryUsage() >= 1024 * 1024);
+    size_t received = 0;
+    while (out.flush(fds[0]) == OutputBuffer::FlushResult::Pending) {
+        received += readAvailable(fds[1]).size();
+    }
+    received += readAvailable(fds[1]).size();
+    assert(received == 1024 * 1024);
+    assert(out.memoryUsage() <= 2 * OutputBuffer::CHUNK_SIZE);
+    close(fds[0]);
+    close(fds[1]);
+    cout << "✓ Chunks reused across replies, large reply buffers released" << endl;
+}
+
+// Test: hard limit disconnects at once, soft limit only after softSeconds
+void testLimits() {
+    OutputLimits limits;
+    limits.hardBytes = 1000;
+    limits.softBytes = 100;
+    limits.softSeconds = 2;
+
+    OutputBuffer out;
+    out.append(string(50, 'x'));
+    assert(!out.overLimit(limits, 0));
+
+    out.append(string(100, 'x'));      // Above soft, below hard
+    assert(!out.overLimit(limits, 1000));
+    assert(!out.overLimit(limits, 2999));
+    assert(out.overLimit(limits, 3000));
+
+    OutputBuffer burst;                // Dipping below soft resets the timer
+    burst.append(string(150, 'x'));
+    assert(!burst.overLimit(limits, 0));
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    assert(burst.flush(fds[0]) == OutputBuffer::FlushResult::Done);
+    burst.append(string(150, 'x'));
+    assert(!burst.overLimit(limits, 2500));
+    assert(!burst.overLimit(limits, 4000));
+
+    OutputBuffer flood;
+    flood.append(string(1000, 'x'));
+    assert(flood.overLimit(limits, 0));
+
+    OutputLimits none = {0, 0, 0};
+    assert(!flood.overLimit(none, 1000000));
+    close(fds[0]);
+    close(fds[1]);
+    cout << "✓ Hard and soft output buffer limits" << endl;
+}
+
+// Test: a closed peer is an Error, not SIGPIPE
+void testClosedPeer() {
+    int fds[2];
+    assert(socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == 0);
+    close(fds[1]);
+
+    OutputBuffer out;
+    out.append("+OK\r\n");
+    assert(out.flush(fds[0]) == OutputBuffer::FlushResult::Error);
+    assert(out.pending() == 5);
+    close(fds[0]);
+    cout << "✓ Closed peer reported as an error (no SIGPIPE)" << endl;
+}
+
+int main() {
+    cout << "\n=== Output Buffer Tests ===\n" << endl;
+
+    testPartialWrites();
+    testChunkReuse();
+    testLimits();
+    testClosedPeer();
+
+    cout << "\n✅ All output buffer tests passed!\n" << endl;
+    return 0;
+}
@@ -7,6 +7,14 @@
 
 using namespace std;
 
+// The LRU clock has 1s resolution: step a simulated clock instead of sleeping
+static int64_t testClock = 0;
+static void tickSecond() {
+    if (testClock == 0) testClock = Storage::getCurrentTimeMs();
+    testClock += LRU_CLOCK_RESOLUTION_MS;
+    Storage::setMockTimeMs(testClock);
+}
+
 void testRandomSampling() {
     cout << "\n=== Testing Random Sampling Distribution ===" << endl;
     
@@ -18,7 +26,7 @@ void testRandomSampling() {
     // Create 20 keys with increasing timestamps
     for (int i = 0; i < 20; i++) {
         store.set("key" + to_string(i), "value" + to_string(i));
-        this_thread::sleep_for(chrono::milliseconds(5));
+        tickSecond();
     }
     
     cout << "   Set 20 keys, oldest 10 should be evicted" << endl;
@@ -66,7 +74,7 @@ void testSamplingFairness() {
         for (int i = 0; i < 10; i++) {
             string key = "key" + to_string(i);
             store.set(key, "value");
-            this_thread::sleep_for(chrono::milliseconds(2));
+            tickSecond();
         }
         
         // Check which keys survived (others were evicted)
@@ -100,16 +108,16 @@ void testLRUAccuracy() {
     
     cout << "\n1. Setting 3 keys:" << endl;
     store.set("key1", "val1");
-    this_thread::sleep_for(chrono::milliseconds(10));
+    tickSecond();
     store.set("key2", "val2");
-    this_thread::sleep_for(chrono::milliseconds(10));
+    tickSecond();
     store.set("key3", "val3");
-    this_thread::sleep_for(chrono::milliseconds(10));
+    tickSecond();
     cout << "   All 3 keys set (key1 is oldest)" << endl;
     
     cout << "\n2. Accessing key1 and key2 (making them recent):" << endl;
     store.get("key1");
-    this_thread::sleep_for(chrono::milliseconds(5));
+    tickSecond();
     store.get("key2");
     cout << "   LRU order: key3 (oldest), key1, key2 (newest)" << endl;
     
@@ -0,0 +1,282 @@
+// RDB Snapshot Tests
+// Binary snapshot format, SAVE/BGSAVE, save points and loading with the AOF
+
+#include "../include/rdb.h"
+#include "../include/crc64.h"
+#include "../include/aof.h"
+#include "../include/storage.h"
+#include "../include/shard.h"
+#include <iostream>
+#include <cassert>
+#include <fstream>
+#include <climits>
+#include <thread>
+#include <chrono>
+#include <unistd.h>
+
+using namespace std;
+
+const string TEST_RDB_FILE = "test_dump.rdb";
+const string TEST_AOF_FILE = "test_rdb_appendonly.aof";
+const int64_t BASE_MS = 1700000000000;
+
+void cleanup() {
+    remove(TEST_RDB_FILE.c_str());
+    remove(TEST_AOF_FILE.c_str());
+}
+
+string readFile(const string& name) {
+    ifstream file(name, ios::binary);
+    return string((istreambuf_iterator<char>(file)), istreambuf_iterator<char>());
+}
+
+void writeFile(const string& name, const string& content) {
+    ofstream file(name, ios::binary | ios::trunc);
+    file << content;
+}
+
+// Wait for a BGSAVE child to finish (reaping it)
+void waitForSave(RDB& rdb) {
+    for (int i = 0; i < 500 && rdb.isSaveInProgress(); i++) this_thread::sleep_for(chrono::milliseconds(10));
+    assert(!rdb.isSaveInProgress());
+}
+
+// Test: CRC-64/Jones check value, and checksumming in pieces
+void test_crc64() {
+    assert(crc64(0, "123456789", 9) == 0xe9c6d914c4b8d9caULL);
+    string data(1000, '\0');
+    for (size_t i = 0; i < data.size(); i++) data[i] = (char)(i * 131 + 7);
+    uint64_t whole = crc64(0, data.data(), data.size());
+    for (size_t split : {1, 7, 8, 333, 999}) {
+        assert(crc64(crc64(0, data.data(), split), data.data() + split, data.size() - split) == whole);
+    }
+    cout << "✓ CRC-64/Jones check value; slice-by-8 matches in any split" << endl;
+}
+
+// Test: every value encoding and deadlines survive a save and load
+void test_rdb_round_trip() {
+    cleanup();
+    Storage::setMockTimeMs(BASE_MS);
+    string big(1000, 'x');
+    string binary("a\0b\r\nc", 6);
+    {
+        Storage storage;
+        storage.set("embstr", "hello");
+        storage.set("raw", big);
+        storage.set("binary", binary);
+        storage.set("empty", "");
+        storage.set("int", "12345");
+        storage.set("negative", "-42");
+        storage.set("min", to_string(LLONG_MIN));
+        storage.set("max", to_string(LLONG_MAX));
+        storage.set("padded", "007");  // Not canonical: stays a string
+        storage.setWithExpireAt("soon", "v", BASE_MS + 1000);
+        storage.setWithExpireAt("later", "v", BASE_MS + 5000);
+        storage.setWithExpireAt("gone", "v", BASE_MS - 1);  // Expired, not reclaimed yet
+
+        RDB rdb(TEST_RDB_FILE);
+        SnapshotInfo info;
+        info.aofInode = 77;
+        info.aofOffset = 1234;
+        assert(rdb.save({&storage}, info));
+    }
+
+    RDB rdb(TEST_RDB_FILE);
+    SnapshotInfo info;
+    assert(rdb.readInfo(info) == RDB::LoadStatus::Ok);
+    assert(info.aofInode == 77 && info.aofOffset == 1234 && info.createdMs == BASE_MS);
+
+    // Loaded 2s later: "soon" has expired meanwhile, "later" has 3s left
+    Storage::setMockTimeMs(BASE_MS + 2000);
+    Storage storage;
+    assert(rdb.load({&storage}) == RDB::LoadStatus::Ok);
+    assert(storage.size() == 10);
+    assert(storage.get("embstr").value() == "hello");
+    assert(storage.get("raw").value() == big);
+    assert(storage.get("binary").value() == binary);
+    assert(storage.get("empty").value() == "");
+    assert(storage.get("negative").value() == "-42");
+    assert(storage.get("min").value() == to_string(LLONG_MIN));
+    assert(storage.get("max").value() == to_string(LLONG_MAX));
+    assert(storage.get("padded").value() == "007");
+    assert(storage.getValue("int")->encoding() == OBJ_ENCODING_INT);
+    assert(storage.getValue("padded")->encoding() != OBJ_ENCODING_INT);
+    assert(!storage.exists("soon") && !storage.exists("gone"));
+    assert(storage.getTTL("later") == 3 && storage.getTTL("embstr") == -1);
+    assert(storage.expiresCount() == 1);
+
+    Storage::setMockTimeMs(0);
+    cleanup();
+    cout << "✓ Strings, integers and deadlines round-trip; expired keys skipped" << endl;
+}
+
+// Test: a damaged file is refused whole, a missing one reported
+void test_rdb_corruption() {
+    cleanup();
+    RDB rdb(TEST_RDB_FILE);
+    Storage storage;
+    SnapshotInfo info;
+    assert(rdb.load({&storage}) == RDB::LoadStatus::NoFile);
+    assert(rdb.readInfo(info) == RDB::LoadStatus::NoFile);
+
+    {
+        Storage source;
+        for (int i = 0; i < 100; i++) source.set("key:" + to_string(i), "value:" + to_string(i));
+        assert(rdb.save({&source}, SnapshotInfo()));
+    }
+    string good = readFile(TEST_RDB_FILE);
+
+    // One flipped bit anywhere: checksum mismatch, nothing loaded
+    for (size_t pos : {(size_t)20, good.size() / 2, good.size() - 9, good.size() - 1}) {
+        string bad = good;
+        bad[pos] ^= 0x10;
+        writeFile(TEST_RDB_FILE, bad);
+        assert(rdb.load({&storage}) == RDB::LoadStatus::Corrupt);
+        assert(storage.size() == 0);
+    }
+
+    // Cut short, or not a snapshot at all
+    writeFile(TEST_RDB_FILE, good.substr(0, good.size() - 20));
+    assert(rdb.load({&storage}) == RDB::LoadStatus::Corrupt);
+    writeFile(TEST_RDB_FILE, "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$1\r\nv\r\n");
+    assert(rdb.load({&storage}) == RDB::LoadStatus::Corrupt);
+    assert(rdb.readInfo(info) == RDB::LoadStatus::Corrupt);
+    assert(storage.size() == 0);
+
+    writeFile(TEST_RDB_FILE, good);
+    assert(rdb.load({&storage}) == RDB::LoadStatus::Ok && storage.size() == 100);
+
+    cleanup();
+    cout << "✓ Flipped bits, truncation and foreign files refused (nothing loaded)" << endl;
+}
+
+// Test: BGSAVE snapshots the keyspace as of the fork; save points
+void test_rdb_bgsave_and_save_points() {
+    cleanup();
+    Storage::setMockTimeMs(BASE_MS);
+    Storage storage;
+    RDB rdb(TEST_RDB_FILE);
+    rdb.setSavePoints({{60, 2}, {3600, 1}});
+
+    // Enough changes but not enough time, then both
+    assert(!rdb.savePointReached(1));
+    assert(!rdb.savePointReached(5));
+    Storage::setMockTimeMs(BASE_MS + 61000);
+    assert(!rdb.savePointReached(1));
+    assert(rdb.savePointReached(2));
+
+    storage.set("a", "1");
+    storage.set("b", "2");
+    assert(rdb.bgSave({&storage}, SnapshotInfo(), 2));
+    assert(!rdb.bgSave({&storage}, SnapshotInfo(), 2));  // One at a time
+    storage.set("c", "3");  // After the fork: not in this snapshot
+    waitForSave(rdb);
+    assert(rdb.lastSaveSucceeded() && rdb.lastSaveTime() == BASE_MS + 61000);
+    assert(rdb.changesSinceSave(3) == 1 && !rdb.savePointReached(3));
+
+    Storage loaded;
+    assert(rdb.load({&loaded}) == RDB::LoadStatus::Ok);
+    assert(loaded.size() == 2 && loaded.exists("a") && loaded.exists("b") && !loaded.exists("c"));
+
+    // A failed BGSAVE is retried no sooner than 5s later
+    RDB broken("no-such-dir/dump.rdb");
+    broken.setSavePoints({{1, 1}});
+    Storage::setMockTimeMs(BASE_MS + 100000);
+    assert(broken.savePointReached(1));
+    assert(broken.bgSave({&storage}, SnapshotInfo(), 1));
+    waitForSave(broken);
+    assert(!broken.lastSaveSucceeded());
+    assert(!broken.savePointReached(1));
+    Storage::setMockTimeMs(BASE_MS + 105000);
+    assert(broken.savePointReached(1));
+
+    Storage::setMockTimeMs(0);
+    cleanup();
+    cout << "✓ BGSAVE writes the keyspace as of the fork; save points and retry delay" << endl;
+}
+
+// Test: keys load into the shard that owns them
+void test_rdb_sharded_load() {
+    cleanup();
+    Storage one, two;
+    one.setMaxKeys(0);
+    two.setMaxKeys(0);
+    for (int i = 0; i < 3000; i++) (i % 2 ? one : two).set("key:" + to_string(i), to_string(i));
+    RDB rdb(TEST_RDB_FILE);
+    assert(rdb.save({&one, &two}, SnapshotInfo()));
+
+    Storage shards[3];
+    for (Storage& s : shards) s.setMaxKeys(0);
+    assert(rdb.load({&shards[0], &shards[1], &shards[2]}) == RDB::LoadStatus::Ok);
+    assert(shards[0].size() + shards[1].size() + shards[2].size() == 3000);
+    for (int i = 0; i < 3000; i++) {
+        string key = "key:" + to_string(i);
+        assert(shards[shardForKey(key, 3)].get(key).value() == to_string(i));
+    }
+
+    cleanup();
+    cout << "✓ Snapshot of 2 shards loads into 3 (each key on its owner)" << endl;
+}
+
+// Test: snapshot + the AOF written after it = the state at shutdown, with
+// no command applied twice
+void test_rdb_with_aof_tail() {
+    cleanup();
+    Storage storage;
+    uint64_t inode = 0, offset = 0;
+    {
+        AOF aof(TEST_AOF_FILE, "no");
+        RDB rdb(TEST_RDB_FILE);
+        aof.log({"SET", "counter", "10"});
+        aof.log({"INCR", "counter"});
+        aof.log({"SET", "a", "1"});
+        storage.set("counter", "11");
+        storage.set("a", "1");
+
+        SnapshotInfo info;
+        assert(aof.position(info.aofInode, info.aofOffset));
+        assert(info.aofOffset == readFile(TEST_AOF_FILE).size());
+        assert(rdb.save({&storage}, info));
+        inode = info.aofInode;
+        offset = info.aofOffset;
+
+        aof.log({"INCR", "counter"});
+        aof.log({"SET", "b", "2"});
+        aof.log({"DEL", "a"});
+    }
+
+    RDB rdb(TEST_RDB_FILE);
+    SnapshotInfo info;
+    assert(rdb.readInfo(info) == RDB::LoadStatus::Ok);
+    assert(info.aofInode == inode && info.aofOffset == offset);
+    Storage restored;
+    assert(rdb.load({&restored}) == RDB::LoadStatus::Ok);
+    AOF aof(TEST_AOF_FILE, "no");
+    assert(aof.replay(restored, info.aofOffset));
+    assert(restored.get("counter").value() == "12");  // 10, INCR in the snapshot, INCR in the tail
+    assert(restored.get("b").value() == "2");
+    assert(!restored.exists("a"));
+    assert(restored.size() == 2);
+
+    // Nothing after the snapshot: the replay is a no-op
+    Storage snapshotOnly;
+    assert(aof.replay(snapshotOnly, readFile(TEST_AOF_FILE).size()));
+    assert(snapshotOnly.size() == 0);
+
+    cleanup();
+    cout << "✓ Snapshot + AOF tail from its offset (INCR applied once)" << endl;
+}
+
+int main() {
+    cout << "\n=== RDB Snapshot Tests ===\n" << endl;
+
+    test_crc64();
+    test_rdb_round_trip();
+    test_rdb_corruption();
+    test_rdb_bgsave_and_save_points();
+    test_rdb_sharded_load();
+    test_rdb_with_aof_tail();
+
+    cout << "\n✅ All RDB tests passed!\n" << endl;
+    return 0;
+}
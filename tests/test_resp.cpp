@@ -1,8 +1,24 @@
 #include "resp_parser.h"
+#include "resp_encoder.h"
+#include "output_buffer.h"
+#include <climits>
 #include <cassert>
 #include <iostream>
+#include <random>
 using namespace std;
 
+typedef vector<string> Command;
+
+// Parse everything currently buffered
+static vector<Command> drain(RespParser& parser, ParseStatus& status) {
+    vector<Command> out;
+    vector<string_view> args;
+    while ((status = parser.next(args)) == ParseStatus::Ok) {
+        out.emplace_back(args.begin(), args.end());
+    }
+    return out;
+}
+
 void testSimpleString() {
     RespParser parser;
     string input = "+OK\r\n";
@@ -11,8 +27,220 @@ void testSimpleString() {
     assert(result.str_value == "OK");
 }
 
+// Test: decode() handles every type and rejects malformed/incomplete input
+void testDecodeValues() {
+    RespParser parser;
+    size_t used;
+    RespValue v = parser.decode("*3\r\n:-42\r\n$5\r\nhe\r\no\r\n*1\r\n-ERR x\r\n", &used);
+    assert(used == 33);
+    assert(v.type == RespType::Array && v.arr_value.size() == 3);
+    assert(v.arr_value[0].type == RespType::Integer && v.arr_value[0].int_value == -42);
+    assert(v.arr_value[1].str_value == "he\r\no");  // Binary safe
+    assert(v.arr_value[2].arr_value[0].type == RespType::Error);
+
+    for (const char* bad : {"", ":12a\r\n", ":\r\n", "$5\r\nhi\r\n", "$3\r\nabcde", "*2\r\n:1\r\n",
+                            "?x\r\n", "$99999999999999999999\r\n"}) {
+        parser.decode(bad, &used);
+        assert(used == 0);
+    }
+    cout << "✓ decode() handles all types, rejects malformed input" << endl;
+}
+
+// Test: A command split at every possible byte boundary parses identically
+void testSplitFrames() {
+    string wire = "*3\r\n$3\r\nSET\r\n$3\r\nkey\r\n$12\r\nhello\r\nworld\r\n";
+    for (size_t cut = 0; cut <= wire.size(); cut++) {
+        RespParser parser;
+        ParseStatus status;
+        parser.feed(wire.data(), cut);
+        vector<Command> first = drain(parser, status);
+        assert(status == ParseStatus::Incomplete);
+        assert(first.empty() == (cut < wire.size()));
+        parser.feed(wire.data() + cut, wire.size() - cut);
+        vector<Command> second = drain(parser, status);
+        vector<Command>& got = first.empty() ? second : first;
+        assert(got.size() == 1);
+        assert((got[0] == Command{"SET", "key", "hello\r\nworld"}));
+        assert(parser.bufferedBytes() == 0);
+    }
+    cout << "✓ Partial frames resume at every split point" << endl;
+}
+
+// Test: Argument views point into the parser's buffer (no copies)
+void testZeroCopyViews() {
+    RespParser parser;
+    parser.feed("*2\r\n$3\r\nGET\r\n$1\r\nk\r\n*1\r\n$4\r\nPING\r\n");
+    vector<string_view> a, b;
+    assert(parser.next(a) == ParseStatus::Ok);
+    const char* getPtr = a[0].data();
+    assert(parser.next(b) == ParseStatus::Ok);
+    assert(b[0] == "PING");
+    assert(b[0].data() > getPtr && b[0].data() - getPtr < 32);  // Same buffer
+    cout << "✓ Arguments are views into the input buffer" << endl;
+}
+
+// Test: An attached buffer (mmapped AOF) is parsed in place, and a torn
+// last frame leaves parsedBytes() at the end of the last whole one
+void testAttachedInput() {
+    string file = "*3\r\n$3\r\nSET\r\n$1\r\nk\r\n$1\r\nv\r\n*2\r\n$4\r\nINCR\r\n$1\r\nn\r\n*2\r\n$3\r\nDE";
+    RespParser parser;
+    parser.feed("*1\r\n$4\r\nPI");  // Replaced by the attached input
+    parser.attach(file);
+    vector<string_view> args;
+    assert(parser.next(args) == ParseStatus::Ok && args.size() == 3);
+    assert(args[2].data() == file.data() + 24 && parser.lastFrame().data() == file.data());
+    assert(parser.next(args) == ParseStatus::Ok && args[0] == "INCR");
+    assert(parser.next(args) == ParseStatus::Incomplete);
+    assert(parser.parsedBytes() == 48 && parser.bufferedBytes() == file.size() - 48);
+    cout << "✓ Attached input parsed in place, torn tail located" << endl;
+}
+
+// Test: Inline commands, empty multibulk and protocol errors
+void testInlineAndErrors() {
+    RespParser parser;
+    ParseStatus status;
+    parser.feed("PING\r\n\r\nSET  a\tb\n*0\r\n*1\r\n$4\r\nECHO\r\n");
+    vector<Command> got = drain(parser, status);
+    assert(status == ParseStatus::Incomplete);
+    assert(got.size() == 3);
+    assert((got[0] == Command{"PING"}));
+    assert((got[1] == Command{"SET", "a", "b"}));
+    assert((got[2] == Command{"ECHO"}));
+
+    for (const char* bad : {"*1\r\n:5\r\n", "*x\r\n", "*1\r\n$-3\r\n", "*1\r\n$3\r\nabcd\r\n",
+                            "*1\r\n$+3\r\nabc\r\n", "*99999999\r\n", "*1\r\n$600000000\r\n"}) {
+        RespParser p;
+        p.feed(bad);
+        vector<string_view> args;
+        assert(p.next(args) == ParseStatus::Error);
+        assert(p.error().find("Protocol error") == 0);
+        assert(p.next(args) == ParseStatus::Error);  // Stays failed
+    }
+
+    // Unterminated header lines are bounded
+    RespParser p;
+    p.feed(string(RespParser::MAX_INLINE_LEN + 1, 'x'));
+    vector<string_view> args;
+    assert(p.next(args) == ParseStatus::Error);
+    cout << "✓ Inline commands parse, malformed frames are rejected" << endl;
+}
+
+// Fuzz: random pipelined commands (binary args, CRLF inside values) fed in
+// random-sized chunks, including byte-by-byte, must parse back exactly
+void testFuzzPipelined() {
+    mt19937 rng(2024);
+    for (int round = 0; round < 200; round++) {
+        vector<Command> sent;
+        string wire;
+        int numCommands = 1 + rng() % 50;
+        for (int c = 0; c < numCommands; c++) {
+            Command cmd;
+            int argc = 1 + rng() % 6;
+            for (int a = 0; a < argc; a++) {
+                string arg(rng() % (rng() % 4 == 0 ? 300 : 12), '\0');
+                for (auto& ch : arg) ch = "ab\r\n$*:0\x00\xff"[rng() % 10];
+                cmd.push_back(arg);
+            }
+            sent.push_back(cmd);
+            wire += RESPEncoder::encodeArray(cmd);
+        }
+
+        RespParser parser;
+        vector<Command> received;
+        ParseStatus status = ParseStatus::Incomplete;
+        size_t maxChunk = round % 4 == 0 ? 1 : 1 + rng() % 64;
+        for (size_t at = 0; at < wire.size();) {
+            size_t n = min(wire.size() - at, 1 + (size_t)rng() % maxChunk);
+            parser.feed(wire.data() + at, n);
+            at += n;
+            for (auto& cmd : drain(parser, status)) received.push_back(cmd);
+            assert(status == ParseStatus::Incomplete);
+        }
+        assert(received == sent);
+        assert(parser.bufferedBytes() == 0);
+    }
+
+    // Mutated streams must fail cleanly or parse, never crash or overrun
+    for (int round = 0; round < 2000; round++) {
+        string wire = RESPEncoder::encodeArray({"SET", "key", "value"}) +
+                      RESPEncoder::encodeArray({"GET", "key"});
+        int flips = 1 + rng() % 3;
+        for (int f = 0; f < flips; f++) wire[rng() % wire.size()] = "*$\r\n-1:9x"[rng() % 9];
+        RespParser parser;
+        ParseStatus status;
+        for (char ch : wire) {
+            parser.feed(&ch, 1);
+            drain(parser, status);
+            if (status == ParseStatus::Error) break;
+        }
+    }
+    cout << "✓ Fuzzed pipelines parse exactly, corrupt input fails cleanly" << endl;
+}
+
+// Test: Line scanning agrees with a naive search, including CRs without LF
+void testLineScanning() {
+    mt19937 rng(99);
+    for (int round = 0; round < 20000; round++) {
+        string data(rng() % 300, 'x');
+        int newlines = rng() % 3;
+        for (int i = 0; i < newlines && !data.empty(); i++) data[rng() % data.size()] = "\n\r"[rng() % 2];
+        size_t from = data.empty() ? 0 : rng() % data.size();
+        const char* begin = data.data() + from;
+        const char* end = data.data() + data.size();
+        size_t lf = data.find('\n', from);
+        size_t crlf = data.find("\r\n", from);
+        assert(RespParser::findNewline(begin, end) == (lf == string::npos ? nullptr : data.data() + lf));
+        assert(RespParser::findCRLF(begin, end) == (crlf == string::npos ? nullptr : data.data() + crlf));
+    }
+
+    // Header lengths: fast digit path and the general path agree
+    for (const char* wire : {"*1\r\n$0\r\n\r\n", "*1\r\n$000000000000000000003\r\nabc\r\n",
+                             "*1\r\n$17\r\n01234567890123456\r\n"}) {
+        RespParser p;
+        p.feed(wire);
+        vector<string_view> args;
+        assert(p.next(args) == ParseStatus::Ok && args.size() == 1);
+    }
+    cout << "✓ Line scanning and length parsing agree with naive versions" << endl;
+}
+
+// Test: direct-to-buffer encoding matches the string encoders, and the
+// shared replies are what they claim to be
+void testReplyEncoding() {
+    for (int64_t n : {0LL, 1LL, 42LL, 9999LL, 10000LL, -1LL, LLONG_MAX, LLONG_MIN}) {
+        string out;
+        RESPEncoder::addInteger(out, n);
+        assert(out == ":" + to_string(n) + "\r\n");
+        out.clear();
+        RESPEncoder::addBulkInteger(out, n);
+        assert(out == RESPEncoder::encodeBulkString(to_string(n)));
+    }
+    assert(SharedReplies::integer(7) == ":7\r\n");
+    assert(SharedReplies::OK == RESPEncoder::encodeSimpleString("OK"));
+    assert(SharedReplies::NULL_BULK == RESPEncoder::encodeNull());
+
+    OutputBuffer buf;
+    RESPEncoder::addShared(buf, SharedReplies::PONG);
+    RESPEncoder::addBulkString(buf, string(100000, 'x'));  // Spans chunks
+    RESPEncoder::addArrayHeader(buf, 2);
+    RESPEncoder::addError(buf, "ERR no");
+    assert(buf.take() == "+PONG\r\n" + RESPEncoder::encodeBulkString(string(100000, 'x')) + "*2\r\n-ERR no\r\n");
+    assert(buf.empty());
+    cout << "✓ Reply encoding into buffers and shared replies" << endl;
+}
+
 int main() {
+    cout << "\n=== RESP Parser Tests ===\n" << endl;
+
     testSimpleString();
-    cout << "All tests passed!" << endl;
+    testDecodeValues();
+    testSplitFrames();
+    testZeroCopyViews();
+    testAttachedInput();
+    testInlineAndErrors();
+    testLineScanning();
+    testReplyEncoding();
+
+    cout << "\n✅ All RESP parser tests passed!\n" << endl;
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,263 @@
+// Sharded Server Tests
+// Starts ./server_async --shards 4 (in a scratch directory, so its AOF
+// doesn't touch the repo) and checks the cross-shard paths end to end:
+// forwarded commands answered in order, multi-key DEL split and summed,
+// and replies for a client that went away never reaching another one
+//
+// Usage: ./tests/test_sharded_server [server]   (default: ./server_async)
+
+#include "shard.h"
+#include "resp_encoder.h"
+#include <cassert>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <set>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <climits>
+#include <cstdlib>
+#include <sys/socket.h>
+#include <sys/prctl.h>
+#include <sys/wait.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+using namespace std;
+
+const int SHARDS = 4;
+
+static int connectTo(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(fd, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    return fd;
+}
+
+// A port nothing listens on right now
+static int freePort() {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    assert(bind(fd, (sockaddr*)&addr, sizeof(addr)) == 0);
+    socklen_t len = sizeof(addr);
+    getsockname(fd, (sockaddr*)&addr, &len);
+    close(fd);
+    return ntohs(addr.sin_port);
+}
+
+static void sendAll(int fd, const string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        ssize_t n = write(fd, data.data() + sent, data.size() - sent);
+        assert(n > 0);
+        sent += n;
+    }
+}
+
+// Read exactly n bytes (fewer if the connection closes or stalls for 5s)
+static string readBytes(int fd, size_t n) {
+    string got;
+    char buf[65536];
+    while (got.size() < n) {
+        pollfd pfd = {fd, POLLIN, 0};
+        if (poll(&pfd, 1, 5000) != 1) break;
+        ssize_t r = read(fd, buf, min(sizeof(buf), n - got.size()));
+        if (r <= 0) break;
+        got.append(buf, r);
+    }
+    return got;
+}
+
+// Nothing more arrives within ms
+static bool quietFor(int fd, int ms) {
+    pollfd pfd = {fd, POLLIN, 0};
+    return poll(&pfd, 1, ms) == 0;
+}
+
+// Send a pipeline and check the replies, byte for byte
+static void expectReplies(int fd, const string& request, const string& expected) {
+    sendAll(fd, request);
+    string got = readBytes(fd, expected.size());
+    if (got != expected) cerr << "expected:\n" << expected << "\ngot:\n" << got << endl;
+    assert(got == expected);
+    assert(quietFor(fd, 50));
+}
+
+// Keys named prefix + i, at least per of them owned by each shard
+static vector<string> keysOnEveryShard(const string& prefix, int per) {
+    vector<string> keys;
+    vector<int> owned(SHARDS);
+    for (int i = 0; *min_element(owned.begin(), owned.end()) < per; i++) {
+        string key = prefix + to_string(i);
+        int s = shardForKey(key, SHARDS);
+        if (owned[s] >= per) continue;
+        owned[s]++;
+        keys.push_back(key);
+    }
+    return keys;
+}
+
+// Test: a pipeline mixing keys of every shard is answered in command order;
+// a DEL over several shards (missing keys, a repeated key) sums its counts
+void testOrderedReplies(int port) {
+    int fd = connectTo(port);
+    assert(fd >= 0);
+    vector<string> keys = keysOnEveryShard("key:", 8);  // 32 keys, shards interleaved
+
+    string request, expected;
+    for (size_t i = 0; i < keys.size(); i++) {
+        request += RESPEncoder::encodeArray({"SET", keys[i], "value:" + to_string(i)});
+        expected += "+OK\r\n";
+        size_t j = i * 7 % keys.size();  // Set already, or not yet
+        request += RESPEncoder::encodeArray({"GET", keys[j]});
+        expected += j <= i ? RESPEncoder::encodeBulkString("value:" + to_string(j)) : "$-1\r\n";
+        if (i % 4 == 0) {
+            request += RESPEncoder::encodeArray({"INCR", keys[(i + 1) % keys.size()] + ":n"});
+            expected += ":1\r\n";
+        }
+    }
+    request += RESPEncoder::encodeArray({"PING"});
+    expected += "+PONG\r\n";
+    expectReplies(fd, request, expected);
+
+    // DEL of two keys per shard, with missing keys and a key repeated
+    vector<string> delArgs = {"DEL"};
+    vector<bool> deleted(keys.size());
+    vector<int> taken(SHARDS);
+    for (size_t i = 0; i < keys.size(); i++) {
+        int owner = shardForKey(keys[i], SHARDS);
+        if (taken[owner] == 2) continue;
+        taken[owner]++;
+        deleted[i] = true;
+        delArgs.push_back(keys[i]);
+        if (delArgs.size() == 4) delArgs.push_back("nosuch:a");
+    }
+    delArgs.push_back(keys[0]);
+    delArgs.push_back("nosuch:b");
+    request = RESPEncoder::encodeArray(delArgs);
+    expected = ":" + to_string(2 * SHARDS) + "\r\n";
+    size_t kept = find(deleted.begin(), deleted.end(), false) - deleted.begin();
+    request += RESPEncoder::encodeArray({"GET", keys[0]}) + RESPEncoder::encodeArray({"GET", keys[kept]});
+    expected += "$-1\r\n" + RESPEncoder::encodeBulkString("value:" + to_string(kept));
+    request += RESPEncoder::encodeArray({"DEL", "nosuch:a", "nosuch:b", "nosuch:c", "nosuch:d"});
+    expected += ":0\r\n";
+    request += RESPEncoder::encodeArray({"DEL", keys[kept]}) + RESPEncoder::encodeArray({"DEL", keys[kept]});
+    expected += ":1\r\n:0\r\n";
+    deleted[kept] = true;
+    expectReplies(fd, request, expected);
+
+    // The same, a command at a time (each waits for its forwarded reply)
+    for (size_t i = 0; i < keys.size(); i++) {
+        expectReplies(fd, RESPEncoder::encodeArray({"GET", keys[i]}),
+                      deleted[i] ? "$-1\r\n" : RESPEncoder::encodeBulkString("value:" + to_string(i)));
+    }
+    close(fd);
+    cout << "✓ Commands over " << SHARDS << " shards answered in order; DEL across shards summed" << endl;
+}
+
+// Test: a client that disconnects with forwarded commands in flight. Their
+// replies are dropped, never written to whoever gets its fd next
+void testClosedClientReplies(int port) {
+    vector<string> bigKeys = keysOnEveryShard("big:", 1);
+    string big(64 * 1024, 'x');
+    int fd = connectTo(port);
+    string request, expected;
+    for (const string& key : bigKeys) {
+        request += RESPEncoder::encodeArray({"SET", key, big});
+        expected += "+OK\r\n";
+    }
+    request += RESPEncoder::encodeArray({"SET", "check", "mine"});
+    expected += "+OK\r\n";
+    expectReplies(fd, request, expected);
+    close(fd);
+
+    string flood;
+    for (int i = 0; i < 400; i++) flood += RESPEncoder::encodeArray({"GET", bigKeys[i % bigKeys.size()]});
+    string check = RESPEncoder::encodeArray({"PING"}) + RESPEncoder::encodeArray({"GET", "check"});
+    string checkReply = "+PONG\r\n" + RESPEncoder::encodeBulkString("mine");
+
+    for (int round = 0; round < 40; round++) {
+        int gone = connectTo(port);
+        assert(gone >= 0);
+        sendAll(gone, flood);
+        if (round % 2) {
+            linger reset = {1, 0};  // Close with RST: the server's next read fails
+            setsockopt(gone, SOL_SOCKET, SO_LINGER, &reset, sizeof(reset));
+        }
+        close(gone);
+
+        // Likely handed the same fd on the shard that accepts it
+        int next = connectTo(port);
+        assert(next >= 0);
+        expectReplies(next, check, checkReply);
+        close(next);
+    }
+    cout << "✓ Replies for a closed client dropped (40 clients reusing its fd got only their own)" << endl;
+}
+
+int main(int argc, char* argv[]) {
+    cout << "\n=== Sharded Server Tests ===\n" << endl;
+    signal(SIGPIPE, SIG_IGN);
+
+    char serverPath[PATH_MAX];
+    if (!realpath(argc > 1 ? argv[1] : "./server_async", serverPath)) {
+        cerr << "server_async not found (run from the repo root, or pass its path)" << endl;
+        return 1;
+    }
+    char dir[] = "/tmp/test_sharded_serverXXXXXX";
+    assert(mkdtemp(dir));
+    int port = freePort();
+    string portArg = to_string(port);
+    string shardsArg = to_string(SHARDS);
+    pid_t pid = fork();
+    if (pid == 0) {
+        prctl(PR_SET_PDEATHSIG, SIGKILL);  // A failed assert doesn't leave it running
+        if (chdir(dir) != 0) _exit(1);
+        int devnull = open("/dev/null", O_WRONLY);
+        dup2(devnull, STDOUT_FILENO);
+        execl(serverPath, serverPath, "--port", portArg.c_str(), "--shards", shardsArg.c_str(), "--save", "",
+              (char*)nullptr);
+        _exit(127);
+    }
+    bool up = false;
+    for (int i = 0; i < 100 && !up; i++) {
+        int fd = connectTo(port);
+        if (fd >= 0) {
+            close(fd);
+            up = true;
+        } else {
+            this_thread::sleep_for(chrono::milliseconds(50));
+        }
+    }
+    assert(up);
+
+    testOrderedReplies(port);
+    testClosedClientReplies(port);
+
+    assert(waitpid(pid, nullptr, WNOHANG) == 0);  // Still running
+    kill(pid, SIGTERM);
+    int status;
+    waitpid(pid, &status, 0);
+    assert(WIFEXITED(status) && WEXITSTATUS(status) == 0);
+    string aofFile = string(dir) + "/appendonly.aof";
+    unlink(aofFile.c_str());
+    rmdir(dir);
+
+    cout << "\n✅ All sharded server tests passed!\n" << endl;
+    return 0;
+}
@@ -137,6 +137,49 @@ void test_type_encoding() {
     cout << "✓ Type encoding detection works (INT/EMBSTR/RAW)" << endl;
 }
 
+// Test: Compact values round-trip exactly in every encoding
+void test_compact_values() {
+    Storage storage;
+    assert(sizeof(StoredValue) == 16);
+    
+    // Only canonical integers become INT; the rest must keep their bytes
+    for (const char* v : {"0", "-42", "9223372036854775807", "-9223372036854775808",
+                           "007", "+1", "-0", "9223372036854775808", " 1"}) {
+        storage.set("k", v);
+        assert(storage.get("k").value() == v);
+    }
+    storage.set("k", "-42");
+    assert(storage.getPtr("k")->encoding() == OBJ_ENCODING_INT);
+    assert(storage.getPtr("k")->intValue() == -42);
+    storage.set("k", "007");
+    assert(storage.getPtr("k")->encoding() == OBJ_ENCODING_EMBSTR);
+    
+    // EMBSTR up to 11 bytes inline, RAW from 12
+    storage.set("k", string(11, 'e'));
+    assert(storage.getPtr("k")->encoding() == OBJ_ENCODING_EMBSTR);
+    assert(storage.get("k").value() == string(11, 'e'));
+    storage.set("k", string(12, 'r'));
+    assert(storage.getPtr("k")->encoding() == OBJ_ENCODING_RAW);
+    assert(storage.get("k").value() == string(12, 'r'));
+    storage.set("k", string("a\0b", 3));  // Binary safe
+    assert(storage.get("k").value() == string("a\0b", 3));
+    
+    // Expiry only lives in the expires index, flagged on the value
+    storage.set("k", "v");
+    assert(!storage.getPtr("k")->hasExpire() && storage.getTTL("k") == -1);
+    storage.expire("k", 100);
+    assert(storage.getPtr("k")->hasExpire() && storage.getTTL("k") > 0);
+    storage.set("k", "v2");
+    assert(!storage.getPtr("k")->hasExpire() && storage.expiresCount() == 0);
+    
+    // Long keys spill to the heap and stay reachable
+    string longKey(100, 'k');
+    storage.set(longKey, "v");
+    assert(storage.get(longKey).value() == "v");
+    
+    cout << "✓ Compact values round-trip (INT/EMBSTR/RAW, expiry flag)" << endl;
+}
+
 // Test: LRU eviction when maxKeys reached
 void test_lru_eviction() {
     Storage storage;
@@ -192,6 +235,7 @@ int main() {
     test_expire_existing();
     test_expire_missing();
     test_type_encoding();
+    test_compact_values();
     test_lru_eviction();
     test_size_tracking();
     
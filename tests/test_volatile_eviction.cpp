@@ -0,0 +1,163 @@
+#include "../include/storage.h"
+#include <iostream>
+#include <cassert>
+#include <string>
+
+using namespace std;
+
+void testExpiresIndex() {
+    cout << "\n=== Testing Expires Index Bookkeeping ===" << endl;
+
+    Storage store;
+    store.setMaxKeys(0);
+
+    store.setWithExpiry("a", "v", 60000);
+    store.setWithExpiry("b", "v", 60000);
+    store.set("c", "v");
+    assert(store.expiresCount() == 2);
+
+    store.expire("c", 60);            // Gains a TTL
+    assert(store.expiresCount() == 3);
+
+    store.set("a", "v");              // Plain SET clears the TTL
+    assert(store.expiresCount() == 2);
+    assert(store.getTTL("a") == -1);
+
+    store.del("b");                   // Delete removes index entry
+    assert(store.expiresCount() == 1);
+
+    store.setWithExpiry("d", "v", 1); // Lazy expiry removes index entry
+    Storage::setMockTimeMs(Storage::getCurrentTimeMs() + 10);
+    assert(!store.get("d").has_value());
+    Storage::setMockTimeMs(0);
+    assert(store.expiresCount() == 1);
+
+    cout << "   ✓ expires count follows SET/EXPIRE/DEL/lazy expiry" << endl;
+}
+
+void testActiveExpireUsesIndex() {
+    cout << "\n=== Testing Active Expiration via Index ===" << endl;
+
+    Storage store;
+    store.setMaxKeys(0);
+
+    // Many persistent keys would previously hide the TTL keys from sampling
+    for (int i = 0; i < 10000; i++) store.set("persistent:" + to_string(i), "v");
+    for (int i = 0; i < 100; i++) store.setWithExpiry("ttl:" + to_string(i), "v", 1);
+
+    Storage::setMockTimeMs(Storage::getCurrentTimeMs() + 10);
+    store.deleteExpiredKeys();
+    Storage::setMockTimeMs(0);
+
+    assert(store.expiresCount() == 0);
+    assert(store.size() == 10000);
+
+    cout << "   ✓ All expired keys reclaimed, persistent keys untouched" << endl;
+}
+
+void testVolatileTTL() {
+    cout << "\n=== Testing volatile-ttl ===" << endl;
+
+    Storage store;
+    store.setEvictionPolicy("volatile-ttl");
+    store.setMaxKeys(4);
+
+    store.set("persistent", "v");
+    store.setWithExpiry("soon", "v", 10000);
+    store.setWithExpiry("later", "v", 20000);
+    store.setWithExpiry("latest", "v", 30000);
+
+    store.set("new", "v");
+
+    assert(!store.exists("soon") && "shortest TTL should be evicted");
+    assert(store.exists("persistent"));
+    assert(store.exists("later"));
+    assert(store.exists("latest"));
+
+    cout << "   ✓ Key closest to expiring was evicted" << endl;
+}
+
+void testVolatileLRU() {
+    cout << "\n=== Testing volatile-lru ===" << endl;
+
+    Storage store;
+    store.setEvictionPolicy("volatile-lru");
+    store.setMaxKeys(4);
+
+    int64_t clock = Storage::getCurrentTimeMs();  // LRU clock ticks once a second
+    Storage::setMockTimeMs(clock += LRU_CLOCK_RESOLUTION_MS);
+    store.set("persistent", "v");               // Oldest, but has no TTL
+    Storage::setMockTimeMs(clock += LRU_CLOCK_RESOLUTION_MS);
+    store.setWithExpiry("old", "v", 60000);
+    Storage::setMockTimeMs(clock += LRU_CLOCK_RESOLUTION_MS);
+    store.setWithExpiry("mid", "v", 60000);
+    Storage::setMockTimeMs(clock += LRU_CLOCK_RESOLUTION_MS);
+    store.setWithExpiry("recent", "v", 60000);
+    Storage::setMockTimeMs(clock += LRU_CLOCK_RESOLUTION_MS);
+    store.set("new", "v");
+    Storage::setMockTimeMs(0);
+
+    assert(store.exists("persistent") && "keys without TTL are never candidates");
+    assert(!store.exists("old") && "LRU key among TTL keys should be evicted");
+    assert(store.exists("mid"));
+    assert(store.exists("recent"));
+
+    cout << "   ✓ LRU victim chosen among keys with TTL only" << endl;
+}
+
+void testVolatileRandom() {
+    cout << "\n=== Testing volatile-random ===" << endl;
+
+    Storage store;
+    store.setEvictionPolicy("volatile-random");
+    store.setMaxKeys(100);
+
+    for (int i = 0; i < 50; i++) store.set("persistent:" + to_string(i), "v");
+    for (int i = 0; i < 50; i++) store.setWithExpiry("ttl:" + to_string(i), "v", 60000);
+
+    for (int i = 0; i < 40; i++) store.set("new:" + to_string(i), "v");
+
+    for (int i = 0; i < 50; i++) assert(store.exists("persistent:" + to_string(i)));
+    assert(store.expiresCount() == 10);
+    assert(store.size() == 100);
+
+    cout << "   ✓ Only keys with TTL were evicted" << endl;
+}
+
+void testVolatileWithoutCandidates() {
+    cout << "\n=== Testing volatile-* with no TTL keys ===" << endl;
+
+    Storage store;
+    store.setEvictionPolicy("volatile-lru");
+    store.setMaxKeys(3);
+
+    for (int i = 0; i < 5; i++) store.set("key" + to_string(i), "v");
+    assert(store.size() == 5);  // Nothing evictable: writes proceed past the limit
+    assert(store.getEvictedKeys() == 0);
+
+    cout << "   ✓ No eviction when no key has a TTL" << endl;
+}
+
+int main() {
+    cout << "╔═══════════════════════════════════════╗" << endl;
+    cout << "║  Volatile Eviction - Expires Index   ║" << endl;
+    cout << "╚═══════════════════════════════════════╝" << endl;
+
+    try {
+        testExpiresIndex();
+        testActiveExpireUsesIndex();
+        testVolatileTTL();
+        testVolatileLRU();
+        testVolatileRandom();
+        testVolatileWithoutCandidates();
+
+        cout << "\n╔═══════════════════════════════════════╗" << endl;
+        cout << "║ All Volatile Eviction Tests Passed! ✓║" << endl;
+        cout << "╚═══════════════════════════════════════╝" << endl;
+
+        return 0;
+    } catch (const exception& e) {
+        cerr << "\n✗ Test failed: " << e.what() << endl;
+        return 1;
+    }
+}